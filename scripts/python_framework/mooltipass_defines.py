@@ -48,6 +48,7 @@ CMD_ID_GET_DIAG_DATA		= 0x002D
 CMD_ID_GET_DEVICE_INT_SN	= 0x0038
 CMD_ID_SET_DEVICE_INT_SN	= 0x003A
 CMD_ID_PREPARE_SN_FLASH		= 0x003D
+CMD_ID_GET_PROFILING_DATA	= 0x003F
 
 # New Debug Command IDs
 CMD_DBG_MESSAGE					= 0x8000
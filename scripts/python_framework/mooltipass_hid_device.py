@@ -299,6 +299,22 @@ class mooltipass_hid_device:
 		print("Total ms with screen on: " + str(total_nb_ms_screen_on))	
 		print("Total 30mins battery powered: " + str(total_nb_30mins_bat_on))
 		print("Total 30mins USB powered: " + str(total_nb_30mins_usb_on))
+		if len(packet["data"]) >= 24:
+			print("Node read cache hits: " + str(struct.unpack('I', packet["data"][16:20])[0]))
+			print("Node read cache misses: " + str(struct.unpack('I', packet["data"][20:24])[0]))
+
+	# Print profiling counters, optionally resetting them
+	def printProfilingData(self, reset):
+		counter_names = ["dbflash read", "dbflash write", "dataflash read", "AES CTR", "ECC sign", "OLED flush", "aux MCU TX", "aux MCU RX wait"]
+		packet = self.device.sendHidMessageWaitForAck(self.getPacketForCommand(CMD_ID_GET_PROFILING_DATA, [1 if reset else 0]))
+		cycles_per_second = struct.unpack('I', packet["data"][0:4])[0]
+		nb_counters = struct.unpack('H', packet["data"][4:6])[0]
+		for i in range(0, nb_counters):
+			nb_calls, nb_cycles_msb, nb_cycles_lsb = struct.unpack('III', packet["data"][8+i*12:20+i*12])
+			nb_cycles = (nb_cycles_msb << 32) + nb_cycles_lsb
+			name = counter_names[i] if i < len(counter_names) else "counter " + str(i)
+			avg_us = (nb_cycles * 1000000 / cycles_per_second / nb_calls) if nb_calls > 0 else 0
+			print(name + ": " + str(nb_calls) + " calls, " + str(nb_cycles * 1000 // cycles_per_second) + "ms total, " + "{:.1f}".format(avg_us) + "us avg")
 
 	# Send bundle to display
 	def uploadDebugBundle(self, filename):	
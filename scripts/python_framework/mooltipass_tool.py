@@ -170,6 +170,7 @@ def main():
 				device_default_settings[24] = 0		# SETTINGS_BLUETOOTH_SHORTCUTS
 				device_default_settings[25] = 0		# SETTINGS_SCREEN_SAVER_ID
 				device_default_settings[26] = 1		 # SETTINGS_PREF_ST_SERV_FEATURE
+				device_default_settings[27] = 0		# SETTINGS_FAST_TYPING
 				mooltipass_device.device.sendHidMessageWaitForAck(mooltipass_device.getPacketForCommand(0x0D, device_default_settings), True)
 
 				# Reset default language
@@ -188,6 +189,9 @@ def main():
 		elif sys.argv[1] == "printDiagData":
 			mooltipass_device.printDiagData()
 
+		elif sys.argv[1] == "printProfilingData":
+			mooltipass_device.printProfilingData(len(sys.argv) > 2 and sys.argv[2] == "reset")
+
 		elif sys.argv[1] == "switchOffAfterDisconnect":
 			mooltipass_device.device.sendHidMessageWaitForAck(mooltipass_device.getPacketForCommand(0x0039, None), True)
 
@@ -148,8 +148,15 @@ void comms_main_mcu_send_message(volatile aux_mcu_message_t* message, uint16_t m
     /* Wait for no comms release */
     while (platform_io_is_no_comms_asserted() == RETURN_OK);
     
-    /* The function below does wait for a previous transfer to finish and does check for no comms */
-    dma_main_mcu_init_tx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)message, sizeof(aux_mcu_message_t));    
+    /* The functions below do wait for a previous transfer to finish and do check for no comms */
+    if (dma_main_mcu_are_compact_frames_enabled() != FALSE)
+    {
+        dma_main_mcu_init_compact_tx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (aux_mcu_message_t*)message);
+    }
+    else
+    {
+        dma_main_mcu_init_tx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)message, sizeof(aux_mcu_message_t));
+    }
 }
 
 /*! \fn     comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message)
@@ -267,61 +274,38 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
     {
         BOOL typing_success_bool = TRUE;
         
-        /* This command may take a while... let's use our other buffer to prevent corruptions */
-        memcpy((void*)&comms_main_mcu_message_for_main_replies, message, sizeof(comms_main_mcu_message_for_main_replies));
+        /* Get interface & typing mode */
+        uint16_t interface_identifier = message->keyboard_type_message.interface_identifier;
+        BOOL fast_typing = ((interface_identifier & KEYBOARD_TYPE_FAST_TYPING_FLAG) != 0)?TRUE:FALSE;
+        BOOL queue_symbols = ((interface_identifier & KEYBOARD_TYPE_QUEUE_FLAG) != 0)?TRUE:FALSE;
+        interface_identifier &= ~(KEYBOARD_TYPE_FAST_TYPING_FLAG|KEYBOARD_TYPE_QUEUE_FLAG);
         
-        /* Iterate over symbols */
-        uint16_t counter = 0;
-        while(comms_main_mcu_message_for_main_replies.keyboard_type_message.keyboard_symbols[counter] != 0)
+        /* Queued typing: symbols are copied, typing is done from our main loop */
+        if (queue_symbols != FALSE)
         {
-            uint16_t symbol = comms_main_mcu_message_for_main_replies.keyboard_type_message.keyboard_symbols[counter];
-            
-            if (symbol == 0xFFFF)
-            {
-                /* Original unicode point can't be typed */
-            }            
-            else if ((symbol & 0x7F00) == 0)
-            {
-                BOOL is_dead_key = FALSE;
-                
-                /* Check for dead key */
-                if ((symbol & 0x8000) != 0)
-                {
-                    is_dead_key = TRUE;
-                }                    
-                
-                /* One key to be typed */
-                if (logic_keyboard_type_symbol((hid_interface_te)comms_main_mcu_message_for_main_replies.keyboard_type_message.interface_identifier, (uint8_t)symbol, is_dead_key, comms_main_mcu_message_for_main_replies.keyboard_type_message.delay_between_types) != RETURN_OK)
-                {
-                    typing_success_bool = FALSE;
-                    break;
-                }
-            }
-            else
+            logic_keyboard_queue_typing_job((hid_interface_te)interface_identifier, (uint16_t*)message->keyboard_type_message.keyboard_symbols, message->keyboard_type_message.delay_between_types, fast_typing);
+        }
+        else
+        {
+            /* This command may take a while... let's use our other buffer to prevent corruptions */
+            memcpy((void*)&comms_main_mcu_message_for_main_replies, message, sizeof(comms_main_mcu_message_for_main_replies));
+        
+            /* Previously queued symbols are typed first */
+            logic_keyboard_flush_typing_queue();
+        
+            /* Type symbols */
+            if (logic_keyboard_type_symbols((hid_interface_te)interface_identifier, (uint16_t*)comms_main_mcu_message_for_main_replies.keyboard_type_message.keyboard_symbols, comms_main_mcu_message_for_main_replies.keyboard_type_message.delay_between_types, fast_typing) != RETURN_OK)
             {
-                /* Two keys to be typed */
-                if (logic_keyboard_type_symbol((hid_interface_te)comms_main_mcu_message_for_main_replies.keyboard_type_message.interface_identifier, (uint8_t)(symbol >> 8), FALSE, comms_main_mcu_message_for_main_replies.keyboard_type_message.delay_between_types) != RETURN_OK)
-                {
-                    typing_success_bool = FALSE;
-                    break;
-                }
-                if (logic_keyboard_type_symbol((hid_interface_te)comms_main_mcu_message_for_main_replies.keyboard_type_message.interface_identifier, (uint8_t)symbol, FALSE, comms_main_mcu_message_for_main_replies.keyboard_type_message.delay_between_types) != RETURN_OK)
-                {
-                    typing_success_bool = FALSE;
-                    break;
-                }
+                typing_success_bool = FALSE;
             }
             
-            /* Move on to the next symbol */
-            counter++;
+            /* Send success status */
+            memset((void*)&comms_main_mcu_message_for_main_replies, 0x00, sizeof(comms_main_mcu_message_for_main_replies));
+            comms_main_mcu_message_for_main_replies.message_type = AUX_MCU_MSG_TYPE_KEYBOARD_TYPE;
+            comms_main_mcu_message_for_main_replies.payload_as_uint16[0] = (uint16_t)typing_success_bool;
+            comms_main_mcu_message_for_main_replies.payload_length1 = sizeof(uint16_t);
+            comms_main_mcu_send_message((void*)&comms_main_mcu_message_for_main_replies, (uint16_t)sizeof(comms_main_mcu_message_for_main_replies));
         }
-            
-        /* Send success status */
-        memset((void*)&comms_main_mcu_message_for_main_replies, 0x00, sizeof(comms_main_mcu_message_for_main_replies));
-        comms_main_mcu_message_for_main_replies.message_type = AUX_MCU_MSG_TYPE_KEYBOARD_TYPE;
-        comms_main_mcu_message_for_main_replies.payload_as_uint16[0] = (uint16_t)typing_success_bool;
-        comms_main_mcu_message_for_main_replies.payload_length1 = sizeof(uint16_t);
-        comms_main_mcu_send_message((void*)&comms_main_mcu_message_for_main_replies, (uint16_t)sizeof(comms_main_mcu_message_for_main_replies));
     }
     else if (message->message_type == AUX_MCU_MSG_TYPE_BLE_CMD)
     {
@@ -377,6 +361,9 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
                 /* Wait for interrupt to clear this flag if set (wait for full packet receive) */
                 while (comms_main_mcu_other_msg_answered_using_first_bytes != FALSE);   
                 
+                /* Queued symbols would otherwise be typed after wakeup, wherever the focus is */
+                logic_keyboard_discard_typing_queue();
+                
                 /* Send ACK */
                 comms_main_mcu_send_simple_event_alt_buffer(AUX_MCU_EVENT_SLEEP_RECEIVED, (aux_mcu_message_t*)&comms_main_mcu_message_for_main_replies);
                 dma_wait_for_main_mcu_packet_sent();
@@ -425,6 +412,9 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
             }
             case MAIN_MCU_COMMAND_DETACH_USB:
             {
+                /* Don't keep symbols for a later connection */
+                logic_keyboard_discard_typing_queue();
+                
                 /* Detach USB resistors */
                 comms_usb_clear_enumerated();
                 udc_detach();
@@ -441,6 +431,9 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
             }
             case MAIN_MCU_COMMAND_DISABLE_BLE:
             {
+                /* Don't keep symbols for a later connection */
+                logic_keyboard_discard_typing_queue();
+                
                 /* Enable BLE */
                 if (logic_is_ble_enabled() != FALSE)
                 {
@@ -448,6 +441,13 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
                 }
                 break;
             }
+            case MAIN_MCU_COMMAND_COMPACT_FRAMES:
+            {
+                /* Answer using a full frame, then switch: main MCU won't send anything until it gets our answer */
+                comms_main_mcu_send_simple_event_alt_buffer(AUX_MCU_EVENT_COMPACT_FRAMES_ON, (aux_mcu_message_t*)&comms_main_mcu_message_for_main_replies);
+                dma_main_mcu_set_compact_frames_enabled(TRUE);
+                break;
+            }
             case MAIN_MCU_COMMAND_NIMH_CHG_SLW_STRT:
             {
                 /* Charge NiMH battery */
@@ -713,6 +713,33 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
                 
                 break;          
             }
+            case MAIN_MCU_COMMAND_DISCARD_TYPING:
+            {
+                logic_keyboard_discard_typing_queue();
+                break;
+            }
+            case MAIN_MCU_COMMAND_HID_MSG_SYNC:
+            {
+                /* HID messages received before this command must be sent before we answer: main MCU waits for our answer to send the next one */
+                if (dma_main_mcu_usb_msg_received != FALSE)
+                {
+                    dma_main_mcu_usb_msg_received = FALSE;
+                    if (comms_main_mcu_usb_msg_answered_using_first_bytes == FALSE)
+                    {
+                        comms_raw_hid_send_hid_message(USB_INTERFACE, (aux_mcu_message_t*)&dma_main_mcu_usb_rcv_message);
+                    }
+                }
+                if (dma_main_mcu_ble_msg_received != FALSE)
+                {
+                    dma_main_mcu_ble_msg_received = FALSE;
+                    if (comms_main_mcu_ble_msg_answered_using_first_bytes == FALSE)
+                    {
+                        comms_raw_hid_send_hid_message(BLE_INTERFACE, (aux_mcu_message_t*)&dma_main_mcu_ble_rcv_message);
+                    }
+                }
+                comms_main_mcu_send_simple_event_alt_buffer(AUX_MCU_EVENT_HID_MSG_SYNCED, (aux_mcu_message_t*)&comms_main_mcu_message_for_main_replies);
+                break;
+            }
             case MAIN_MCU_COMMAND_UPDT_DEV_STAT:
             {
                 /* Update device status buffer */
@@ -724,6 +751,10 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
             {
                 uint8_t interface_id = message->main_mcu_command_message.payload[0];
                 uint8_t shortcut = message->main_mcu_command_message.payload[1];
+                uint8_t l_symbol = (uint8_t)(message->main_mcu_command_message.payload_as_uint16[1]);
+                
+                /* Previously queued symbols are typed first */
+                logic_keyboard_flush_typing_queue();
                 
                 /* Depending on shortcut */
                 if ((shortcut & LF_ENT_KEY_MASK) != 0)
@@ -736,7 +767,7 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
                 }
                 else if ((shortcut & LF_WIN_L_SEND_MASK) != 0)
                 {
-                    logic_keyboard_type_lock_shortcut((hid_interface_te)interface_id, (uint8_t)(message->main_mcu_command_message.payload_as_uint16[1]));
+                    logic_keyboard_type_lock_shortcut((hid_interface_te)interface_id, l_symbol);
                 }
                 comms_main_mcu_send_simple_event_alt_buffer(AUX_MCU_EVENT_SHORTCUT_TYPED, (aux_mcu_message_t*)&comms_main_mcu_message_for_main_replies);
                 break;
@@ -821,6 +852,12 @@ ret_type_te comms_main_mcu_routine(BOOL wait_for_blectrl_fido2_rng, uint16_t exp
         }
     }
     
+    /* Compact frames: report lost frames */
+    if (dma_main_mcu_get_and_clear_compact_frame_lost() != FALSE)
+    {
+        comms_main_mcu_invalid_message_received_from_main = TRUE;
+    }
+    
     /* Second: see if we could deal with a packet in advance */
     /* Ongoing RX transfer received bytes */
     uint16_t nb_received_bytes_for_ongoing_transfer = sizeof(dma_main_mcu_temp_rcv_message) - dma_main_mcu_get_remaining_bytes_for_rx_transfer();
@@ -392,6 +392,31 @@ void comms_raw_hid_connection_set_callback(hid_interface_te hid_interface)
     comms_raw_hid_packet_being_sent[hid_interface] = FALSE;
 } 
 
+/*! \fn     comms_raw_hid_handle_ctap_packet(void)
+*   \brief  Handle the CTAP packet we received
+*   \note   Packet receive is re-armed before handling, as a CBOR request may take seconds to be answered
+*/
+static void comms_raw_hid_handle_ctap_packet(void)
+{
+    hid_packet_t ctap_packet;
+    
+    memcpy(&ctap_packet, &raw_hid_recv_buffer[CTAP_INTERFACE], sizeof(ctap_packet));
+    comms_raw_hid_arm_packet_receive(CTAP_INTERFACE);
+    ctaphid_handle_packet(ctap_packet.raw_packet_uint32);
+}
+
+/*! \fn     comms_raw_hid_ctap_routine(void)
+*   \brief  Handle CTAP packets received while a CBOR request is being processed
+*/
+void comms_raw_hid_ctap_routine(void)
+{
+    if (comms_raw_hid_packet_received[CTAP_INTERFACE] != FALSE)
+    {
+        comms_raw_hid_packet_received[CTAP_INTERFACE] = FALSE;
+        comms_raw_hid_handle_ctap_packet();
+    }
+}
+
 /*! \fn     comms_usb_communication_routine(void)
 *   \brief  Function called to deal with comms
 *   \return What happened
@@ -454,8 +479,7 @@ comms_usb_ret_te comms_usb_communication_routine(void)
 
             if (hid_interface == CTAP_INTERFACE)
             {
-                ctaphid_handle_packet(raw_hid_recv_buffer[hid_interface].raw_packet_uint32);
-                comms_raw_hid_arm_packet_receive(hid_interface);
+                comms_raw_hid_handle_ctap_packet();
                 return ret_val;
             }
             
@@ -56,6 +56,7 @@ uint8_t* comms_raw_hid_get_protocol(uint8_t interface);
 comms_usb_ret_te comms_usb_communication_routine(void);
 void comms_usb_debug_printf(const char *fmt, ...);
 void comms_usb_clear_enumerated(void);
+void comms_raw_hid_ctap_routine(void);
 BOOL comms_usb_is_enumerated(void);
 
 
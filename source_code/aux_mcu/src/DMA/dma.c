@@ -4,6 +4,7 @@
 *    Author:   Mathieu Stephan
 */
 #include <string.h>
+#include <stddef.h>
 #ifndef BOOTLOADER
     #include <asf.h>
     #include "driver_timer.h"
@@ -39,6 +40,144 @@ volatile BOOL dma_main_mcu_other_msg_received = FALSE;
 volatile BOOL dma_main_mcu_fido_blectrl_rng_msg_received = FALSE;
 /* Pointer to message being sent to main MCU */
 void* dma_pt_to_message_being_sent_to_main_mcu;
+#ifndef BOOTLOADER
+/* Boolean set when compact frames were negotiated with the main MCU */
+volatile BOOL dma_main_mcu_compact_frames_enabled = FALSE;
+/* Compact frames: set when we lost sync, full frames are then sent until the main MCU does the same */
+volatile BOOL dma_main_mcu_compact_frames_desync = FALSE;
+/* Compact frames: set when a frame was lost, to be reported by the comms layer */
+volatile BOOL dma_main_mcu_compact_frame_lost = FALSE;
+/* Compact frames: reception stage and length of the second part */
+volatile dma_main_rx_stage_te dma_main_mcu_rx_stage = DMA_MAIN_RX_STAGE_FULL;
+volatile uint16_t dma_main_mcu_rx_second_part_length;
+/* Compact frames: descriptor linked to the header one, receiving the rest of the frame */
+DmacDescriptor dma_main_mcu_rx_second_part_descriptor __attribute__ ((aligned (16)));
+/* Compact frames: message being sent, its payload_length1 flag & magic are cleared once sent */
+aux_mcu_message_t* volatile dma_main_mcu_tx_message_pt = 0;
+#endif
+
+/* The compact frame header is decoded on its own */
+_Static_assert(AUX_MCU_MSG_HEADER_LENGTH == offsetof(aux_mcu_message_t, payload), "Invalid aux MCU message header length");
+_Static_assert((AUX_MCU_MSG_PAYLOAD_LENGTH & AUX_MCU_MSG_COMPACT_FRAME_MASK) == 0, "Payload length overlaps compact frame flag & magic");
+
+#ifndef BOOTLOADER
+/*! \fn     dma_main_mcu_arm_rx_descriptor(void* datap, uint16_t size, DmacDescriptor* next_descriptor)
+*   \brief  Setup and enable the main MCU RX DMA channel
+*   \param  datap           Pointer to where to store the data
+*   \param  size            Number of bytes for transfer
+*   \param  next_descriptor Descriptor to link to this transfer, or 0
+*   \note   We are not disabling IRQs as this is called from an IRQ
+*   \note   Errata 15683 doesn't apply to linked descriptors on the RX comms channel, as it is channel 0
+*/
+static void dma_main_mcu_arm_rx_descriptor(void* datap, uint16_t size, DmacDescriptor* next_descriptor)
+{
+    /* Setup transfer size */
+    dma_descriptors[DMA_DESCID_RX_COMMS].BTCNT.bit.BTCNT = (uint16_t)size;
+    /* Source address: DATA register from SPI */
+    dma_descriptors[DMA_DESCID_RX_COMMS].DSTADDR.reg = (uint32_t)datap + size;
+    /* Destination address: given value */
+    dma_descriptors[DMA_DESCID_RX_COMMS].SRCADDR.reg = (uint32_t)((void*)&AUXMCU_SERCOM->USART.DATA.reg);
+    /* Next descriptor */
+    dma_descriptors[DMA_DESCID_RX_COMMS].DESCADDR.reg = (uint32_t)next_descriptor;
+    /* Write-back descriptor is only updated once the channel runs */
+    dma_writeback_descriptors[DMA_DESCID_RX_COMMS].BTCNT.reg = (uint16_t)size;
+    
+    /* Resume DMA channel operation */
+    DMAC->CHID.reg= DMAC_CHID_ID(DMA_DESCID_RX_COMMS);
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+}
+
+/*! \fn     dma_main_mcu_arm_rx_compact_frame(void)
+*   \brief  Arm reception of a compact or full frame: header, then the rest of a full frame through a linked descriptor
+*   \note   We are not disabling IRQs as this is called from an IRQ
+*/
+static void dma_main_mcu_arm_rx_compact_frame(void)
+{
+    /* Second part: same setup as the header descriptor, generates an interrupt once done */
+    dma_main_mcu_rx_second_part_descriptor.BTCTRL.reg = dma_descriptors[DMA_DESCID_RX_COMMS].BTCTRL.reg;
+    dma_main_mcu_rx_second_part_descriptor.BTCNT.bit.BTCNT = sizeof(aux_mcu_message_t) - AUX_MCU_MSG_HEADER_LENGTH;
+    dma_main_mcu_rx_second_part_descriptor.DSTADDR.reg = (uint32_t)(&dma_main_mcu_temp_rcv_message) + sizeof(dma_main_mcu_temp_rcv_message);
+    dma_main_mcu_rx_second_part_descriptor.SRCADDR.reg = (uint32_t)((void*)&AUXMCU_SERCOM->USART.DATA.reg);
+    dma_main_mcu_rx_second_part_descriptor.DESCADDR.reg = 0;
+    
+    /* Header: interrupt once received, the channel then carries on with the second part descriptor */
+    dma_main_mcu_rx_stage = DMA_MAIN_RX_STAGE_HEADER;
+    dma_main_mcu_arm_rx_descriptor((void*)&dma_main_mcu_temp_rcv_message, AUX_MCU_MSG_HEADER_LENGTH, &dma_main_mcu_rx_second_part_descriptor);
+}
+
+/*! \fn     dma_main_mcu_end_rx_header(void)
+*   \brief  Frame header received: shorten the reception to the frame length
+*   \return TRUE if the frame was already completely received
+*   \note   Called from the DMA interrupt. The linked descriptor receives the frame until the channel is stopped,
+*           so bytes aren't lost whatever the interrupt latency
+*   \note   A flagged header without a valid magic & length means we lost sync: the rest is received as a full frame
+*/
+static BOOL dma_main_mcu_end_rx_header(void)
+{
+    uint16_t payload_length = dma_main_mcu_temp_rcv_message.payload_length1 & ~AUX_MCU_MSG_COMPACT_FRAME_MASK;
+    
+    if (((dma_main_mcu_temp_rcv_message.payload_length1 & AUX_MCU_MSG_COMPACT_FRAME_MASK) == (AUX_MCU_MSG_COMPACT_FRAME_FLAG | AUX_MCU_MSG_COMPACT_FRAME_MAGIC)) && (payload_length != 0) && (payload_length <= AUX_MCU_MSG_PAYLOAD_LENGTH))
+    {
+        /* Compact frame: stop the channel, incoming bytes are buffered by the USART meanwhile */
+        DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_RX_COMMS);
+        DMAC->CHCTRLA.reg = 0;
+        while(DMAC->CHCTRLA.reg != 0);
+        
+        /* Number of payload bytes already received: write-back descriptor is either the header or the second part one */
+        uint16_t nb_payload_bytes_received = (uint16_t)(dma_writeback_descriptors[DMA_DESCID_RX_COMMS].DSTADDR.reg - dma_writeback_descriptors[DMA_DESCID_RX_COMMS].BTCNT.reg - (uint32_t)dma_main_mcu_temp_rcv_message.payload);
+        dma_main_mcu_temp_rcv_message.payload_length1 = payload_length;
+        dma_main_mcu_rx_second_part_length = payload_length;
+        dma_main_mcu_rx_stage = DMA_MAIN_RX_STAGE_SECOND_PART;
+        
+        if (nb_payload_bytes_received < payload_length)
+        {
+            /* Receive the remaining payload bytes only */
+            dma_main_mcu_arm_rx_descriptor((void*)&dma_main_mcu_temp_rcv_message.payload[nb_payload_bytes_received], payload_length - nb_payload_bytes_received, 0);
+            return FALSE;
+        }
+        else if (nb_payload_bytes_received > payload_length)
+        {
+            /* Start of the next frame was received as well: it is lost */
+            dma_main_mcu_compact_frames_desync = TRUE;
+            dma_main_mcu_compact_frame_lost = TRUE;
+        }
+        return TRUE;
+    }
+    else
+    {
+        /* Corrupted compact frame header: send full frames from now on */
+        if ((dma_main_mcu_temp_rcv_message.payload_length1 & AUX_MCU_MSG_COMPACT_FRAME_FLAG) != 0)
+        {
+            dma_main_mcu_compact_frames_desync = TRUE;
+            dma_main_mcu_compact_frame_lost = TRUE;
+        }
+        
+        /* Full frame (flood, invalid or empty payload length...): the second part descriptor receives it */
+        dma_main_mcu_rx_second_part_length = sizeof(aux_mcu_message_t) - AUX_MCU_MSG_HEADER_LENGTH;
+        dma_main_mcu_rx_stage = DMA_MAIN_RX_STAGE_SECOND_PART;
+        return FALSE;
+    }
+}
+
+/*! \fn     dma_main_mcu_end_rx_second_part(void)
+*   \brief  Compact frame completely received: clear the non transferred bytes
+*   \note   A full frame with a valid non flagged payload length means the main MCU isn't using compact frames anymore (reboot)
+*/
+static void dma_main_mcu_end_rx_second_part(void)
+{
+    uint16_t nb_bytes_received = AUX_MCU_MSG_HEADER_LENGTH + dma_main_mcu_rx_second_part_length;
+    
+    if (nb_bytes_received < sizeof(aux_mcu_message_t))
+    {
+        memset((void*)((uint8_t*)&dma_main_mcu_temp_rcv_message + nb_bytes_received), 0, sizeof(aux_mcu_message_t) - nb_bytes_received);
+    }
+    else if ((dma_main_mcu_temp_rcv_message.payload_length1 != 0) && (dma_main_mcu_temp_rcv_message.payload_length1 <= AUX_MCU_MSG_PAYLOAD_LENGTH))
+    {
+        dma_main_mcu_compact_frames_enabled = FALSE;
+        dma_main_mcu_compact_frames_desync = FALSE;
+    }
+}
+#endif
 
 /*! \fn     DMAC_Handler(void)
 *   \brief  Function called by interrupt when RX is done
@@ -47,8 +186,30 @@ void DMAC_Handler(void)
 {
     /* MAIN MCU RX routine */
     DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_RX_COMMS);
+    BOOL frame_received = FALSE;
     if ((DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL) != 0)
     {
+        frame_received = TRUE;
+        
+        #ifndef BOOTLOADER
+        /* Frame header received: the reception carries on, shorten it for compact frames */
+        if (dma_main_mcu_rx_stage == DMA_MAIN_RX_STAGE_HEADER)
+        {
+            DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+            frame_received = dma_main_mcu_end_rx_header();
+        }
+        #endif
+    }
+    if (frame_received != FALSE)
+    {
+        #ifndef BOOTLOADER
+        /* Compact frame: clear what wasn't transferred */
+        if (dma_main_mcu_rx_stage == DMA_MAIN_RX_STAGE_SECOND_PART)
+        {
+            dma_main_mcu_end_rx_second_part();
+        }
+        #endif
+        
         /* Set transfer done boolean, clear interrupt */
         dma_aux_mcu_packet_received = TRUE;
         DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
@@ -120,6 +281,15 @@ void DMAC_Handler(void)
     DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_TX_COMMS);
     if ((DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL) != 0)
     {
+        #ifndef BOOTLOADER
+        /* Compact frame sent: restore the message payload length */
+        if (dma_main_mcu_tx_message_pt != 0)
+        {
+            dma_main_mcu_tx_message_pt->payload_length1 &= ~AUX_MCU_MSG_COMPACT_FRAME_MASK;
+            dma_main_mcu_tx_message_pt = 0;
+        }
+        #endif
+        
         /* Set transfer done boolean, clear interrupt */
         dma_main_mcu_packet_sent = TRUE;
         DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
@@ -215,16 +385,32 @@ void dma_init(void)
 */
 uint16_t dma_main_mcu_get_remaining_bytes_for_rx_transfer(void)
 {
+    uint16_t nb_remaining_bytes;
+    
     /* Check for active channel */
     DMAC_ACTIVE_Type active_reg_copy = DMAC->ACTIVE;
     if (active_reg_copy.bit.ID == DMA_DESCID_RX_COMMS && active_reg_copy.bit.ABUSY != 0)
     {
-        return active_reg_copy.bit.BTCNT;
+        nb_remaining_bytes = active_reg_copy.bit.BTCNT;
     }
     else
     {
-        return dma_writeback_descriptors[DMA_DESCID_RX_COMMS].BTCNT.reg;
+        nb_remaining_bytes = dma_writeback_descriptors[DMA_DESCID_RX_COMMS].BTCNT.reg;
+    }
+    
+    #ifndef BOOTLOADER
+    /* Compact frames: express the remaining bytes as if a full message was being received, header not decoded yet: nothing usable */
+    if (dma_main_mcu_rx_stage == DMA_MAIN_RX_STAGE_HEADER)
+    {
+        nb_remaining_bytes = sizeof(aux_mcu_message_t);
+    }
+    else if (dma_main_mcu_rx_stage == DMA_MAIN_RX_STAGE_SECOND_PART)
+    {
+        nb_remaining_bytes += sizeof(aux_mcu_message_t) - AUX_MCU_MSG_HEADER_LENGTH - dma_main_mcu_rx_second_part_length;
     }
+    #endif
+    
+    return nb_remaining_bytes;
 }
 
 /*! \fn     dma_main_mcu_check_and_clear_dma_transfer_flag(void)
@@ -280,6 +466,91 @@ void dma_main_mcu_init_tx_transfer(void* spi_data_p, void* datap, uint16_t size)
     __enable_irq();
 }
 
+#ifndef BOOTLOADER
+/*! \fn     dma_main_mcu_init_compact_tx_transfer(void* spi_data_p, aux_mcu_message_t* message)
+*   \brief  Send a message to the main MCU using a compact frame: header, then payload_length1 payload bytes, in a single transfer
+*   \param  spi_data_p  Pointer to the SPI data register
+*   \param  message     Pointer to the message
+*   \note   The compact frame flag & magic are set in the message payload_length1 until the transfer is done
+*   \note   Messages with an empty or invalid payload length are sent as a full frame, with a non flagged header
+*/
+void dma_main_mcu_init_compact_tx_transfer(void* spi_data_p, aux_mcu_message_t* message)
+{
+    /* Wait for previous transfer to be done, as its message payload length gets restored then */
+    while (dma_main_mcu_packet_sent == FALSE);
+    
+    if ((message->payload_length1 != 0) && (message->payload_length1 <= AUX_MCU_MSG_PAYLOAD_LENGTH))
+    {
+        uint16_t frame_length = AUX_MCU_MSG_HEADER_LENGTH + message->payload_length1;
+        
+        /* Flag header, send header & payload */
+        message->payload_length1 |= AUX_MCU_MSG_COMPACT_FRAME_FLAG | AUX_MCU_MSG_COMPACT_FRAME_MAGIC;
+        dma_main_mcu_tx_message_pt = message;
+        dma_main_mcu_init_tx_transfer(spi_data_p, (void*)message, frame_length);
+    }
+    else
+    {
+        dma_main_mcu_init_tx_transfer(spi_data_p, (void*)message, sizeof(aux_mcu_message_t));
+    }
+}
+
+/*! \fn     dma_main_mcu_set_compact_frames_enabled(BOOL enabled)
+*   \brief  Enable or disable compact frames for main MCU comms
+*   \param  enabled     TRUE to enable
+*   \note   Reception is re-armed right away: to be called when the main MCU isn't sending anything
+*/
+void dma_main_mcu_set_compact_frames_enabled(BOOL enabled)
+{
+    /* Disable IRQs */
+    __disable_irq();
+    __DMB();
+    
+    /* Stop DMA RX channel operation */
+    DMAC->CHID.reg= DMAC_CHID_ID(DMA_DESCID_RX_COMMS);
+    DMAC->CHCTRLA.reg = 0;
+    
+    /* Wait for bit clear */
+    while(DMAC->CHCTRLA.reg != 0);
+    
+    /* Set flag & re-arm reception */
+    dma_main_mcu_compact_frames_desync = FALSE;
+    dma_main_mcu_compact_frames_enabled = enabled;
+    dma_main_mcu_init_rx_transfer();
+    
+    /* Re-enable IRQs */
+    __DMB();
+    __enable_irq();
+}
+
+/*! \fn     dma_main_mcu_are_compact_frames_enabled(void)
+*   \brief  Know if compact frames are used to send messages to the main MCU
+*   \return TRUE if compact frames are in use
+*   \note   After a sync loss we keep accepting compact frames but send full frames, so the main MCU switches back to full frames
+*/
+BOOL dma_main_mcu_are_compact_frames_enabled(void)
+{
+    if ((dma_main_mcu_compact_frames_enabled != FALSE) && (dma_main_mcu_compact_frames_desync == FALSE))
+    {
+        return TRUE;
+    }
+    else
+    {
+        return FALSE;
+    }
+}
+
+/*! \fn     dma_main_mcu_get_and_clear_compact_frame_lost(void)
+*   \brief  Know if a compact frame was lost (corrupted header, next frame start received with the previous one)
+*   \return TRUE if a frame was lost since the last call
+*/
+BOOL dma_main_mcu_get_and_clear_compact_frame_lost(void)
+{
+    BOOL return_val = dma_main_mcu_compact_frame_lost;
+    dma_main_mcu_compact_frame_lost = FALSE;
+    return return_val;
+}
+#endif
+
 /*! \fn     dma_get_pointer_to_message_being_sent_to_main_mcu(void)
 *   \brief  Get pointer to the message currently being sent to main MCU
 */
@@ -325,6 +596,17 @@ void dma_main_mcu_disable_transfer(void)
 */
 void dma_main_mcu_init_rx_transfer(void)
 {
+    #ifndef BOOTLOADER
+    /* Compact frames: the DMA interrupt decodes the header while the rest of the frame is received */
+    if (dma_main_mcu_compact_frames_enabled != FALSE)
+    {
+        dma_main_mcu_arm_rx_compact_frame();
+        return;
+    }
+    dma_main_mcu_rx_stage = DMA_MAIN_RX_STAGE_FULL;
+    dma_descriptors[DMA_DESCID_RX_COMMS].DESCADDR.reg = 0;
+    #endif
+    
     /* Setup transfer size */
     dma_descriptors[DMA_DESCID_RX_COMMS].BTCNT.bit.BTCNT = (uint16_t)sizeof(dma_main_mcu_temp_rcv_message);
     /* Source address: DATA register from SPI */
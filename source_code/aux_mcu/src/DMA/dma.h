@@ -13,6 +13,9 @@
 #include "comms_main_mcu.h"
 #include "defines.h"
 
+/* Enums */
+typedef enum {DMA_MAIN_RX_STAGE_FULL = 0, DMA_MAIN_RX_STAGE_HEADER, DMA_MAIN_RX_STAGE_SECOND_PART} dma_main_rx_stage_te;
+
 /* Global vars */
 extern volatile aux_mcu_message_t dma_main_mcu_fido_blectrl_rng_message;
 extern volatile aux_mcu_message_t dma_main_mcu_temp_rcv_message;
@@ -26,6 +29,10 @@ extern volatile BOOL dma_main_mcu_ble_msg_received;
 
 /* Prototypes */
 void dma_main_mcu_init_tx_transfer(void* spi_data_p, void* datap, uint16_t size);
+void dma_main_mcu_init_compact_tx_transfer(void* spi_data_p, aux_mcu_message_t* message);
+void dma_main_mcu_set_compact_frames_enabled(BOOL enabled);
+BOOL dma_main_mcu_are_compact_frames_enabled(void);
+BOOL dma_main_mcu_get_and_clear_compact_frame_lost(void);
 uint16_t dma_main_mcu_get_remaining_bytes_for_rx_transfer(void);
 void* dma_get_pointer_to_message_being_sent_to_main_mcu(void);
 BOOL dma_main_mcu_check_and_clear_dma_transfer_flag(void);
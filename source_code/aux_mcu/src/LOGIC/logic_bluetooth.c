@@ -11,6 +11,7 @@
 #include "device_info.h"
 #include "ble_manager.h"
 #include "platform_io.h"
+#include "logic_keyboard.h"
 #include "logic_sleep.h"
 #include "at_ble_api.h"
 #include "logic_rng.h"
@@ -1825,32 +1826,30 @@ void logic_bluetooth_raw_send(uint8_t* data, uint16_t data_len)
 *   \return If we were able to correctly type
 */
 ret_type_te logic_bluetooth_send_modifier_and_key(uint8_t modifier, uint8_t key, uint8_t second_key)
+{
+    uint8_t keys[LOGIC_BLUETOOTH_NB_KEYS_IN_REPORT] = {key, second_key, 0, 0, 0, 0};
+    return logic_bluetooth_send_keyboard_report(modifier, keys);
+}
+
+/*! \fn     logic_bluetooth_send_keyboard_report(uint8_t modifier, uint8_t* keys)
+*   \brief  Send a complete keyboard report through keyboard link
+*   \param  modifier    HID modifier
+*   \param  keys        Array of LOGIC_BLUETOOTH_NB_KEYS_IN_REPORT HID keys
+*   \return If we were able to correctly type (report confirmed by the host)
+*/
+ret_type_te logic_bluetooth_send_keyboard_report(uint8_t modifier, uint8_t* keys)
 {
     if (logic_bluetooth_can_communicate_with_host != FALSE)
     {
-        if (TRUE)
-        {
-            logic_bluetooth_check_and_wait_for_notif_sent();
-            logic_bluetooth_notif_being_sent = KEYBOARD_NOTIF_SENDING;
-            logic_bluetooth_keyboard_in_report[0] = modifier;
-            logic_bluetooth_keyboard_in_report[2] = key;
-            logic_bluetooth_keyboard_in_report[3] = second_key;
-            logic_bluetooth_typed_report_sent = FALSE;
-            logic_bluetooth_update_report(logic_bluetooth_ble_connection_handle, BLE_KEYBOARD_HID_SERVICE_INSTANCE, BLE_KEYBOARD_HID_IN_REPORT_NB, logic_bluetooth_keyboard_in_report, sizeof(logic_bluetooth_keyboard_in_report), TRUE);
-        } 
-        else
-        {
-            logic_bluetooth_check_and_wait_for_notif_sent();
-            logic_bluetooth_notif_being_sent = KEYBOARD_NOTIF_SENDING;
-            logic_bluetooth_boot_keyb_in_report[0] = modifier;
-            logic_bluetooth_boot_keyb_in_report[2] = key;
-            logic_bluetooth_boot_keyb_in_report[3] = second_key;
-            logic_bluetooth_typed_report_sent = FALSE;
-            logic_bluetooth_update_report(logic_bluetooth_ble_connection_handle, BLE_KEYBOARD_HID_SERVICE_INSTANCE, BLE_KEYBOARD_HID_IN_REPORT_NB, logic_bluetooth_boot_keyb_in_report, sizeof(logic_bluetooth_boot_keyb_in_report), FALSE);
-        }
+        logic_bluetooth_check_and_wait_for_notif_sent();
+        logic_bluetooth_notif_being_sent = KEYBOARD_NOTIF_SENDING;
+        logic_bluetooth_keyboard_in_report[0] = modifier;
+        memcpy(&logic_bluetooth_keyboard_in_report[2], keys, LOGIC_BLUETOOTH_NB_KEYS_IN_REPORT);
+        logic_bluetooth_typed_report_sent = FALSE;
+        logic_bluetooth_update_report(logic_bluetooth_ble_connection_handle, BLE_KEYBOARD_HID_SERVICE_INSTANCE, BLE_KEYBOARD_HID_IN_REPORT_NB, logic_bluetooth_keyboard_in_report, sizeof(logic_bluetooth_keyboard_in_report), TRUE);
         
         /* OK I'm still not sure about this one... but I think it should be OK. Stack trace is main > comms_main_mcu_routine > comms_main_mcu_deal_with_non_usb_non_ble_message > logic_keyboard_type_symbol > logic_keyboard_type_key_with_modifier to here */
-        timer_start_timer(TIMER_BT_TYPING_TIMEOUT, 1000);
+        timer_start_timer(TIMER_BT_TYPING_TIMEOUT, LOGIC_KEYBOARD_REPORT_FETCH_TIMEOUT);
         while ((timer_has_timer_expired(TIMER_BT_TYPING_TIMEOUT, FALSE) == TIMER_RUNNING) && (logic_bluetooth_typed_report_sent == FALSE))
         {
             ble_event_task();
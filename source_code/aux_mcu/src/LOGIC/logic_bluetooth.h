@@ -25,6 +25,7 @@ typedef enum    {NONE_NOTIF_SENDING = 0, KEYBOARD_NOTIF_SENDING, RAW_HID_NOTIF_S
 #define BLE_RAW_HID_OUT_REPORT_NB           4
 #define BLE_TOTAL_NUMBER_OF_REPORTS         3
 #define BLE_MAX_REPORTS_FOR_GIVEN_SVC       2
+#define LOGIC_BLUETOOTH_NB_KEYS_IN_REPORT   6
 #define HID_MAX_SERV_INST				    2
 #define HID_MAX_CHARACTERISTIC              9
 
@@ -276,6 +277,7 @@ void logic_bluetooth_update_report(uint16_t conn_handle, uint8_t serv_inst, uint
 void logic_bluetooth_boot_key_report_update(at_ble_handle_t conn_handle, uint8_t serv_inst, uint8_t* bootreport, uint16_t len);
 void logic_bluetooth_successfull_pairing_call(ble_connected_dev_info_t* dev_info, at_ble_connected_t* connected_info);
 ret_type_te logic_bluetooth_send_modifier_and_key(uint8_t modifier, uint8_t key, uint8_t second_key);
+ret_type_te logic_bluetooth_send_keyboard_report(uint8_t modifier, uint8_t* keys);
 uint8_t logic_bluetooth_get_report_characteristic(uint16_t handle, uint8_t serv, uint8_t reportid);
 uint8_t logic_bluetooth_get_notif_instance(uint8_t serv_num, uint16_t char_handle);
 void logic_bluetooth_gpio_set(at_ble_gpio_pin_t pin, at_ble_gpio_status_t status);
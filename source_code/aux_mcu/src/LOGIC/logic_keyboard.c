@@ -8,11 +8,27 @@
 #include "platform_defines.h"
 #include "logic_bluetooth.h"
 #include "logic_keyboard.h"
+#include "comms_main_mcu.h"
 #include "driver_timer.h"
 #include "usb.h"
 #include "udc.h"
 /* Buffer containing the keys to be sent through USB */
 uint8_t logic_keyboard_usb_hid_keys_buffer[8];
+/* Same number of keys in USB & BLE reports */
+_Static_assert(LOGIC_KEYBOARD_NB_KEYS_IN_REPORT == LOGIC_BLUETOOTH_NB_KEYS_IN_REPORT, "Different number of keys in USB and BLE reports");
+/* Typing jobs queued by the main MCU, typed from our main loop */
+logic_keyboard_typing_job_t logic_keyboard_typing_queue[LOGIC_KEYBOARD_TYPING_QUEUE_LENGTH];
+uint16_t logic_keyboard_typing_queue_read_index = 0;
+uint16_t logic_keyboard_typing_queue_nb_jobs = 0;
+/* 0 terminated symbols of the queued jobs, stored one after the other until the queue is empty */
+uint16_t logic_keyboard_typing_symbols_pool[LOGIC_KEYBOARD_TYPING_POOL_SYMBOLS];
+uint16_t logic_keyboard_typing_symbols_pool_write_index = 0;
+/* Next symbol to be typed in the current job */
+uint16_t* logic_keyboard_typing_queue_symbol_pt = 0;
+/* Cleared if one of the queued jobs couldn't be fully typed */
+BOOL logic_keyboard_typing_queue_all_typed = TRUE;
+/* An empty queue can store all the symbols of a keyboard type message */
+_Static_assert(LOGIC_KEYBOARD_TYPING_POOL_SYMBOLS >= MEMBER_ARRAY_SIZE(keyboard_type_message_t, keyboard_symbols)+1, "Typing queue can't store a full message");
 
 
 /*! \fn     logic_keyboard_type_lock_shortcut(hid_interface_te interface_id, uint8_t l_symbol)
@@ -117,6 +133,45 @@ ret_type_te logic_keyboard_type_key_with_modifier(hid_interface_te interface, ui
     return RETURN_OK; 
 }
 
+/*! \fn     logic_keyboard_get_key_and_modifier_for_symbol(uint8_t symbol, uint8_t* key)
+*   \brief  Decode an encoded symbol into a HID key and modifier
+*   \param  symbol              The symbol
+*   \param  key                 Where to store the HID key
+*   \return The HID modifier
+*/
+static uint8_t logic_keyboard_get_key_and_modifier_for_symbol(uint8_t symbol, uint8_t* key)
+{
+    uint8_t masked_key = symbol & (SHIFT_MASK|ALTGR_MASK);
+    uint8_t modifier = 0;
+    
+    if (masked_key == (SHIFT_MASK|ALTGR_MASK))
+    {
+        modifier = KEY_SHIFT|KEY_RIGHT_ALT;
+    }
+    else if (masked_key == SHIFT_MASK)
+    {
+        // If we need shift
+        modifier = KEY_SHIFT;
+    }
+    else if (masked_key == ALTGR_MASK)
+    {
+        // We need altgr for the numbered keys, only possible because we don't use the numerical keypad
+        modifier = KEY_RIGHT_ALT;
+    }
+    
+    if ((symbol & 0x3F) == KEY_EUROPE_2)
+    {
+        // Because of a redefine of KEY_EUROPE_2 for storage purposes we need to do that
+        *key = KEY_EUROPE_2_REAL;
+    }
+    else
+    {
+        *key = symbol & ~(SHIFT_MASK|ALTGR_MASK);
+    }
+    
+    return modifier;
+}
+
 /*! \fn     logic_keyboard_type_symbol(hid_interface_te interface, uint8_t symbol, BOOL is_dead_key, uint16_t delay_between_types)
 *   \brief  Type an encoded symbol through a given interface
 *   \param  interface           HID interface on which to type the symbol
@@ -127,54 +182,357 @@ ret_type_te logic_keyboard_type_key_with_modifier(hid_interface_te interface, ui
 */
 ret_type_te logic_keyboard_type_symbol(hid_interface_te interface, uint8_t symbol, BOOL is_dead_key, uint16_t delay_between_types)
 {
-    uint8_t masked_key = symbol & (SHIFT_MASK|ALTGR_MASK);
     ret_type_te return_val;
+    uint8_t key;
+    
+    // Send the key with the correct modifier
+    uint8_t modifier = logic_keyboard_get_key_and_modifier_for_symbol(symbol, &key);
+    return_val = logic_keyboard_type_key_with_modifier(interface, key, modifier, delay_between_types);
+    
+    /* Add space if typed character is a dead key */
+    if ((is_dead_key != FALSE) && (return_val == RETURN_OK))
+    {
+        return_val = logic_keyboard_type_key_with_modifier(interface, KEY_SPACE, 0, delay_between_types);        
+    }
+    
+    return return_val;
+}
+
+/*! \fn     logic_keyboard_send_report_and_wait(hid_interface_te interface, uint8_t modifier, uint8_t* keys, uint16_t delay_between_types)
+*   \brief  Send a keyboard report, wait for the host to fetch it then for the remainder of the delay between types
+*   \param  interface           HID interface on which to send the report
+*   \param  modifier            Modifier (alt, shift...)
+*   \param  keys                Array of LOGIC_KEYBOARD_NB_KEYS_IN_REPORT keys
+*   \param  delay_between_types Minimum delay between reports in ms
+*   \return If the report was fetched by the host
+*   \note   The time taken by the host to fetch the report (USB polling, BLE notification confirmation) is deducted from the delay
+*   \note   Both interfaces give up after LOGIC_KEYBOARD_REPORT_FETCH_TIMEOUT
+*/
+static ret_type_te logic_keyboard_send_report_and_wait(hid_interface_te interface, uint8_t modifier, uint8_t* keys, uint16_t delay_between_types)
+{
+    uint32_t report_send_systick = timer_get_systick();
+    uint32_t nb_ms_spent;
+    
+    if (interface == USB_INTERFACE)
+    {
+        logic_keyboard_usb_hid_keys_buffer[0] = modifier;
+        memcpy(&logic_keyboard_usb_hid_keys_buffer[2], keys, LOGIC_KEYBOARD_NB_KEYS_IN_REPORT);
+        usb_send(USB_KEYBOARD_ENDPOINT, (uint8_t*)logic_keyboard_usb_hid_keys_buffer, sizeof(logic_keyboard_usb_hid_keys_buffer));
         
-    if ((symbol & 0x3F) == KEY_EUROPE_2)
+        /* Wait for the host to fetch the report */
+        timer_start_timer(TIMER_USB_SEND_TIMEOUT, LOGIC_KEYBOARD_REPORT_FETCH_TIMEOUT);
+        while (udc_is_send_pending(USB_KEYBOARD_ENDPOINT) != FALSE)
+        {
+            if ((usb_get_config() == 0) || (timer_has_timer_expired(TIMER_USB_SEND_TIMEOUT, TRUE) == TIMER_EXPIRED))
+            {
+                return RETURN_NOK;
+            }
+        }
+    }
+    else
     {
-        // Because of a redefine of KEY_EUROPE_2 for storage purposes we need to do that
-        uint8_t mod_tbs = 0;
-            
-        if (masked_key == (SHIFT_MASK|ALTGR_MASK))
+        /* Returns once the notification is confirmed */
+        if (logic_bluetooth_send_keyboard_report(modifier, keys) != RETURN_OK)
+        {
+            return RETURN_NOK;
+        }
+    }
+    
+    /* Only wait for what is left of the delay */
+    nb_ms_spent = timer_get_systick() - report_send_systick;
+    if (nb_ms_spent < delay_between_types)
+    {
+        timer_delay_ms(delay_between_types - nb_ms_spent);
+    }
+    
+    return RETURN_OK;
+}
+
+/*! \fn     logic_keyboard_is_symbol_packable(uint16_t symbol)
+*   \brief  Know if a symbol can be typed as part of a multi-key report
+*   \param  symbol              The symbol as sent by the main MCU
+*   \return TRUE if the symbol is typed with a single key press
+*/
+static BOOL logic_keyboard_is_symbol_packable(uint16_t symbol)
+{
+    /* Non typable points, dead keys and two keys symbols keep the standard typing */
+    if ((symbol == 0) || (symbol == 0xFFFF) || ((symbol & 0xFF00) != 0))
+    {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*! \fn     logic_keyboard_type_packed_symbols(hid_interface_te interface, uint16_t** symbols_pt, uint16_t delay_between_types)
+*   \brief  Type consecutive distinct keys sharing a modifier using the same reports
+*   \param  interface           HID interface on which to type the symbols
+*   \param  symbols_pt          Pointer to the pointer to the first symbol, updated to the first symbol not typed
+*   \param  delay_between_types Minimum delay between reports in ms
+*   \return If we were able to type the symbols
+*   \note   Keys are added one report at a time (rollover) so the host sees them pressed in order, then released together:
+*           a group of n keys takes n+1 reports (+1 for the modifier) instead of 3n
+*   \note   Failing after keys were pressed would leave them held on the host: a release report is then attempted before returning
+*/
+static ret_type_te logic_keyboard_type_packed_symbols(hid_interface_te interface, uint16_t** symbols_pt, uint16_t delay_between_types)
+{
+    uint8_t keys[LOGIC_KEYBOARD_NB_KEYS_IN_REPORT];
+    uint16_t* symbols = *symbols_pt;
+    uint8_t group_modifier;
+    uint8_t nb_keys = 0;
+    uint8_t key;
+    
+    /* Check for enumeration */
+    if ((interface == USB_INTERFACE) && ((usb_get_config() == 0) || (udc_get_nb_ms_before_last_usb_activity() > 100)))
+    {
+        return RETURN_NOK;
+    }
+    
+    /* Modifier shared by the group */
+    memset(keys, 0, sizeof(keys));
+    group_modifier = logic_keyboard_get_key_and_modifier_for_symbol((uint8_t)*symbols, &key);
+    
+    /* Press modifier first */
+    if (group_modifier != 0)
+    {
+        if (logic_keyboard_send_report_and_wait(interface, group_modifier, keys, delay_between_types) != RETURN_OK)
         {
-            mod_tbs = KEY_SHIFT|KEY_RIGHT_ALT;
+            /* Don't leave the modifier held */
+            memset(keys, 0, sizeof(keys));
+            logic_keyboard_send_report_and_wait(interface, 0, keys, 0);
+            return RETURN_NOK;
         }
-        else if (masked_key == SHIFT_MASK)
+    }
+    
+    /* Add keys one by one */
+    while ((nb_keys < LOGIC_KEYBOARD_NB_KEYS_IN_REPORT) && (logic_keyboard_is_symbol_packable(*symbols) != FALSE))
+    {
+        /* Same modifier and key not already pressed */
+        if ((logic_keyboard_get_key_and_modifier_for_symbol((uint8_t)*symbols, &key) != group_modifier) || (memchr(keys, key, nb_keys) != 0))
         {
-            mod_tbs = KEY_SHIFT;
+            break;
         }
-        else if (masked_key == ALTGR_MASK)
+        keys[nb_keys++] = key;
+        symbols++;
+        
+        if (logic_keyboard_send_report_and_wait(interface, group_modifier, keys, delay_between_types) != RETURN_OK)
         {
-            mod_tbs = KEY_RIGHT_ALT;
+            /* Don't leave the keys held */
+            memset(keys, 0, sizeof(keys));
+            logic_keyboard_send_report_and_wait(interface, 0, keys, 0);
+            return RETURN_NOK;
         }
-            
-        // Send the correct KEY_EUROPE_2 with the correct modifier
-        return_val = logic_keyboard_type_key_with_modifier(interface, KEY_EUROPE_2_REAL, mod_tbs, delay_between_types);
     }
-    else if (masked_key == (SHIFT_MASK|ALTGR_MASK))
+    *symbols_pt = symbols;
+    
+    /* Release all */
+    memset(keys, 0, sizeof(keys));
+    return logic_keyboard_send_report_and_wait(interface, 0, keys, delay_between_types);
+}
+
+/*! \fn     logic_keyboard_type_next_symbols(hid_interface_te interface, uint16_t** symbols_pt, uint16_t delay_between_types, BOOL fast_typing)
+*   \brief  Type the next symbol (or group of packed symbols) of a 0 terminated array of symbols
+*   \param  interface           HID interface on which to type the symbols
+*   \param  symbols_pt          Pointer to the pointer to the next symbol, updated to the first symbol not typed
+*   \param  delay_between_types Delay between key presses
+*   \param  fast_typing         Set to pack keys in the same reports when possible
+*   \return If we were able to type the symbol(s)
+*/
+static ret_type_te logic_keyboard_type_next_symbols(hid_interface_te interface, uint16_t** symbols_pt, uint16_t delay_between_types, BOOL fast_typing)
+{
+    uint16_t symbol = **symbols_pt;
+    
+    if ((fast_typing != FALSE) && (logic_keyboard_is_symbol_packable(symbol) != FALSE))
     {
-        return_val = logic_keyboard_type_key_with_modifier(interface, symbol & ~(SHIFT_MASK|ALTGR_MASK), KEY_SHIFT|KEY_RIGHT_ALT, delay_between_types);
+        /* Type this symbol and the following ones using the same reports */
+        return logic_keyboard_type_packed_symbols(interface, symbols_pt, delay_between_types);
     }
-    else if (masked_key == SHIFT_MASK)
+    else if (symbol == 0xFFFF)
     {
-        // If we need shift
-        return_val = logic_keyboard_type_key_with_modifier(interface, symbol & ~SHIFT_MASK, KEY_SHIFT, delay_between_types);
+        /* Original unicode point can't be typed */
     }
-    else if (masked_key == ALTGR_MASK)
+    else if ((symbol & 0x7F00) == 0)
     {
-        // We need altgr for the numbered keys, only possible because we don't use the numerical keypad
-        return_val = logic_keyboard_type_key_with_modifier(interface, symbol & ~ALTGR_MASK, KEY_RIGHT_ALT, delay_between_types);
+        BOOL is_dead_key = FALSE;
+        
+        /* Check for dead key */
+        if ((symbol & 0x8000) != 0)
+        {
+            is_dead_key = TRUE;
+        }
+        
+        /* One key to be typed */
+        if (logic_keyboard_type_symbol(interface, (uint8_t)symbol, is_dead_key, delay_between_types) != RETURN_OK)
+        {
+            return RETURN_NOK;
+        }
     }
     else
     {
-        return_val = logic_keyboard_type_key_with_modifier(interface, symbol, 0, delay_between_types);
+        /* Two keys to be typed */
+        if (logic_keyboard_type_symbol(interface, (uint8_t)(symbol >> 8), FALSE, delay_between_types) != RETURN_OK)
+        {
+            return RETURN_NOK;
+        }
+        if (logic_keyboard_type_symbol(interface, (uint8_t)symbol, FALSE, delay_between_types) != RETURN_OK)
+        {
+            return RETURN_NOK;
+        }
     }
     
-    /* Add space if typed character is a dead key */
-    if ((is_dead_key != FALSE) && (return_val == RETURN_OK))
+    /* Move on to the next symbol */
+    (*symbols_pt)++;
+    return RETURN_OK;
+}
+
+/*! \fn     logic_keyboard_type_symbols(hid_interface_te interface, uint16_t* symbols, uint16_t delay_between_types, BOOL fast_typing)
+*   \brief  Type a 0 terminated array of symbols as sent by the main MCU
+*   \param  interface           HID interface on which to type the symbols
+*   \param  symbols             The symbols: 0xFFFF for non typable points, bit 15 set for dead keys, 2 symbols if bits 8 to 14 are set
+*   \param  delay_between_types Delay between key presses
+*   \param  fast_typing         Set to pack keys in the same reports when possible
+*   \return If we were able to type all the symbols
+*/
+ret_type_te logic_keyboard_type_symbols(hid_interface_te interface, uint16_t* symbols, uint16_t delay_between_types, BOOL fast_typing)
+{
+    /* Iterate over symbols */
+    while (*symbols != 0)
     {
-        return_val = logic_keyboard_type_key_with_modifier(interface, KEY_SPACE, 0, delay_between_types);        
+        if (logic_keyboard_type_next_symbols(interface, &symbols, delay_between_types, fast_typing) != RETURN_OK)
+        {
+            return RETURN_NOK;
+        }
     }
     
-    return return_val;
-}
\ No newline at end of file
+    return RETURN_OK;
+}
+
+/*! \fn     logic_keyboard_send_typing_done_event(void)
+*   \brief  Inform the main MCU that our typing queue is empty, and if all symbols were typed
+*/
+static void logic_keyboard_send_typing_done_event(void)
+{
+    aux_mcu_message_t* temp_tx_message_pt;
+    comms_main_mcu_get_empty_packet_ready_to_be_sent(&temp_tx_message_pt, AUX_MCU_MSG_TYPE_AUX_MCU_EVENT);
+    temp_tx_message_pt->aux_mcu_event_message.event_id = AUX_MCU_EVENT_TYPING_DONE;
+    temp_tx_message_pt->aux_mcu_event_message.payload_as_uint16[0] = (uint16_t)logic_keyboard_typing_queue_all_typed;
+    temp_tx_message_pt->payload_length1 = sizeof(temp_tx_message_pt->aux_mcu_event_message.event_id) + sizeof(uint16_t);
+    comms_main_mcu_send_message((void*)temp_tx_message_pt, (uint16_t)sizeof(aux_mcu_message_t));
+    logic_keyboard_typing_queue_all_typed = TRUE;
+}
+
+/*! \fn     logic_keyboard_queue_typing_job(hid_interface_te interface, uint16_t* symbols, uint16_t delay_between_types, BOOL fast_typing)
+*   \brief  Queue a 0 terminated array of symbols to be typed from our main loop
+*   \param  interface           HID interface on which to type the symbols
+*   \param  symbols             The symbols, see logic_keyboard_type_symbols
+*   \param  delay_between_types Delay between key presses
+*   \param  fast_typing         Set to pack keys in the same reports when possible
+*   \note   Symbols are copied. If the queue is full the job is rejected, as if its symbols couldn't be typed
+*/
+void logic_keyboard_queue_typing_job(hid_interface_te interface, uint16_t* symbols, uint16_t delay_between_types, BOOL fast_typing)
+{
+    logic_keyboard_typing_job_t* new_job;
+    uint16_t nb_symbols = 0;
+    
+    /* Count symbols */
+    while ((nb_symbols < LOGIC_KEYBOARD_TYPING_POOL_SYMBOLS-1) && (symbols[nb_symbols] != 0))
+    {
+        nb_symbols++;
+    }
+    
+    /* Queue full: reject the job rather than typing here, as we need to keep on dealing with comms */
+    if ((logic_keyboard_typing_queue_nb_jobs == LOGIC_KEYBOARD_TYPING_QUEUE_LENGTH) || (logic_keyboard_typing_symbols_pool_write_index + nb_symbols + 1 > LOGIC_KEYBOARD_TYPING_POOL_SYMBOLS))
+    {
+        logic_keyboard_typing_queue_all_typed = FALSE;
+        if (logic_keyboard_typing_queue_nb_jobs == 0)
+        {
+            logic_keyboard_send_typing_done_event();
+        }
+        return;
+    }
+    
+    /* Copy the job after the last queued one */
+    new_job = &logic_keyboard_typing_queue[(logic_keyboard_typing_queue_read_index + logic_keyboard_typing_queue_nb_jobs) % LOGIC_KEYBOARD_TYPING_QUEUE_LENGTH];
+    new_job->interface = interface;
+    new_job->delay_between_types = delay_between_types;
+    new_job->fast_typing = fast_typing;
+    new_job->first_symbol_index = logic_keyboard_typing_symbols_pool_write_index;
+    memcpy(&logic_keyboard_typing_symbols_pool[logic_keyboard_typing_symbols_pool_write_index], symbols, nb_symbols*sizeof(uint16_t));
+    logic_keyboard_typing_symbols_pool[logic_keyboard_typing_symbols_pool_write_index + nb_symbols] = 0;
+    logic_keyboard_typing_symbols_pool_write_index += nb_symbols + 1;
+    
+    /* Empty queue: this job is the next one to be typed */
+    if (logic_keyboard_typing_queue_nb_jobs == 0)
+    {
+        logic_keyboard_typing_queue_symbol_pt = &logic_keyboard_typing_symbols_pool[new_job->first_symbol_index];
+    }
+    logic_keyboard_typing_queue_nb_jobs++;
+}
+
+/*! \fn     logic_keyboard_typing_queue_routine(void)
+*   \brief  Type the next symbol(s) of our typing queue, to be called from our main loop
+*   \note   AUX_MCU_EVENT_TYPING_DONE is sent to the main MCU once the queue is empty
+*/
+void logic_keyboard_typing_queue_routine(void)
+{
+    logic_keyboard_typing_job_t* current_job = &logic_keyboard_typing_queue[logic_keyboard_typing_queue_read_index];
+    ret_type_te typing_return = RETURN_OK;
+    
+    /* Nothing to type */
+    if (logic_keyboard_typing_queue_nb_jobs == 0)
+    {
+        return;
+    }
+    
+    /* Type next symbol(s) */
+    if (*logic_keyboard_typing_queue_symbol_pt != 0)
+    {
+        typing_return = logic_keyboard_type_next_symbols(current_job->interface, &logic_keyboard_typing_queue_symbol_pt, current_job->delay_between_types, current_job->fast_typing);
+    }
+    
+    /* Like for the non queued typing, the remaining symbols are discarded if something went wrong */
+    if (typing_return != RETURN_OK)
+    {
+        logic_keyboard_typing_queue_all_typed = FALSE;
+    }
+    
+    /* Job done? */
+    if ((typing_return != RETURN_OK) || (*logic_keyboard_typing_queue_symbol_pt == 0))
+    {
+        logic_keyboard_typing_queue_read_index = (logic_keyboard_typing_queue_read_index + 1) % LOGIC_KEYBOARD_TYPING_QUEUE_LENGTH;
+        logic_keyboard_typing_queue_symbol_pt = &logic_keyboard_typing_symbols_pool[logic_keyboard_typing_queue[logic_keyboard_typing_queue_read_index].first_symbol_index];
+        logic_keyboard_typing_queue_nb_jobs--;
+        
+        /* Queue empty: pool can be used from its start again, inform main MCU */
+        if (logic_keyboard_typing_queue_nb_jobs == 0)
+        {
+            logic_keyboard_typing_symbols_pool_write_index = 0;
+            logic_keyboard_send_typing_done_event();
+        }
+    }
+}
+
+/*! \fn     logic_keyboard_flush_typing_queue(void)
+*   \brief  Type all the queued symbols
+*/
+void logic_keyboard_flush_typing_queue(void)
+{
+    while (logic_keyboard_typing_queue_nb_jobs != 0)
+    {
+        logic_keyboard_typing_queue_routine();
+    }
+}
+
+/*! \fn     logic_keyboard_discard_typing_queue(void)
+*   \brief  Drop the queued symbols without typing them
+*   \note   To be called when the typed credentials could end up in another window: sleep, logout, interface disabled
+*/
+void logic_keyboard_discard_typing_queue(void)
+{
+    if (logic_keyboard_typing_queue_nb_jobs != 0)
+    {
+        logic_keyboard_typing_queue_nb_jobs = 0;
+        logic_keyboard_typing_symbols_pool_write_index = 0;
+        logic_keyboard_typing_queue_all_typed = FALSE;
+        logic_keyboard_send_typing_done_event();
+    }
+}
@@ -12,6 +12,11 @@
 #include "defines.h"
 
 /* Defines */
+#define LOGIC_KEYBOARD_NB_KEYS_IN_REPORT    6
+// Max time (ms) for a keyboard report to be fetched (USB) or confirmed (BLE), sized for long BLE connection intervals
+#define LOGIC_KEYBOARD_REPORT_FETCH_TIMEOUT 1000
+#define LOGIC_KEYBOARD_TYPING_QUEUE_LENGTH  4
+#define LOGIC_KEYBOARD_TYPING_POOL_SYMBOLS  273
 #define SHIFT_MASK  0x80
 #define ALTGR_MASK  0x40
 #define KEY_CTRL               0x01
@@ -133,9 +138,23 @@
 #define KEY_F15                0x6A
 #define KEY_WIN_L              0xE3
 
+/* Typedefs */
+typedef struct
+{
+    hid_interface_te interface;
+    uint16_t delay_between_types;
+    BOOL fast_typing;
+    uint16_t first_symbol_index;
+} logic_keyboard_typing_job_t;
+
 /* Prototypes */
+void logic_keyboard_queue_typing_job(hid_interface_te interface, uint16_t* symbols, uint16_t delay_between_types, BOOL fast_typing);
 ret_type_te logic_keyboard_type_key_with_modifier(hid_interface_te interface, uint8_t key, uint8_t modifier, uint16_t delay_between_types);
+ret_type_te logic_keyboard_type_symbols(hid_interface_te interface, uint16_t* symbols, uint16_t delay_between_types, BOOL fast_typing);
 ret_type_te logic_keyboard_type_symbol(hid_interface_te interface, uint8_t symbol, BOOL is_dead_key, uint16_t delay_between_types);
 void logic_keyboard_type_lock_shortcut(hid_interface_te interface_id, uint8_t l_symbol);
+void logic_keyboard_discard_typing_queue(void);
+void logic_keyboard_typing_queue_routine(void);
+void logic_keyboard_flush_typing_queue(void);
 
 #endif /* LOGIC_KEYBOARD_H_ */
\ No newline at end of file
@@ -49,6 +49,7 @@ void udc_endpoint_set_feature(int ep, int dir);
 void udc_endpoint_clear_feature(int ep, int dir);
 void udc_set_address(int address);
 void udc_send(int ep, uint8_t *data, int size);
+bool udc_is_send_pending(int ep);
 void udc_recv(int ep, uint8_t *data, int size);
 void udc_control_send_zlp(void);
 void udc_control_stall(void);
@@ -213,6 +213,7 @@ static ret_type_te ctap_make_credential_aux_comm(CTAP_requestCommon *common, CTA
         while ((timer_has_timer_expired(TIMER_TIMEOUT_FUNCTS, TRUE) == TIMER_RUNNING) && (ret != RETURN_OK))
         {
             ret = comms_main_mcu_routine(TRUE, AUX_MCU_MSG_TYPE_FIDO2);
+            comms_raw_hid_ctap_routine();
         }
     } while (ret != RETURN_OK);
 
@@ -340,6 +341,7 @@ static ret_type_te ctap_get_assertion_aux_comm(CTAP_requestCommon *common, CTAP_
         while ((timer_has_timer_expired(TIMER_TIMEOUT_FUNCTS, TRUE) == TIMER_RUNNING) && (ret != RETURN_OK))
         {
             ret = comms_main_mcu_routine(TRUE, AUX_MCU_MSG_TYPE_FIDO2);
+            comms_raw_hid_ctap_routine();
         }
     } while (ret != RETURN_OK);
 
@@ -520,6 +522,7 @@ int ctap_authenticate_credential(struct rpId * rp, CTAP_credentialDescriptor * d
         while ((timer_has_timer_expired(TIMER_TIMEOUT_FUNCTS, TRUE) == TIMER_RUNNING) && (ret != RETURN_OK))
         {
             ret = comms_main_mcu_routine(TRUE, AUX_MCU_MSG_TYPE_FIDO2);
+            comms_raw_hid_ctap_routine();
         }
     } while (ret != RETURN_OK);
 
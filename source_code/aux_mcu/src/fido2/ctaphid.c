@@ -7,6 +7,7 @@
 //
 // Modified by MiniBLE developers
 // -Removed Solo specific message support
+// -Per channel reassembly buffers, other channels are served while a CBOR request is processed
 //
 #include <stdio.h>
 #include <stdlib.h>
@@ -52,6 +53,17 @@ struct CID
     uint8_t last_cmd;
 };
 
+typedef struct
+{
+    uint32_t cid;
+    int cmd;
+    uint16_t bcnt;
+    int offset;
+    int seq;
+    uint64_t last_used;
+    uint8_t buf[CTAPHID_BUFFER_SIZE];
+} CTAPHID_CHANNEL_BUFFER;
+
 
 #define SUCESS          0
 #define SEQUENCE_ERROR  1
@@ -62,14 +74,19 @@ static struct CID CIDS[5];
 
 static uint64_t active_cid_timestamp;
 
-static uint8_t ctap_buffer[CTAPHID_BUFFER_SIZE];
-static uint32_t ctap_buffer_cid;
-static int ctap_buffer_cmd;
-static uint16_t ctap_buffer_bcnt;
-static int ctap_buffer_offset;
-static int ctap_packet_seq;
+// One buffer for the request being processed, the others to reassemble messages from other channels meanwhile
+#define CTAPHID_NB_CHANNEL_BUFFERS  2
+_Static_assert(CTAPHID_NB_CHANNEL_BUFFERS <= CID_MAX, "More channel buffers than channels");
+static CTAPHID_CHANNEL_BUFFER ctap_buffers[CTAPHID_NB_CHANNEL_BUFFERS];
+
+// Channel whose CBOR request is being processed (0 if none), and command that interrupted it
+static uint32_t ctap_processing_cid;
+static uint8_t ctap_processing_interrupt_cmd;
+
+// Partially received messages idle for longer than this can be dropped to free their buffer
+#define CTAPHID_BUFFERING_TIMEOUT_MS    750
 
-static void buffer_reset(void);
+static void buffer_reset(CTAPHID_CHANNEL_BUFFER * buffer);
 
 #define CTAPHID_WRITE_INIT      0x01
 #define CTAPHID_WRITE_FLUSH     0x02
@@ -77,11 +94,18 @@ static void buffer_reset(void);
 
 #define     ctaphid_write_buffer_init(x)    memset(x,0,sizeof(CTAPHID_WRITE_BUFFER))
 static void ctaphid_write(CTAPHID_WRITE_BUFFER * wb, void * _data, int len);
+static void ctaphid_send_error(uint32_t cid, uint8_t error);
 
 void ctaphid_init(void)
 {
+    uint32_t i;
     state = IDLE;
-    buffer_reset();
+    for (i = 0; i < CTAPHID_NB_CHANNEL_BUFFERS; i++)
+    {
+        buffer_reset(&ctap_buffers[i]);
+    }
+    ctap_processing_cid = 0;
+    ctap_processing_interrupt_cmd = 0;
     //ctap_reset_state();
 }
 
@@ -169,24 +193,79 @@ static int is_cont_pkt(CTAPHID_PACKET * pkt)
 }
 
 
-static int buffer_packet(CTAPHID_PACKET * pkt)
+static CTAPHID_CHANNEL_BUFFER * buffer_get(uint32_t cid)
+{
+    uint32_t i;
+    for (i = 0; i < CTAPHID_NB_CHANNEL_BUFFERS; i++)
+    {
+        if (ctap_buffers[i].cid == cid)
+        {
+            return &ctap_buffers[i];
+        }
+    }
+    return NULL;
+}
+
+static CTAPHID_CHANNEL_BUFFER * buffer_allocate(uint32_t cid)
+{
+    CTAPHID_CHANNEL_BUFFER * buffer = buffer_get(0);
+    uint32_t i;
+
+    if (buffer == NULL)
+    {
+        // All buffers used: drop a message that stopped being sent
+        for (i = 0; i < CTAPHID_NB_CHANNEL_BUFFERS; i++)
+        {
+            if ((ctap_buffers[i].offset != ctap_buffers[i].bcnt) && ((millis() - ctap_buffers[i].last_used) >= CTAPHID_BUFFERING_TIMEOUT_MS))
+            {
+                printf1(TAG_HID, "dropping stalled message from %08x", ctap_buffers[i].cid);
+                ctaphid_send_error(ctap_buffers[i].cid, CTAP1_ERR_TIMEOUT);
+                cid_del(ctap_buffers[i].cid);
+                buffer = &ctap_buffers[i];
+                break;
+            }
+        }
+    }
+
+    if (buffer != NULL)
+    {
+        buffer_reset(buffer);
+        buffer->cid = cid;
+    }
+    return buffer;
+}
+
+static CTAPHID_CHANNEL_BUFFER * buffer_get_pending_cbor(void)
+{
+    uint32_t i;
+    for (i = 0; i < CTAPHID_NB_CHANNEL_BUFFERS; i++)
+    {
+        if ((ctap_buffers[i].cid != 0) && (ctap_buffers[i].cmd == CTAPHID_CBOR) && (ctap_buffers[i].offset == ctap_buffers[i].bcnt))
+        {
+            return &ctap_buffers[i];
+        }
+    }
+    return NULL;
+}
+
+static int buffer_packet(CTAPHID_CHANNEL_BUFFER * buffer, CTAPHID_PACKET * pkt)
 {
     if (pkt->pkt.init.cmd & TYPE_INIT)
     {
-        ctap_buffer_bcnt = ctaphid_packet_len(pkt);
-        int pkt_len = (ctap_buffer_bcnt < CTAPHID_INIT_PAYLOAD_SIZE) ? ctap_buffer_bcnt : CTAPHID_INIT_PAYLOAD_SIZE;
-        ctap_buffer_cmd = pkt->pkt.init.cmd;
-        ctap_buffer_cid = pkt->cid;
-        ctap_buffer_offset = pkt_len;
-        ctap_packet_seq = -1;
-        memmove(ctap_buffer, pkt->pkt.init.payload, pkt_len);
+        buffer->bcnt = ctaphid_packet_len(pkt);
+        int pkt_len = (buffer->bcnt < CTAPHID_INIT_PAYLOAD_SIZE) ? buffer->bcnt : CTAPHID_INIT_PAYLOAD_SIZE;
+        buffer->cmd = pkt->pkt.init.cmd;
+        buffer->cid = pkt->cid;
+        buffer->offset = pkt_len;
+        buffer->seq = -1;
+        memmove(buffer->buf, pkt->pkt.init.payload, pkt_len);
     }
     else
     {
-        int leftover = ctap_buffer_bcnt - ctap_buffer_offset;
+        int leftover = buffer->bcnt - buffer->offset;
         int diff = leftover - CTAPHID_CONT_PAYLOAD_SIZE;
-        ctap_packet_seq++;
-        if (ctap_packet_seq != pkt->pkt.cont.seq)
+        buffer->seq++;
+        if (buffer->seq != pkt->pkt.cont.seq)
         {
             return SEQUENCE_ERROR;
         }
@@ -194,33 +273,35 @@ static int buffer_packet(CTAPHID_PACKET * pkt)
         if (diff <= 0)
         {
             // only move the leftover amount
-            memmove(ctap_buffer + ctap_buffer_offset, pkt->pkt.cont.payload, leftover);
-            ctap_buffer_offset += leftover;
+            memmove(buffer->buf + buffer->offset, pkt->pkt.cont.payload, leftover);
+            buffer->offset += leftover;
         }
         else
         {
-            memmove(ctap_buffer + ctap_buffer_offset, pkt->pkt.cont.payload, CTAPHID_CONT_PAYLOAD_SIZE);
-            ctap_buffer_offset += CTAPHID_CONT_PAYLOAD_SIZE;
+            memmove(buffer->buf + buffer->offset, pkt->pkt.cont.payload, CTAPHID_CONT_PAYLOAD_SIZE);
+            buffer->offset += CTAPHID_CONT_PAYLOAD_SIZE;
         }
     }
+    buffer->last_used = millis();
     return SUCESS;
 }
 
-static void buffer_reset(void)
+static void buffer_reset(CTAPHID_CHANNEL_BUFFER * buffer)
 {
-    ctap_buffer_bcnt = 0;
-    ctap_buffer_offset = 0;
-    ctap_packet_seq = 0;
-    ctap_buffer_cid = 0;
+    buffer->bcnt = 0;
+    buffer->offset = 0;
+    buffer->seq = 0;
+    buffer->cmd = 0;
+    buffer->cid = 0;
 }
 
-static int buffer_status(void)
+static int buffer_status(CTAPHID_CHANNEL_BUFFER * buffer)
 {
-    if (ctap_buffer_bcnt == 0)
+    if (buffer->bcnt == 0)
     {
         return EMPTY;
     }
-    else if (ctap_buffer_offset == ctap_buffer_bcnt)
+    else if (buffer->offset == buffer->bcnt)
     {
         return BUFFERED;
     }
@@ -230,22 +311,6 @@ static int buffer_status(void)
     }
 }
 
-static int buffer_cmd(void)
-{
-    return ctap_buffer_cmd;
-}
-
-static uint32_t buffer_cid(void)
-{
-    return ctap_buffer_cid;
-}
-
-
-static int buffer_len(void)
-{
-    return ctap_buffer_bcnt;
-}
-
 // Buffer data and send in HID_MESSAGE_SIZE chunks
 // if len == 0, FLUSH
 static void ctaphid_write(CTAPHID_WRITE_BUFFER * wb, void * _data, int len)
@@ -340,17 +405,19 @@ static void send_init_response(uint32_t oldcid, uint32_t newcid, uint8_t * nonce
 
 void ctaphid_check_timeouts(void)
 {
+    CTAPHID_CHANNEL_BUFFER * buffer;
     uint8_t i;
     for(i = 0; i < CID_MAX; i++)
     {
-        if (CIDS[i].busy && ((millis() - CIDS[i].last_used) >= 750))
+        if (CIDS[i].busy && (CIDS[i].cid != ctap_processing_cid) && ((millis() - CIDS[i].last_used) >= 750))
         {
             printf1(TAG_HID, "TIMEOUT CID: %08x", CIDS[i].cid);
             ctaphid_send_error(CIDS[i].cid, CTAP1_ERR_TIMEOUT);
             CIDS[i].busy = 0;
-            if (CIDS[i].cid == buffer_cid())
+            buffer = buffer_get(CIDS[i].cid);
+            if (buffer != NULL)
             {
-                buffer_reset();
+                buffer_reset(buffer);
             }
             // memset(CIDS + i, 0, sizeof(struct CID));
         }
@@ -364,7 +431,7 @@ void ctaphid_update_status(int8_t status)
     //printf1(TAG_HID, "Send device update %d!",status);
     ctaphid_write_buffer_init(&wb);
 
-    wb.cid = buffer_cid();
+    wb.cid = ctap_processing_cid;
     wb.cmd = CTAPHID_KEEPALIVE;
     wb.bcnt = 1;
 
@@ -372,9 +439,10 @@ void ctaphid_update_status(int8_t status)
     ctaphid_write(&wb, NULL, 0);
 }
 
-static int ctaphid_buffer_packet(uint32_t * pkt_raw, uint8_t * cmd, uint32_t * cid, int * len)
+static int ctaphid_buffer_packet(uint32_t * pkt_raw, uint8_t * cmd, uint32_t * cid, int * len, CTAPHID_CHANNEL_BUFFER ** buffer_pt)
 {
     CTAPHID_PACKET * pkt = (CTAPHID_PACKET *)(pkt_raw);
+    CTAPHID_CHANNEL_BUFFER * buffer;
 
     if (!is_cont_pkt(pkt)) {printf2(TAG_ERR, "  length: %d", ctaphid_packet_len(pkt));}
 
@@ -384,6 +452,7 @@ static int ctaphid_buffer_packet(uint32_t * pkt_raw, uint8_t * cmd, uint32_t * c
 
 
     *cid = pkt->cid;
+    *buffer_pt = NULL;
 
     if (is_init_pkt(pkt))
     {
@@ -400,7 +469,6 @@ static int ctaphid_buffer_packet(uint32_t * pkt_raw, uint8_t * cmd, uint32_t * c
             return HID_ERROR;
         }
 
-        ctaphid_init();
         if (is_broadcast(pkt))
         {
             // Check if any existing cids are busy first ?
@@ -415,6 +483,17 @@ static int ctaphid_buffer_packet(uint32_t * pkt_raw, uint8_t * cmd, uint32_t * c
             printf1(TAG_HID, "synchronizing to cid");
             oldcid = pkt->cid;
             newcid = pkt->cid;
+
+            // Synchronizing aborts the channel transaction, other channels are left untouched
+            if (newcid == ctap_processing_cid)
+            {
+                ctap_processing_interrupt_cmd = CTAPHID_INIT;
+            }
+            else if ((buffer = buffer_get(newcid)) != NULL)
+            {
+                buffer_reset(buffer);
+            }
+
             if (cid_exists(newcid))
                 ret = cid_refresh(newcid);
             else
@@ -427,147 +506,110 @@ static int ctaphid_buffer_packet(uint32_t * pkt_raw, uint8_t * cmd, uint32_t * c
             return HID_ERROR;
         }
         send_init_response(oldcid, newcid, pkt->pkt.init.payload);
-        cid_del(newcid);
+        if (newcid != ctap_processing_cid)
+        {
+            cid_del(newcid);
+        }
 
         return HID_IGNORE;
     }
     else
     {
-        if (pkt->cid == CTAPHID_BROADCAST_CID)
+        if ((pkt->cid == CTAPHID_BROADCAST_CID) || (pkt->cid == 0))
         {
             *cmd = CTAP1_ERR_INVALID_CHANNEL;
             return HID_ERROR;
         }
 
-        if (! cid_exists(pkt->cid) && ! is_cont_pkt(pkt))
+        buffer = buffer_get(pkt->cid);
+        *buffer_pt = buffer;
+
+        if (is_cont_pkt(pkt))
         {
-            if (buffer_status() == EMPTY)
+            if ((buffer == NULL) || (buffer_status(buffer) != BUFFERING))
             {
-                add_cid(pkt->cid);
+                printf2(TAG_ERR,"ignoring random cont packet from %04x",pkt->cid);
+                return HID_IGNORE;
             }
         }
-
-        if (cid_exists(pkt->cid))
+        else if (pkt->pkt.init.cmd == CTAPHID_CANCEL)
+        {
+            // Not buffered: may target the channel being processed, or abort the one being buffered
+            *cmd = CTAPHID_CANCEL;
+            *len = 0;
+            return BUFFERED;
+        }
+        else
         {
-            if (buffer_status() == BUFFERING)
+            if (buffer != NULL)
             {
-                if (pkt->cid == buffer_cid() && ! is_cont_pkt(pkt))
+                if (buffer_status(buffer) == BUFFERING)
                 {
                     printf2(TAG_ERR,"INVALID_SEQ");
-                    printf2(TAG_ERR,"Have %d/%d bytes", ctap_buffer_offset, ctap_buffer_bcnt);
+                    printf2(TAG_ERR,"Have %d/%d bytes", buffer->offset, buffer->bcnt);
                     *cmd = CTAP1_ERR_INVALID_SEQ;
-                    return HID_ERROR;
                 }
-                else if (pkt->cid != buffer_cid())
+                else
                 {
-                    if (! is_cont_pkt(pkt))
-                    {
-                        printf2(TAG_ERR,"BUSY with %08x", buffer_cid());
-                        *cmd = CTAP1_ERR_CHANNEL_BUSY;
-                        return HID_ERROR;
-                    }
-                    else
-                    {
-                        printf2(TAG_ERR,"ignoring random cont packet from %04x",pkt->cid);
-                        return HID_IGNORE;
-                    }
+                    printf2(TAG_ERR,"BUSY with a previous request from %08x", pkt->cid);
+                    *cmd = CTAP1_ERR_CHANNEL_BUSY;
                 }
+                return HID_ERROR;
             }
-            if (! is_cont_pkt(pkt))
-            {
 
-                if (ctaphid_packet_len(pkt) > CTAPHID_BUFFER_SIZE)
-                {
-                    *cmd = CTAP1_ERR_INVALID_LENGTH;
-                    return HID_ERROR;
-                }
-            }
-            else
+            if (ctaphid_packet_len(pkt) > CTAPHID_BUFFER_SIZE)
             {
-                if (buffer_status() == EMPTY || pkt->cid != buffer_cid())
-                {
-                    printf2(TAG_ERR,"ignoring random cont packet from %04x",pkt->cid);
-                    return HID_IGNORE;
-                }
+                *cmd = CTAP1_ERR_INVALID_LENGTH;
+                return HID_ERROR;
             }
 
-            if (buffer_packet(pkt) == SEQUENCE_ERROR)
+            if (! cid_exists(pkt->cid))
             {
-                printf2(TAG_ERR,"Buffering sequence error");
-                *cmd = CTAP1_ERR_INVALID_SEQ;
-                return HID_ERROR;
+                add_cid(pkt->cid);
             }
-            ret = cid_refresh(pkt->cid);
-            if (ret != 0)
+            if (cid_exists(pkt->cid))
             {
-                printf2(TAG_ERR,"Error, refresh cid failed");
-                exit(1);
+                buffer = buffer_allocate(pkt->cid);
             }
+            if (buffer == NULL)
+            {
+                printf2(TAG_ERR,"BUSY");
+                *cmd = CTAP1_ERR_CHANNEL_BUSY;
+                return HID_ERROR;
+            }
+            *buffer_pt = buffer;
         }
-        else if (is_cont_pkt(pkt))
-        {
-            printf2(TAG_ERR,"ignoring unwarranted cont packet");
 
-            // Ignore
-            return HID_IGNORE;
-        }
-        else
+        if (buffer_packet(buffer, pkt) == SEQUENCE_ERROR)
         {
-            printf2(TAG_ERR,"BUSY");
-            *cmd = CTAP1_ERR_CHANNEL_BUSY;
+            printf2(TAG_ERR,"Buffering sequence error");
+            *cmd = CTAP1_ERR_INVALID_SEQ;
             return HID_ERROR;
         }
+        ret = cid_refresh(pkt->cid);
+        if (ret != 0)
+        {
+            printf2(TAG_ERR,"Error, refresh cid failed");
+            exit(1);
+        }
     }
 
-    *len = buffer_len();
-    *cmd = buffer_cmd();
-    return buffer_status();
+    *len = buffer->bcnt;
+    *cmd = buffer->cmd;
+    return buffer_status(buffer);
 }
 
 extern void _check_ret(CborError ret, int line, const char * filename);
 #define check_hardcore(r)   _check_ret(r,__LINE__, __FILE__);\
                             if ((r) != CborNoError) exit(1);
 
-/**
- * Removed Solo specific messages
- */
-uint8_t ctaphid_handle_packet(uint32_t * pkt_raw)
+static uint8_t ctaphid_process_message(CTAPHID_CHANNEL_BUFFER * buffer, uint8_t cmd, uint32_t cid, int len)
 {
-    uint8_t cmd;
-    uint32_t cid;
-    int len;
 #ifndef DISABLE_CTAPHID_CBOR
-    int status;
+    uint8_t status;
+    static CTAP_RESPONSE ctap_resp;
 #endif
-
-    static uint8_t is_busy = 0;
     static CTAPHID_WRITE_BUFFER wb;
-    CTAP_RESPONSE ctap_resp;
-
-    int bufstatus = ctaphid_buffer_packet(pkt_raw, &cmd, &cid, &len);
-
-    if (bufstatus == HID_IGNORE)
-    {
-        return 0;
-    }
-
-    if (bufstatus == HID_ERROR)
-    {
-        cid_del(cid);
-        if (cmd == CTAP1_ERR_INVALID_SEQ)
-        {
-            buffer_reset();
-        }
-        ctaphid_send_error(cid, cmd);
-        return 0;
-    }
-
-    if (bufstatus == BUFFERING)
-    {
-        active_cid_timestamp = millis();
-        return 0;
-    }
-
 
     switch(cmd)
     {
@@ -585,7 +627,7 @@ uint8_t ctaphid_handle_packet(uint32_t * pkt_raw)
             wb.cmd = CTAPHID_PING;
             wb.bcnt = len;
             timestamp();
-            ctaphid_write(&wb, ctap_buffer, len);
+            ctaphid_write(&wb, buffer->buf, len);
             ctaphid_write(&wb, NULL,0);
             printf1(TAG_TIME,"PING writeback: %d ms",timestamp());
 
@@ -614,46 +656,117 @@ uint8_t ctaphid_handle_packet(uint32_t * pkt_raw)
             {
                 printf2(TAG_ERR,"Error,invalid 0 length field for cbor packet");
                 ctaphid_send_error(cid, CTAP1_ERR_INVALID_LENGTH);
-                return 0;
+                break;
             }
-            if (is_busy)
+            // Other channels packets keep on being handled while waiting for the main MCU
+            ctap_processing_cid = cid;
+            ctap_processing_interrupt_cmd = 0;
+            ctap_response_init(&ctap_resp);
+            status = ctap_request(buffer->buf, len, &ctap_resp);
+
+            if (ctap_processing_interrupt_cmd == CTAPHID_INIT)
             {
-                printf1(TAG_HID,"Channel busy for CBOR");
-                ctaphid_send_error(cid, CTAP1_ERR_CHANNEL_BUSY);
-                return 0;
+                // Channel was synchronized meanwhile: the host doesn't expect this answer anymore
+                printf1(TAG_HID,"Dropping CBOR answer");
             }
-            is_busy = 1;
-            ctap_response_init(&ctap_resp);
-            status = ctap_request(ctap_buffer, len, &ctap_resp);
+            else
+            {
+                if (ctap_processing_interrupt_cmd == CTAPHID_CANCEL)
+                {
+                    status = CTAP2_ERR_KEEPALIVE_CANCEL;
+                    ctap_resp.length = 0;
+                }
 
-            ctaphid_write_buffer_init(&wb);
-            wb.cid = cid;
-            wb.cmd = CTAPHID_CBOR;
-            wb.bcnt = (ctap_resp.length+1);
+                ctaphid_write_buffer_init(&wb);
+                wb.cid = cid;
+                wb.cmd = CTAPHID_CBOR;
+                wb.bcnt = (ctap_resp.length+1);
 
 
-            timestamp();
-            ctaphid_write(&wb, &status, 1);
-            ctaphid_write(&wb, ctap_resp.data, ctap_resp.length);
-            ctaphid_write(&wb, NULL, 0);
-            printf1(TAG_TIME,"CBOR writeback: %d ms",timestamp());
-            is_busy = 0;
+                timestamp();
+                ctaphid_write(&wb, &status, 1);
+                ctaphid_write(&wb, ctap_resp.data, ctap_resp.length);
+                ctaphid_write(&wb, NULL, 0);
+                printf1(TAG_TIME,"CBOR writeback: %d ms",timestamp());
+            }
+            ctap_processing_cid = 0;
             break;
 #endif
         case CTAPHID_CANCEL:
             printf1(TAG_HID,"CTAPHID_CANCEL");
-            is_busy = 0;
+            if (cid == ctap_processing_cid)
+            {
+                ctap_processing_interrupt_cmd = CTAPHID_CANCEL;
+                return 0;
+            }
             break;
         default:
-            printf2(TAG_ERR,"error, unimplemented HID cmd: %02x\r", buffer_cmd());
+            printf2(TAG_ERR,"error, unimplemented HID cmd: %02x\r", cmd);
             ctaphid_send_error(cid, CTAP1_ERR_INVALID_COMMAND);
             break;
     }
     cid_del(cid);
-    buffer_reset();
+    if (buffer != NULL)
+    {
+        buffer_reset(buffer);
+    }
 
     printf1(TAG_HID,"");
-    if (!is_busy) return cmd;
-    else return 0;
+    return cmd;
+}
+
+/**
+ * Removed Solo specific messages
+ * May be called again while a CBOR request is processed, for packets from other channels
+ */
+uint8_t ctaphid_handle_packet(uint32_t * pkt_raw)
+{
+    CTAPHID_CHANNEL_BUFFER * buffer;
+    uint8_t cmd;
+    uint32_t cid;
+    int len;
+
+    int bufstatus = ctaphid_buffer_packet(pkt_raw, &cmd, &cid, &len, &buffer);
+
+    if (bufstatus == HID_IGNORE)
+    {
+        return 0;
+    }
+
+    if (bufstatus == HID_ERROR)
+    {
+        if (cid != ctap_processing_cid)
+        {
+            cid_del(cid);
+        }
+        if ((cmd == CTAP1_ERR_INVALID_SEQ) && (buffer != NULL))
+        {
+            buffer_reset(buffer);
+        }
+        ctaphid_send_error(cid, cmd);
+        return 0;
+    }
+
+    if (bufstatus == BUFFERING)
+    {
+        active_cid_timestamp = millis();
+        return 0;
+    }
+
+    // Only one CBOR request processed at a time: the others are kept until it is answered
+    if ((cmd == CTAPHID_CBOR) && (ctap_processing_cid != 0))
+    {
+        printf1(TAG_HID,"CBOR request from %08x queued", cid);
+        return 0;
+    }
+
+    cmd = ctaphid_process_message(buffer, cmd, cid, len);
+
+    // Process the CBOR requests received in the meantime
+    while ((ctap_processing_cid == 0) && ((buffer = buffer_get_pending_cbor()) != NULL))
+    {
+        cmd = ctaphid_process_message(buffer, buffer->cmd, buffer->cid, buffer->bcnt);
+    }
 
+    return cmd;
 }
@@ -106,10 +106,12 @@ SOURCES += src/EMU/lis2hh12.c \
     src/debug.c \
     src/main.c \
     src/EMU/emu_aux_mcu.c \
+    src/EMU/emu_latency.c \
     src/EMU/emulator.cpp \
     src/EMU/emu_oled.cpp \
     src/EMU/emu_smartcard.cpp \
     src/EMU/emu_storage.cpp \
+    src/EMU/emu_script.cpp \
     src/EMU/emulator_ui.cpp
 
 QMAKE_CXXFLAGS += -fdata-sections \
@@ -162,9 +164,11 @@ HEADERS  += src/MainWindow.h \ \
     src/COMMS/comms_hid_msgs_debug.h \
     src/EMU/asf.h \
     src/EMU/emu_aux_mcu.h \
+    src/EMU/emu_latency.h \
     src/EMU/emu_oled.h \
     src/EMU/emu_smartcard.h \
     src/EMU/emu_storage.h \
+    src/EMU/emu_script.h \
     src/EMU/emulator.h \
     src/EMU/emulator_ui.h \
     src/EMU/qt_metacall_helper.h \
@@ -229,6 +229,8 @@ aux_mcu_message_t* comms_aux_mcu_get_empty_packet_ready_to_be_sent(uint16_t mess
 */
 void comms_aux_mcu_send_message(aux_mcu_message_t* message_to_send)
 {
+    PROFILING_START(profiling_start);
+    
     /* Do we need to wake-up aux mcu? */
     if (aux_mcu_comms_disabled != FALSE)
     {
@@ -257,8 +259,16 @@ void comms_aux_mcu_send_message(aux_mcu_message_t* message_to_send)
         aux_mcu_message_2_reserved = FALSE;
     }
     
-    /* The function below does wait for a previous transfer to finish */
-    dma_aux_mcu_init_tx_transfer(AUXMCU_SERCOM, (void*)message_to_send, sizeof(*message_to_send));
+    /* The functions below do wait for a previous transfer to finish */
+    if (dma_aux_mcu_are_compact_frames_enabled() != FALSE)
+    {
+        dma_aux_mcu_init_compact_tx_transfer(AUXMCU_SERCOM, message_to_send);
+    }
+    else
+    {
+        dma_aux_mcu_init_tx_transfer(AUXMCU_SERCOM, (void*)message_to_send, sizeof(*message_to_send));
+    }
+    PROFILING_STOP(PROFILING_AUX_MCU_TX, profiling_start);
 }
 
 /*! \fn     comms_aux_mcu_send_simple_command_message(uint16_t command)
@@ -293,6 +303,9 @@ void comms_aux_mcu_hard_comms_reset_with_aux_mcu_reboot(void)
 {
     /* Set no comms (keep platform in sleep after its reboot) */
     platform_io_set_no_comms();
+    
+    /* Rebooted aux MCU will use full frames */
+    dma_aux_mcu_set_compact_frames_enabled(FALSE);
 
     /* Generate two packets full of 0xFF... */
     aux_mcu_message_t* temp_tx_message_pt = comms_aux_mcu_get_empty_packet_ready_to_be_sent(0xFFFF);
@@ -338,6 +351,76 @@ RET_TYPE comms_aux_mcu_send_receive_ping(void)
     return return_val;
 }
 
+/*! \fn     comms_aux_mcu_negotiate_compact_frames(void)
+*   \brief  Ask the aux MCU to switch to compact frames (only payload_length1 payload bytes sent)
+*   \return Success or not (aux MCU firmware not supporting them)
+*   \note   Request and answer are sent using full frames, comms stay unchanged in case of failure
+*   \note   Only sent to aux MCU firmwares >= AUX_MCU_COMPACT_FRAMES_MIN_FW_MAJOR.AUX_MCU_COMPACT_FRAMES_MIN_FW_MINOR
+*/
+RET_TYPE comms_aux_mcu_negotiate_compact_frames(void)
+{
+    aux_mcu_message_t* temp_tx_message_pt;
+    aux_mcu_message_t* temp_rx_message_pt;
+    uint16_t aux_fw_ver_major;
+    uint16_t aux_fw_ver_minor;
+    RET_TYPE return_val;
+    
+    /* Ask for aux MCU firmware version using full frames */
+    dma_aux_mcu_set_compact_frames_enabled(FALSE);
+    temp_tx_message_pt = comms_aux_mcu_get_empty_packet_ready_to_be_sent(AUX_MCU_MSG_TYPE_PLAT_DETAILS);
+    comms_aux_mcu_send_message(temp_tx_message_pt);
+    if (comms_aux_mcu_active_wait(&temp_rx_message_pt, AUX_MCU_MSG_TYPE_PLAT_DETAILS, FALSE, -1) != RETURN_OK)
+    {
+        comms_aux_arm_rx_and_clear_no_comms();
+        return RETURN_NOK;
+    }
+    aux_fw_ver_major = temp_rx_message_pt->aux_details_message.aux_fw_ver_major;
+    aux_fw_ver_minor = temp_rx_message_pt->aux_details_message.aux_fw_ver_minor;
+    comms_aux_arm_rx_and_clear_no_comms();
+    
+    /* Older aux MCU firmwares don't know the command: don't send it, they'd flag it as invalid and we'd wait for nothing */
+    if ((((uint32_t)aux_fw_ver_major << 16) | aux_fw_ver_minor) < (((uint32_t)AUX_MCU_COMPACT_FRAMES_MIN_FW_MAJOR << 16) | AUX_MCU_COMPACT_FRAMES_MIN_FW_MINOR))
+    {
+        return RETURN_NOK;
+    }
+    
+    /* Send request, aux MCU answers before switching */
+    comms_aux_mcu_send_simple_command_message(MAIN_MCU_COMMAND_COMPACT_FRAMES);
+    
+    return_val = comms_aux_mcu_active_wait(&temp_rx_message_pt, AUX_MCU_MSG_TYPE_AUX_MCU_EVENT, FALSE, AUX_MCU_EVENT_COMPACT_FRAMES_ON);
+    
+    /* Aux MCU switched, switch before rearming receive */
+    if (return_val == RETURN_OK)
+    {
+        dma_aux_mcu_set_compact_frames_enabled(TRUE);
+    }
+    
+    /* Rearm receive */
+    comms_aux_arm_rx_and_clear_no_comms();
+    
+    return return_val;
+}
+
+/*! \fn     comms_aux_mcu_wait_for_hid_message_forwarded(void)
+*   \brief  Wait for the aux MCU to have forwarded the HID messages we sent
+*   \return RETURN_OK if the aux MCU can take another HID message
+*   \note   Aux MCU has a single receive buffer per HID interface: to be called between HID messages sent back to back
+*/
+RET_TYPE comms_aux_mcu_wait_for_hid_message_forwarded(void)
+{
+    aux_mcu_message_t* temp_rx_message_pt;
+    RET_TYPE return_val;
+    
+    /* Aux MCU answers once it has sent the previous HID messages */
+    comms_aux_mcu_send_simple_command_message(MAIN_MCU_COMMAND_HID_MSG_SYNC);
+    return_val = comms_aux_mcu_active_wait(&temp_rx_message_pt, AUX_MCU_MSG_TYPE_AUX_MCU_EVENT, FALSE, AUX_MCU_EVENT_HID_MSG_SYNCED);
+    
+    /* Rearm receive */
+    comms_aux_arm_rx_and_clear_no_comms();
+    
+    return return_val;
+}
+
 /*! \fn     comms_aux_mcu_get_aux_status(void)
 *   \brief  Request the aux MCU for its status, check if it's alive
 *   \return Different status (see enum)
@@ -615,6 +698,11 @@ void comms_aux_mcu_deal_with_received_event(aux_mcu_message_t* received_message)
             logic_bluetooth_set_too_many_failed_connections();
             break;
         }
+        case AUX_MCU_EVENT_TYPING_DONE:
+        {
+            logic_user_set_queued_typing_done((BOOL)received_message->aux_mcu_event_message.payload_as_uint16[0]);
+            break;
+        }
         default: 
         {
             /* Flag invalid message */
@@ -812,6 +900,12 @@ comms_msg_rcvd_te comms_aux_mcu_routine(msg_restrict_type_te answer_restrict_typ
         comms_aux_arm_rx_and_clear_no_comms();
         aux_mcu_comms_prev_aux_mcu_routine_wants_to_arm_rx = FALSE;
     }
+    
+    /* Compact frames: report lost frames */
+    if (dma_aux_mcu_get_and_clear_compact_frame_lost() != FALSE)
+    {
+        comms_aux_mcu_set_invalid_message_received();
+    }
 
     /* Ongoing RX transfer received bytes */
     uint16_t nb_received_bytes_for_ongoing_transfer = sizeof(aux_mcu_receive_message) - dma_aux_mcu_get_remaining_bytes_for_rx_transfer();
@@ -1134,11 +1228,13 @@ RET_TYPE comms_aux_mcu_active_wait(aux_mcu_message_t** rx_message_pt_pt, uint16_
         /* Wait for complete message to be received */
         BOOL dma_check_return = FALSE;
         timer_flag_te timer_flag_return = TIMER_RUNNING;
+        PROFILING_START(profiling_start);
         while((dma_check_return == FALSE) && (timer_flag_return == TIMER_RUNNING))
         {
             dma_check_return = dma_aux_mcu_check_and_clear_dma_transfer_flag();
             timer_flag_return = timer_has_allocated_timer_expired(temp_timer_id, FALSE);
         }
+        PROFILING_STOP(PROFILING_AUX_MCU_RX_WAIT, profiling_start);
 
         /* Did the timer expire? */
         if (dma_check_return == FALSE)
@@ -48,6 +48,8 @@ aux_status_return_te comms_aux_mcu_get_aux_status(void);
 void comms_aux_mcu_clear_rx_already_armed_error(void);
 void comms_aux_mcu_set_invalid_message_received(void);
 void comms_aux_mcu_update_device_status_buffer(void);
+RET_TYPE comms_aux_mcu_negotiate_compact_frames(void);
+RET_TYPE comms_aux_mcu_wait_for_hid_message_forwarded(void);
 RET_TYPE comms_aux_mcu_send_receive_ping(void);
 void comms_aux_mcu_wait_for_message_sent(void);
 void comms_aux_arm_rx_and_clear_no_comms(void);
@@ -45,6 +45,16 @@
 #define AUX_MCU_MSG_TYPE_RNG_TRANSFER       0x000A
 #define AUX_MCU_MSG_TYPE_BLE_CMD            0x000B
 
+// Compact framing: set in payload_length1 when only the header and payload_length1 bytes follow
+#define AUX_MCU_MSG_COMPACT_FRAME_FLAG      0x8000
+// Compact framing: header check sent along with the flag, a flagged header without it means we lost sync
+#define AUX_MCU_MSG_COMPACT_FRAME_MAGIC     0x5400
+#define AUX_MCU_MSG_COMPACT_FRAME_MASK      0xFC00
+#define AUX_MCU_MSG_HEADER_LENGTH           (sizeof(uint16_t) + sizeof(uint16_t))
+// Compact framing: first aux MCU firmware version supporting MAIN_MCU_COMMAND_COMPACT_FRAMES
+#define AUX_MCU_COMPACT_FRAMES_MIN_FW_MAJOR 0
+#define AUX_MCU_COMPACT_FRAMES_MIN_FW_MINOR 67
+
 // Main MCU commands
 #define MAIN_MCU_COMMAND_SLEEP              0x0001
 #define MAIN_MCU_COMMAND_ATTACH_USB         0x0002
@@ -61,6 +71,9 @@
 #define MAIN_MCU_COMMAND_GET_STATUS         0x000D
 #define MAIN_MCU_COMMAND_NIMH_DANGER_CHARGE 0x000E
 #define MAIN_MCU_COMMAND_DISABLE_BLE        0x000F
+#define MAIN_MCU_COMMAND_COMPACT_FRAMES     0x0010
+#define MAIN_MCU_COMMAND_DISCARD_TYPING     0x0011
+#define MAIN_MCU_COMMAND_HID_MSG_SYNC       0x0012
 
 // Debug MCU commands
 #define MAIN_MCU_COMMAND_DTM_RX_START       0x1000
@@ -95,6 +108,9 @@
 #define AUX_MCU_EVENT_RX_DTM_DONE           0x0017
 #define AUX_MCU_EVENT_BLE_CON_SPAM          0x0018
 #define AUX_MCU_EVENT_BONDING_CLEARED       0x0019
+#define AUX_MCU_EVENT_COMPACT_FRAMES_ON     0x001A
+#define AUX_MCU_EVENT_TYPING_DONE           0x001B
+#define AUX_MCU_EVENT_HID_MSG_SYNCED        0x001C
 
 // BLE commands
 #define BLE_MESSAGE_CMD_ENABLE              0x0001
@@ -193,6 +209,11 @@ typedef struct
     uint8_t tbd[2];
 } ping_with_info_message_t;
 
+// Set in interface_identifier to pack keys in the same HID reports
+#define KEYBOARD_TYPE_FAST_TYPING_FLAG      0x8000
+// Set in interface_identifier to queue the symbols: no answer, AUX_MCU_EVENT_TYPING_DONE is sent once all queued symbols are typed
+#define KEYBOARD_TYPE_QUEUE_FLAG            0x4000
+
 typedef struct
 {
     uint16_t interface_identifier;
@@ -38,6 +38,17 @@
 #define HID_MESSAGE_AES_GCM_BITMASK 0x4000
 #define HID_MESSAGE_GCM_TAG_LGTH    16
 
+// Max number of nodes sent back for one bulk node read request
+#define HID_READ_NODES_BULK_MAX_NB  64
+
+// Max number of data chunks pushed back for one streamed data request, packet types
+#define HID_STREAM_DATA_MAX_WINDOW  8
+#define HID_STREAM_DATA_CHUNK_PKT   0x0000
+#define HID_STREAM_DATA_END_PKT     0x0001
+
+// Max number of profiling counters sent back
+#define HID_PROFILING_MAX_NB_COUNTERS   16
+
 /* Command defines */
 #define HID_CMD_ID_PING             0x0001
 #define HID_CMD_ID_RETRY            0x0002
@@ -100,6 +111,8 @@
 #define HID_CMD_DELETE_FILE_ID      0x003B
 #define HID_CMD_DELETE_NOTE_ID      0x003C
 #define HID_CMD_PREPARE_SN_FLASH    0x003D
+#define HID_CMD_STREAM_FILE_DATA_ID 0x003E
+#define HID_CMD_GET_PROFILING_DATA  0x003F
 // Below: commands requiring MMM
 #define HID_CMD_GET_START_PARENTS   0x0100
 #define HID_CMD_END_MMM             0x0101
@@ -118,6 +131,8 @@
 #define HID_CMD_GET_CPZ_LUT_ENTRY   0x010E
 #define HID_CMD_GET_FAVORITES       0x010F
 #define HID_CMD_CHANGE_NODE_PWD     0x0110
+#define HID_CMD_READ_NODES_BULK     0x0111
+#define HID_CMD_GET_CHANGE_JOURNAL  0x0113
 // Define used to identify commands
 #define HID_FIRST_CMD_FOR_MMM       HID_CMD_GET_START_PARENTS
 #define HID_LAST_CMD_FOR_MMM        0x0200
@@ -148,8 +163,25 @@ typedef struct
     uint32_t lifetime_nb_ms_screen_on_lsb;
     uint32_t lifetime_nb_30mins_bat;
     uint32_t lifetime_nb_30mins_usb;
+    uint32_t dbflash_read_cache_nb_hits;
+    uint32_t dbflash_read_cache_nb_misses;
 } hid_message_diag_info_t;
 
+typedef struct
+{
+    uint32_t nb_calls;
+    uint32_t nb_cycles_msb;
+    uint32_t nb_cycles_lsb;
+} hid_message_profiling_counter_t;
+
+typedef struct
+{
+    uint32_t cycles_per_second;
+    uint16_t nb_counters;
+    uint16_t reserved;
+    hid_message_profiling_counter_t counters[HID_PROFILING_MAX_NB_COUNTERS];
+} hid_message_profiling_data_t;
+
 typedef struct
 {
     uint16_t service_name_index;
@@ -166,6 +198,57 @@ typedef struct
     cust_char_t new_password[0];
 } hid_message_change_node_pwd_t;
 
+typedef struct
+{
+    uint16_t start_address;
+    uint16_t nb_nodes;
+} hid_message_read_nodes_bulk_req_t;
+
+typedef struct
+{
+    uint16_t node_address;
+    uint8_t node_data[0];
+} hid_message_read_nodes_bulk_node_t;
+
+typedef struct
+{
+    uint16_t nb_nodes_sent;
+    uint16_t next_node_address;
+} hid_message_read_nodes_bulk_end_t;
+
+typedef struct
+{
+    uint16_t window_size;
+} hid_message_stream_data_req_t;
+
+typedef struct
+{
+    uint16_t packet_type;
+    uint16_t nb_bytes;
+    uint8_t data[0];
+} hid_message_stream_data_chunk_t;
+
+typedef struct
+{
+    uint16_t packet_type;
+    uint16_t nb_chunks_sent;
+    uint16_t end_of_data;
+} hid_message_stream_data_end_t;
+
+typedef struct
+{
+    uint32_t cred_change_number;
+    uint32_t data_change_number;
+} hid_message_get_change_journal_req_t;
+
+typedef struct
+{
+    uint16_t journal_complete;
+    uint16_t profile_changed;
+    uint16_t nb_node_addresses;
+    uint16_t node_addresses[0];
+} hid_message_change_journal_t;
+
 typedef struct
 {
     cust_char_t service_name[SERVICE_NAME_MAX_LEN];
@@ -247,9 +330,18 @@ typedef struct
         hid_message_detailed_plat_info_t detailed_platform_info;
         hid_message_plat_info_t platform_info;
         hid_message_diag_info_t diag_info_message;
+        hid_message_profiling_data_t profiling_data;
         hid_message_store_cred_t store_credential;
         hid_message_check_cred_req_t check_credential;
         hid_message_get_battery_status_t battery_status;
+        hid_message_read_nodes_bulk_node_t read_nodes_bulk_node;
+        hid_message_read_nodes_bulk_end_t read_nodes_bulk_end;
+        hid_message_read_nodes_bulk_req_t read_nodes_bulk_req;
+        hid_message_get_change_journal_req_t get_change_journal_req;
+        hid_message_stream_data_req_t stream_data_req;
+        hid_message_stream_data_chunk_t stream_data_chunk;
+        hid_message_stream_data_end_t stream_data_end;
+        hid_message_change_journal_t change_journal;
         hid_message_get_cred_req_t get_credential_request;
         hid_message_change_node_pwd_t change_node_password;
         hid_message_store_TOTP_cred_t store_TOTP_credential;
@@ -971,6 +971,95 @@ void comms_hid_msgs_parse(hid_message_t* rcv_msg, uint16_t supposed_payload_leng
             }
         }
 
+        case HID_CMD_READ_NODES_BULK:
+        {
+            /* Check payload length and number of requested nodes */
+            if ((rcv_msg->payload_length == sizeof(rcv_msg->read_nodes_bulk_req)) && (rcv_msg->read_nodes_bulk_req.nb_nodes != 0) && (rcv_msg->read_nodes_bulk_req.nb_nodes <= HID_READ_NODES_BULK_MAX_NB))
+            {
+                /* Local copies as we're going to send several packets */
+                uint16_t node_address = rcv_msg->read_nodes_bulk_req.start_address;
+                uint16_t nb_nodes_to_read = rcv_msg->read_nodes_bulk_req.nb_nodes;
+                uint16_t nb_nodes_sent = 0;
+                node_type_te temp_node_type;
+                
+                /* Follow the linked list, each node in its own packet. User permission checked for each node */
+                while ((node_address != NODE_ADDR_NULL) && (nb_nodes_sent < nb_nodes_to_read) && (nodemgmt_check_user_permission(node_address, &temp_node_type) == RETURN_OK))
+                {
+                    aux_mcu_message_t* temp_tx_message_pt;
+                    uint16_t next_node_address;
+                    
+                    if ((temp_node_type == NODE_TYPE_PARENT) || (temp_node_type == NODE_TYPE_PARENT_DATA) || (temp_node_type == NODE_TYPE_NULL))
+                    {
+                        /* Read parent node */
+                        temp_tx_message_pt = comms_hid_msgs_get_empty_hid_packet(is_message_from_usb, rcv_message_type, sizeof(uint16_t) + sizeof(parent_node_t));
+                        parent_node_t* parent_node_pt = (parent_node_t*)temp_tx_message_pt->hid_message.read_nodes_bulk_node.node_data;
+                        nodemgmt_read_parent_node_data_block_from_flash(node_address, parent_node_pt);
+                        
+                        /* Empty node: end of the road */
+                        if (temp_node_type == NODE_TYPE_NULL)
+                        {
+                            next_node_address = NODE_ADDR_NULL;
+                        }
+                        else
+                        {
+                            next_node_address = parent_node_pt->cred_parent.nextParentAddress;
+                        }
+                    }
+                    else
+                    {
+                        /* Read child node */
+                        temp_tx_message_pt = comms_hid_msgs_get_empty_hid_packet(is_message_from_usb, rcv_message_type, sizeof(uint16_t) + sizeof(child_node_t));
+                        child_node_t* child_node_pt = (child_node_t*)temp_tx_message_pt->hid_message.read_nodes_bulk_node.node_data;
+                        nodemgmt_read_child_node_data_block_from_flash(node_address, child_node_pt);
+                        
+                        /* Next address field depends on the node type */
+                        if (temp_node_type == NODE_TYPE_DATA)
+                        {
+                            next_node_address = child_node_pt->data_child.nextDataAddress;
+                        }
+                        else
+                        {
+                            next_node_address = child_node_pt->cred_child.nextChildAddress;
+                        }
+                    }
+                    
+                    /* Send node */
+                    temp_tx_message_pt->hid_message.read_nodes_bulk_node.node_address = node_address;
+                    comms_aux_mcu_send_message(temp_tx_message_pt);
+                    node_address = next_node_address;
+                    nb_nodes_sent++;
+                    
+                    /* Wait for the aux MCU to forward it before sending the next one, stop if it doesn't answer */
+                    if (comms_aux_mcu_wait_for_hid_message_forwarded() != RETURN_OK)
+                    {
+                        return;
+                    }
+                }
+                
+                if (nb_nodes_sent == 0)
+                {
+                    /* Set nack, leave same command id */
+                    comms_hid_msgs_send_ack_nack_message(is_message_from_usb, rcv_message_type, FALSE);
+                    return;
+                }
+                else
+                {
+                    /* Final packet: number of nodes sent and where to continue from */
+                    aux_mcu_message_t* temp_tx_message_pt = comms_hid_msgs_get_empty_hid_packet(is_message_from_usb, rcv_message_type, sizeof(temp_tx_message_pt->hid_message.read_nodes_bulk_end));
+                    temp_tx_message_pt->hid_message.read_nodes_bulk_end.next_node_address = node_address;
+                    temp_tx_message_pt->hid_message.read_nodes_bulk_end.nb_nodes_sent = nb_nodes_sent;
+                    comms_aux_mcu_send_message(temp_tx_message_pt);
+                    return;
+                }
+            }
+            else
+            {
+                /* Set nack, leave same command id */
+                comms_hid_msgs_send_ack_nack_message(is_message_from_usb, rcv_message_type, FALSE);
+                return;
+            }
+        }
+
         case HID_CMD_WRITE_NODE:
         {
             node_type_te temp_node_type_te;
@@ -1031,6 +1120,7 @@ void comms_hid_msgs_parse(hid_message_t* rcv_msg, uint16_t supposed_payload_leng
             {
                 /* Store change number */
                 nodemgmt_set_cred_change_number(rcv_msg->payload_as_uint32[0]);
+                nodemgmt_restart_change_journal();
 
                 /* Set success byte */
                 comms_hid_msgs_send_ack_nack_message(is_message_from_usb, rcv_message_type, TRUE);
@@ -1051,6 +1141,7 @@ void comms_hid_msgs_parse(hid_message_t* rcv_msg, uint16_t supposed_payload_leng
             {
                 /* Store change number */
                 nodemgmt_set_data_change_number(rcv_msg->payload_as_uint32[0]);
+                nodemgmt_restart_change_journal();
 
                 /* Set success byte */
                 comms_hid_msgs_send_ack_nack_message(is_message_from_usb, rcv_message_type, TRUE);
@@ -1064,6 +1155,45 @@ void comms_hid_msgs_parse(hid_message_t* rcv_msg, uint16_t supposed_payload_leng
             }
         }
 
+        case HID_CMD_GET_CHANGE_JOURNAL :
+        {
+            /* Check payload length */
+            if (rcv_msg->payload_length == sizeof(hid_message_get_change_journal_req_t))
+            {
+                uint16_t* journal_addresses;
+                uint16_t nb_journal_addresses;
+                BOOL profile_changed;
+                BOOL journal_complete = nodemgmt_get_change_journal(rcv_msg->get_change_journal_req.cred_change_number, rcv_msg->get_change_journal_req.data_change_number, &journal_addresses, &nb_journal_addresses, &profile_changed);
+                
+                /* Incomplete journal: host will need to go through the complete database */
+                if (journal_complete == FALSE)
+                {
+                    nb_journal_addresses = 0;
+                }
+                
+                /* Boundary check */
+                _Static_assert(sizeof(hid_message_change_journal_t) + NODEMGMT_JOURNAL_MAX_ENTRIES*sizeof(uint16_t) <= MEMBER_SIZE(hid_message_t, payload), "Change journal doesn't fit in a message");
+                
+                /* Send journal */
+                aux_mcu_message_t* temp_tx_message_pt = comms_hid_msgs_get_empty_hid_packet(is_message_from_usb, rcv_message_type, sizeof(hid_message_change_journal_t) + nb_journal_addresses*sizeof(uint16_t));
+                temp_tx_message_pt->hid_message.change_journal.journal_complete = (journal_complete != FALSE)? 1 : 0;
+                temp_tx_message_pt->hid_message.change_journal.profile_changed = (profile_changed != FALSE)? 1 : 0;
+                temp_tx_message_pt->hid_message.change_journal.nb_node_addresses = nb_journal_addresses;
+                if (nb_journal_addresses != 0)
+                {
+                    memcpy(temp_tx_message_pt->hid_message.change_journal.node_addresses, journal_addresses, nb_journal_addresses*sizeof(uint16_t));
+                }
+                comms_aux_mcu_send_message(temp_tx_message_pt);
+                return;
+            }
+            else
+            {
+                /* Set failure byte */
+                comms_hid_msgs_send_ack_nack_message(is_message_from_usb, rcv_message_type, FALSE);
+                return;
+            }
+        }
+
         case HID_CMD_GET_CTR_VALUE:
         {
             /* Read CTR value from flash and send it */
@@ -1679,6 +1809,75 @@ void comms_hid_msgs_parse(hid_message_t* rcv_msg, uint16_t supposed_payload_leng
             }        
         }
         
+        case HID_CMD_STREAM_FILE_DATA_ID:
+        {
+            /* Buffer for decrypted data: chunk N+1 is decrypted in it while chunk N is being sent to the aux MCU */
+            uint8_t buffer[MEMBER_SIZE(child_data_node_t, data) + MEMBER_SIZE(child_data_node_t, data2)];
+            uint16_t decrypted_bytes_nb = 0;
+            uint16_t nb_chunks_sent = 0;
+            
+            /* Check payload length and window size */
+            if ((rcv_msg->payload_length != sizeof(rcv_msg->stream_data_req)) || (rcv_msg->stream_data_req.window_size == 0) || (rcv_msg->stream_data_req.window_size > HID_STREAM_DATA_MAX_WINDOW))
+            {
+                comms_hid_msgs_send_ack_nack_message(is_message_from_usb, rcv_message_type, FALSE);
+                return;
+            }
+            
+            /* Local copy as we're going to send several packets */
+            uint16_t window_size = rcv_msg->stream_data_req.window_size;
+            
+            /* Fetch first chunk of the window: data reading must have been started with a get file data / access note request */
+            if (logic_user_get_next_data_chunk(buffer, &decrypted_bytes_nb, is_message_from_usb) != RETURN_OK)
+            {
+                comms_hid_msgs_send_ack_nack_message(is_message_from_usb, rcv_message_type, FALSE);
+                return;
+            }
+            
+            /* Push chunks until the window is full or there's no more data */
+            while (decrypted_bytes_nb != 0)
+            {
+                /* Aux MCU must have forwarded the previous chunk, stop if it doesn't answer */
+                if ((nb_chunks_sent != 0) && (comms_aux_mcu_wait_for_hid_message_forwarded() != RETURN_OK))
+                {
+                    return;
+                }
+                
+                /* Getting a packet waits for the previous one to be sent */
+                aux_mcu_message_t* temp_tx_message_pt = comms_hid_msgs_get_empty_hid_packet(is_message_from_usb, rcv_message_type, sizeof(hid_message_stream_data_chunk_t) + decrypted_bytes_nb);
+                temp_tx_message_pt->hid_message.stream_data_chunk.packet_type = HID_STREAM_DATA_CHUNK_PKT;
+                temp_tx_message_pt->hid_message.stream_data_chunk.nb_bytes = decrypted_bytes_nb;
+                memcpy((void*)temp_tx_message_pt->hid_message.stream_data_chunk.data, (void*)buffer, decrypted_bytes_nb);
+                comms_aux_mcu_send_message(temp_tx_message_pt);
+                nb_chunks_sent++;
+                
+                /* Window full? */
+                if (nb_chunks_sent == window_size)
+                {
+                    break;
+                }
+                
+                /* Fetch & decrypt next chunk while the previous one is in flight */
+                if (logic_user_get_next_data_chunk(buffer, &decrypted_bytes_nb, is_message_from_usb) != RETURN_OK)
+                {
+                    decrypted_bytes_nb = 0;
+                }
+            }
+            
+            /* Aux MCU must have forwarded the last chunk */
+            if ((nb_chunks_sent != 0) && (comms_aux_mcu_wait_for_hid_message_forwarded() != RETURN_OK))
+            {
+                return;
+            }
+            
+            /* Final packet: number of chunks sent and end of data flag, the host acks the window by requesting the next one */
+            aux_mcu_message_t* temp_tx_message_pt = comms_hid_msgs_get_empty_hid_packet(is_message_from_usb, rcv_message_type, sizeof(hid_message_stream_data_end_t));
+            temp_tx_message_pt->hid_message.stream_data_end.packet_type = HID_STREAM_DATA_END_PKT;
+            temp_tx_message_pt->hid_message.stream_data_end.nb_chunks_sent = nb_chunks_sent;
+            temp_tx_message_pt->hid_message.stream_data_end.end_of_data = (nb_chunks_sent != window_size)? TRUE : FALSE;
+            comms_aux_mcu_send_message(temp_tx_message_pt);
+            return;
+        }
+        
         case HID_CMD_TEST_FILE_ID:
         {
             /* Input sanitazing */
@@ -2169,10 +2368,46 @@ void comms_hid_msgs_parse(hid_message_t* rcv_msg, uint16_t supposed_payload_leng
             temp_tx_message_pt->hid_message.diag_info_message.lifetime_nb_30mins_usb = current_pwr_cons_log_pt->lifetime_nb_30mins_usb;
             cpu_irq_leave_critical();
             
+            /* Database flash read cache statistics */
+            dbflash_get_read_cache_stats(&temp_tx_message_pt->hid_message.diag_info_message.dbflash_read_cache_nb_hits, &temp_tx_message_pt->hid_message.diag_info_message.dbflash_read_cache_nb_misses);
+            
+            /* ... and send message */
+            comms_aux_mcu_send_message(temp_tx_message_pt);
+            return;
+        }
+        
+#ifdef PROFILING_COUNTERS_ENABLED
+        case HID_CMD_GET_PROFILING_DATA:
+        {
+            /* Optional payload: reset counters once read */
+            BOOL reset_counters = FALSE;
+            if ((supposed_payload_length >= 1) && (rcv_msg->payload[0] != 0))
+            {
+                reset_counters = TRUE;
+            }
+            
+            /* Snapshot counters */
+            profilingCounter_t profiling_counters[PROFILING_NB_COUNTERS];
+            _Static_assert(PROFILING_NB_COUNTERS <= HID_PROFILING_MAX_NB_COUNTERS, "Too many profiling counters for one message");
+            timer_profiling_get_counters(profiling_counters, reset_counters);
+            
+            /* Fill answer */
+            uint16_t answer_length = sizeof(hid_message_profiling_data_t) - (HID_PROFILING_MAX_NB_COUNTERS - PROFILING_NB_COUNTERS)*sizeof(hid_message_profiling_counter_t);
+            aux_mcu_message_t* temp_tx_message_pt = comms_hid_msgs_get_empty_hid_packet(is_message_from_usb, rcv_message_type, answer_length);
+            temp_tx_message_pt->hid_message.profiling_data.cycles_per_second = PROFILING_CYCLES_PER_SECOND;
+            temp_tx_message_pt->hid_message.profiling_data.nb_counters = PROFILING_NB_COUNTERS;
+            for (uint16_t i = 0; i < PROFILING_NB_COUNTERS; i++)
+            {
+                temp_tx_message_pt->hid_message.profiling_data.counters[i].nb_calls = profiling_counters[i].nb_calls;
+                temp_tx_message_pt->hid_message.profiling_data.counters[i].nb_cycles_msb = (uint32_t)(profiling_counters[i].nb_cycles >> 32);
+                temp_tx_message_pt->hid_message.profiling_data.counters[i].nb_cycles_lsb = (uint32_t)profiling_counters[i].nb_cycles;
+            }
+            
             /* ... and send message */
             comms_aux_mcu_send_message(temp_tx_message_pt);
             return;
         }
+#endif
         
         default: 
         {
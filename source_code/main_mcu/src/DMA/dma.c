@@ -19,6 +19,8 @@
 *    Created:  03/03/2018
 *    Author:   Mathieu Stephan
 */
+#include <string.h>
+#include <stddef.h>
 #include <asf.h>
 #include "platform_defines.h"
 #include "comms_aux_mcu.h"
@@ -48,7 +50,152 @@ volatile BOOL dma_aux_mcu_packet_received = FALSE;
 volatile BOOL dma_aux_mcu_packet_sent = TRUE;
 /* Boolean to specify if DMA needs to be rearmed to receive an aux MCU packet (use with caution) */
 volatile BOOL dma_aux_mcu_rx_transfer_to_be_rearmed = TRUE;
+#ifndef BOOTLOADER
+/* Boolean set when compact frames were negotiated with the aux MCU */
+volatile BOOL dma_aux_mcu_compact_frames_enabled = FALSE;
+/* Compact frames: set when we lost sync, full frames are then sent until the aux MCU does the same */
+volatile BOOL dma_aux_mcu_compact_frames_desync = FALSE;
+/* Compact frames: set when a frame was lost, to be reported by the comms layer */
+volatile BOOL dma_aux_mcu_compact_frame_lost = FALSE;
+/* Compact frames: reception stage, message being received and length of its second part */
+volatile dma_aux_rx_stage_te dma_aux_mcu_rx_stage = DMA_AUX_RX_STAGE_FULL;
+aux_mcu_message_t* volatile dma_aux_mcu_rx_message_pt;
+volatile uint16_t dma_aux_mcu_rx_second_part_length;
+/* Compact frames: descriptor linked to the header one, receiving the rest of the frame */
+DmacDescriptor dma_aux_mcu_rx_second_part_descriptor __attribute__ ((aligned (16)));
+/* Compact frames: message being sent, its payload_length1 flag & magic are cleared once sent */
+aux_mcu_message_t* volatile dma_aux_mcu_tx_message_pt = 0;
+#endif
 
+/* The compact frame header is decoded on its own */
+_Static_assert(AUX_MCU_MSG_HEADER_LENGTH == offsetof(aux_mcu_message_t, payload), "Invalid aux MCU message header length");
+_Static_assert((AUX_MCU_MSG_PAYLOAD_LENGTH & AUX_MCU_MSG_COMPACT_FRAME_MASK) == 0, "Payload length overlaps compact frame flag & magic");
+
+
+#ifndef BOOTLOADER
+/*! \fn     dma_aux_mcu_arm_rx_descriptor(void* datap, uint16_t size, DmacDescriptor* next_descriptor)
+*   \brief  Setup and enable the aux MCU RX DMA channel
+*   \param  datap           Pointer to where to store the data
+*   \param  size            Number of bytes for transfer
+*   \param  next_descriptor Descriptor to link to this transfer, or 0
+*   \note   To be called with interrupts disabled
+*   \note   Errata 15683 doesn't apply to linked descriptors on the RX comms channel, as it is channel 0
+*/
+static void dma_aux_mcu_arm_rx_descriptor(void* datap, uint16_t size, DmacDescriptor* next_descriptor)
+{
+    /* Setup transfer size */
+    dma_descriptors[DMA_DESCID_RX_COMMS].BTCNT.bit.BTCNT = (uint16_t)size;
+    /* Source address: DATA register from SPI */
+    dma_descriptors[DMA_DESCID_RX_COMMS].DSTADDR.reg = (uint32_t)datap + size;
+    /* Destination address: given value */
+    dma_descriptors[DMA_DESCID_RX_COMMS].SRCADDR.reg = (uint32_t)&AUXMCU_SERCOM->USART.DATA.reg;
+    /* Next descriptor */
+    dma_descriptors[DMA_DESCID_RX_COMMS].DESCADDR.reg = (uint32_t)next_descriptor;
+    /* Write-back descriptor is only updated once the channel runs */
+    dma_writeback_descriptors[DMA_DESCID_RX_COMMS].BTCNT.reg = (uint16_t)size;
+    
+    /* Resume DMA channel operation */
+    DMAC->CHID.reg= DMAC_CHID_ID(DMA_DESCID_RX_COMMS);
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+}
+
+/*! \fn     dma_aux_mcu_arm_rx_compact_frame(aux_mcu_message_t* message_pt)
+*   \brief  Arm reception of a compact or full frame: header, then the rest of a full frame through a linked descriptor
+*   \param  message_pt  Pointer to where to store the message
+*   \note   To be called with interrupts disabled
+*/
+static void dma_aux_mcu_arm_rx_compact_frame(aux_mcu_message_t* message_pt)
+{
+    /* Second part: same setup as the header descriptor, generates an interrupt once done */
+    dma_aux_mcu_rx_second_part_descriptor.BTCTRL.reg = dma_descriptors[DMA_DESCID_RX_COMMS].BTCTRL.reg;
+    dma_aux_mcu_rx_second_part_descriptor.BTCNT.bit.BTCNT = sizeof(aux_mcu_message_t) - AUX_MCU_MSG_HEADER_LENGTH;
+    dma_aux_mcu_rx_second_part_descriptor.DSTADDR.reg = (uint32_t)message_pt + sizeof(aux_mcu_message_t);
+    dma_aux_mcu_rx_second_part_descriptor.SRCADDR.reg = (uint32_t)&AUXMCU_SERCOM->USART.DATA.reg;
+    dma_aux_mcu_rx_second_part_descriptor.DESCADDR.reg = 0;
+    
+    /* Header: interrupt once received, the channel then carries on with the second part descriptor */
+    dma_aux_mcu_rx_message_pt = message_pt;
+    dma_aux_mcu_rx_stage = DMA_AUX_RX_STAGE_HEADER;
+    dma_aux_mcu_arm_rx_descriptor((void*)message_pt, AUX_MCU_MSG_HEADER_LENGTH, &dma_aux_mcu_rx_second_part_descriptor);
+}
+
+/*! \fn     dma_aux_mcu_end_rx_header(void)
+*   \brief  Frame header received: shorten the reception to the frame length
+*   \return TRUE if the frame was already completely received
+*   \note   Called from the DMA interrupt. The linked descriptor receives the frame until the channel is stopped,
+*           so bytes aren't lost whatever the interrupt latency
+*   \note   A flagged header without a valid magic & length means we lost sync: the rest is received as a full frame
+*/
+static BOOL dma_aux_mcu_end_rx_header(void)
+{
+    aux_mcu_message_t* message_pt = dma_aux_mcu_rx_message_pt;
+    uint16_t payload_length = message_pt->payload_length1 & ~AUX_MCU_MSG_COMPACT_FRAME_MASK;
+    
+    if (((message_pt->payload_length1 & AUX_MCU_MSG_COMPACT_FRAME_MASK) == (AUX_MCU_MSG_COMPACT_FRAME_FLAG | AUX_MCU_MSG_COMPACT_FRAME_MAGIC)) && (payload_length != 0) && (payload_length <= AUX_MCU_MSG_PAYLOAD_LENGTH))
+    {
+        /* Compact frame: stop the channel, incoming bytes are buffered by the USART meanwhile */
+        DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_RX_COMMS);
+        DMAC->CHCTRLA.reg = 0;
+        while(DMAC->CHCTRLA.reg != 0);
+        
+        /* Number of payload bytes already received: write-back descriptor is either the header or the second part one */
+        uint16_t nb_payload_bytes_received = (uint16_t)(dma_writeback_descriptors[DMA_DESCID_RX_COMMS].DSTADDR.reg - dma_writeback_descriptors[DMA_DESCID_RX_COMMS].BTCNT.reg - (uint32_t)message_pt->payload);
+        message_pt->payload_length1 = payload_length;
+        dma_aux_mcu_rx_second_part_length = payload_length;
+        dma_aux_mcu_rx_stage = DMA_AUX_RX_STAGE_SECOND_PART;
+        
+        if (nb_payload_bytes_received < payload_length)
+        {
+            /* Receive the remaining payload bytes only */
+            dma_aux_mcu_arm_rx_descriptor((void*)&message_pt->payload[nb_payload_bytes_received], payload_length - nb_payload_bytes_received, 0);
+            return FALSE;
+        }
+        else if (nb_payload_bytes_received > payload_length)
+        {
+            /* Start of the next frame was received as well: it is lost */
+            dma_aux_mcu_compact_frames_desync = TRUE;
+            dma_aux_mcu_compact_frame_lost = TRUE;
+        }
+        return TRUE;
+    }
+    else
+    {
+        /* Corrupted compact frame header: send full frames from now on */
+        if ((message_pt->payload_length1 & AUX_MCU_MSG_COMPACT_FRAME_FLAG) != 0)
+        {
+            dma_aux_mcu_compact_frames_desync = TRUE;
+            dma_aux_mcu_compact_frame_lost = TRUE;
+        }
+        
+        /* Full frame (flood, invalid or empty payload length...): the second part descriptor receives it */
+        dma_aux_mcu_rx_second_part_length = sizeof(aux_mcu_message_t) - AUX_MCU_MSG_HEADER_LENGTH;
+        dma_aux_mcu_rx_stage = DMA_AUX_RX_STAGE_SECOND_PART;
+        return FALSE;
+    }
+}
+
+/*! \fn     dma_aux_mcu_end_rx_second_part(void)
+*   \brief  Compact frame completely received: clear the non transferred bytes
+*   \note   A full frame with a valid non flagged payload length means the aux MCU isn't using compact frames anymore (reboot)
+*/
+static void dma_aux_mcu_end_rx_second_part(void)
+{
+    aux_mcu_message_t* message_pt = dma_aux_mcu_rx_message_pt;
+    uint16_t nb_bytes_received = AUX_MCU_MSG_HEADER_LENGTH + dma_aux_mcu_rx_second_part_length;
+    
+    if (nb_bytes_received < sizeof(aux_mcu_message_t))
+    {
+        memset((void*)((uint8_t*)message_pt + nb_bytes_received), 0, sizeof(aux_mcu_message_t) - nb_bytes_received);
+    }
+    else if ((message_pt->payload_length1 != 0) && (message_pt->payload_length1 <= AUX_MCU_MSG_PAYLOAD_LENGTH))
+    {
+        dma_aux_mcu_compact_frames_enabled = FALSE;
+        dma_aux_mcu_compact_frames_desync = FALSE;
+    }
+    
+    dma_aux_mcu_rx_stage = DMA_AUX_RX_STAGE_DONE;
+}
+#endif
 
 /*! \fn     DMAC_Handler(void)
 *   \brief  Function called by interrupt when RX is done
@@ -60,11 +207,29 @@ void DMAC_Handler(void)
     DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_RX_COMMS);
     if ((DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL) != 0)
     {
-        /* Set transfer done boolean, clear interrupt */
-        platform_io_set_no_comms();
-        dma_aux_mcu_packet_received = TRUE;
-        DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
-        dma_aux_mcu_rx_transfer_to_be_rearmed = TRUE;
+        BOOL frame_received = TRUE;
+        
+        /* Frame header received: the reception carries on, shorten it for compact frames */
+        if (dma_aux_mcu_rx_stage == DMA_AUX_RX_STAGE_HEADER)
+        {
+            DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+            frame_received = dma_aux_mcu_end_rx_header();
+        }
+        
+        if (frame_received != FALSE)
+        {
+            /* Compact frame: clear what wasn't transferred */
+            if (dma_aux_mcu_rx_stage == DMA_AUX_RX_STAGE_SECOND_PART)
+            {
+                dma_aux_mcu_end_rx_second_part();
+            }
+            
+            /* Set transfer done boolean, clear interrupt */
+            platform_io_set_no_comms();
+            dma_aux_mcu_packet_received = TRUE;
+            DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+            dma_aux_mcu_rx_transfer_to_be_rearmed = TRUE;
+        }
     }
     
     /* AUX MCU RX routine */
@@ -74,6 +239,13 @@ void DMAC_Handler(void)
         /* Arm MCU systick for tx flood protection */
         timer_arm_mcu_systick_for_aux_tx_flood_protection();
         
+        /* Compact frame sent: restore the message payload length */
+        if (dma_aux_mcu_tx_message_pt != 0)
+        {
+            dma_aux_mcu_tx_message_pt->payload_length1 &= ~AUX_MCU_MSG_COMPACT_FRAME_MASK;
+            dma_aux_mcu_tx_message_pt = 0;
+        }
+        
         /* Set transfer done boolean, clear interrupt */
         dma_aux_mcu_packet_sent = TRUE;
         DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
@@ -365,16 +537,38 @@ BOOL dma_acc_check_dma_transfer_flag(void)
 */
 uint16_t dma_aux_mcu_get_remaining_bytes_for_rx_transfer(void)
 {
+    uint16_t nb_remaining_bytes;
+    
     /* Check for active channel */
     DMAC_ACTIVE_Type active_reg_copy = DMAC->ACTIVE;
     if (active_reg_copy.bit.ID == DMA_DESCID_RX_COMMS && active_reg_copy.bit.ABUSY != 0)
     {
-        return active_reg_copy.bit.BTCNT;
+        nb_remaining_bytes = active_reg_copy.bit.BTCNT;
     } 
     else
     {
-        return dma_writeback_descriptors[DMA_DESCID_RX_COMMS].BTCNT.reg;
+        nb_remaining_bytes = dma_writeback_descriptors[DMA_DESCID_RX_COMMS].BTCNT.reg;
+    }
+    
+    #ifndef BOOTLOADER
+    /* Compact frames: express the remaining bytes as if a full message was being received, header not decoded yet: nothing usable */
+    cpu_irq_enter_critical();
+    if (dma_aux_mcu_rx_stage == DMA_AUX_RX_STAGE_HEADER)
+    {
+        nb_remaining_bytes = sizeof(aux_mcu_message_t);
+    }
+    else if (dma_aux_mcu_rx_stage == DMA_AUX_RX_STAGE_SECOND_PART)
+    {
+        nb_remaining_bytes += sizeof(aux_mcu_message_t) - AUX_MCU_MSG_HEADER_LENGTH - dma_aux_mcu_rx_second_part_length;
+    }
+    else if (dma_aux_mcu_rx_stage == DMA_AUX_RX_STAGE_DONE)
+    {
+        nb_remaining_bytes = sizeof(aux_mcu_message_t) - AUX_MCU_MSG_HEADER_LENGTH - dma_aux_mcu_rx_second_part_length;
     }
+    cpu_irq_leave_critical();
+    #endif
+    
+    return nb_remaining_bytes;
 }
 
 /*! \fn     dma_aux_mcu_check_and_clear_dma_transfer_flag(void)
@@ -717,6 +911,74 @@ void dma_aux_mcu_init_tx_transfer(Sercom* sercom, void* datap, uint16_t size)
     cpu_irq_leave_critical();
 }
 
+#ifndef BOOTLOADER
+/*! \fn     dma_aux_mcu_init_compact_tx_transfer(Sercom* sercom, aux_mcu_message_t* message)
+*   \brief  Send a message to the AUX MCU using a compact frame: header, then payload_length1 payload bytes, in a single transfer
+*   \param  sercom      Pointer to a sercom module
+*   \param  message     Pointer to the message
+*   \note   The compact frame flag & magic are set in the message payload_length1 until the transfer is done
+*   \note   Messages with an empty or invalid payload length are sent as a full frame, with a non flagged header
+*/
+void dma_aux_mcu_init_compact_tx_transfer(Sercom* sercom, aux_mcu_message_t* message)
+{
+    /* Wait for previous transfer to be done, as its message payload length gets restored then */
+    while (dma_aux_mcu_packet_sent == FALSE);
+    
+    if ((message->payload_length1 != 0) && (message->payload_length1 <= AUX_MCU_MSG_PAYLOAD_LENGTH))
+    {
+        uint16_t frame_length = AUX_MCU_MSG_HEADER_LENGTH + message->payload_length1;
+        
+        /* Flag header, send header & payload */
+        message->payload_length1 |= AUX_MCU_MSG_COMPACT_FRAME_FLAG | AUX_MCU_MSG_COMPACT_FRAME_MAGIC;
+        dma_aux_mcu_tx_message_pt = message;
+        dma_aux_mcu_init_tx_transfer(sercom, (void*)message, frame_length);
+    }
+    else
+    {
+        dma_aux_mcu_init_tx_transfer(sercom, (void*)message, sizeof(aux_mcu_message_t));
+    }
+}
+
+/*! \fn     dma_aux_mcu_set_compact_frames_enabled(BOOL enabled)
+*   \brief  Enable or disable compact frames for aux MCU comms
+*   \param  enabled     TRUE to enable
+*   \note   Takes effect at the next TX and at the next RX arming
+*/
+void dma_aux_mcu_set_compact_frames_enabled(BOOL enabled)
+{
+    dma_aux_mcu_compact_frames_desync = FALSE;
+    dma_aux_mcu_compact_frames_enabled = enabled;
+}
+
+/*! \fn     dma_aux_mcu_are_compact_frames_enabled(void)
+*   \brief  Know if compact frames are used to send messages to the aux MCU
+*   \return TRUE if compact frames are in use
+*   \note   After a sync loss we keep accepting compact frames but send full frames, so the aux MCU switches back to full frames
+*/
+BOOL dma_aux_mcu_are_compact_frames_enabled(void)
+{
+    if ((dma_aux_mcu_compact_frames_enabled != FALSE) && (dma_aux_mcu_compact_frames_desync == FALSE))
+    {
+        return TRUE;
+    }
+    else
+    {
+        return FALSE;
+    }
+}
+
+/*! \fn     dma_aux_mcu_get_and_clear_compact_frame_lost(void)
+*   \brief  Know if a compact frame was lost (corrupted header, next frame start received with the previous one)
+*   \return TRUE if a frame was lost since the last call
+*/
+BOOL dma_aux_mcu_get_and_clear_compact_frame_lost(void)
+{
+    BOOL return_val = dma_aux_mcu_compact_frame_lost;
+    dma_aux_mcu_compact_frame_lost = FALSE;
+    return return_val;
+}
+#endif
+
 /*! \fn     dma_aux_mcu_disable_transfer(void)
 *   \brief  Disable the DMA transfer for the aux MCU comms
 */
@@ -755,6 +1017,19 @@ void dma_aux_mcu_init_rx_transfer(Sercom* sercom, void* datap, uint16_t size)
     volatile void *usart_data_p = &sercom->USART.DATA.reg;
     cpu_irq_enter_critical();
     
+    #ifndef BOOTLOADER
+    /* Compact frames: the DMA interrupt decodes the header while the rest of the frame is received */
+    if ((dma_aux_mcu_compact_frames_enabled != FALSE) && (size == sizeof(aux_mcu_message_t)))
+    {
+        dma_aux_mcu_arm_rx_compact_frame((aux_mcu_message_t*)datap);
+        dma_aux_mcu_rx_transfer_to_be_rearmed = FALSE;
+        cpu_irq_leave_critical();
+        return;
+    }
+    dma_aux_mcu_rx_stage = DMA_AUX_RX_STAGE_FULL;
+    dma_descriptors[DMA_DESCID_RX_COMMS].DESCADDR.reg = 0;
+    #endif
+    
     /* Setup transfer size */
     dma_descriptors[DMA_DESCID_RX_COMMS].BTCNT.bit.BTCNT = (uint16_t)size;
     /* Source address: DATA register from SPI */
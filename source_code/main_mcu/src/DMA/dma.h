@@ -25,15 +25,23 @@
 #ifndef DMA_H_
 #define DMA_H_
 
+#include "comms_aux_mcu_defines.h"
 #include "platform_defines.h"
 #include "defines.h"
 
+/* Enums */
+typedef enum {DMA_AUX_RX_STAGE_FULL = 0, DMA_AUX_RX_STAGE_HEADER, DMA_AUX_RX_STAGE_SECOND_PART, DMA_AUX_RX_STAGE_DONE} dma_aux_rx_stage_te;
+
 /* Prototypes */
 void dma_oled_init_transfer(Sercom* sercom, void* datap, uint16_t size, uint16_t dma_trigger);
 void dma_acc_init_transfer(Sercom* sercom, void* datap, uint16_t size, uint8_t* read_cmd);
 uint32_t dma_compute_crc32_from_spi(Sercom* sercom, uint32_t size);
 void dma_aux_mcu_init_tx_transfer(Sercom* sercom, void* datap, uint16_t size);
 void dma_aux_mcu_init_rx_transfer(Sercom* sercom, void* datap, uint16_t size);
+void dma_aux_mcu_init_compact_tx_transfer(Sercom* sercom, aux_mcu_message_t* message);
+void dma_aux_mcu_set_compact_frames_enabled(BOOL enabled);
+BOOL dma_aux_mcu_are_compact_frames_enabled(void);
+BOOL dma_aux_mcu_get_and_clear_compact_frame_lost(void);
 void dma_custom_fs_init_transfer(Sercom* sercom, void* datap, uint16_t size);
 BOOL dma_aux_mcu_wait_for_current_packet_reception_and_clear_flag(void);
 uint16_t dma_aux_mcu_get_remaining_bytes_for_rx_transfer(void);
@@ -1,5 +1,7 @@
 #include "dataflash.h"
 #include "emu_dataflash.h"
+#include "emu_latency.h"
+#include "driver_timer.h"
 #include <unistd.h>
 #include <fcntl.h>
 #include <stdio.h>
@@ -44,17 +46,24 @@ void emu_dataflash_init(const char *path)
 void dataflash_write_array_to_memory(spi_flash_descriptor_t* descriptor_pt, uint32_t address, uint8_t* data, uint32_t length){}
 void dataflash_read_data_array(spi_flash_descriptor_t* descriptor_pt, uint32_t address, uint8_t* data, uint32_t length) 
 {
+    PROFILING_START(profiling_start);
+    emu_latency_account(EMU_LATENCY_DATAFLASH, EMU_LATENCY_ACCESS, length);
     lseek(bundle_fd, address, SEEK_SET);
     read(bundle_fd, data, length);
+    PROFILING_STOP(PROFILING_DATAFLASH_READ, profiling_start);
 }
 
 void dataflash_read_bytes_from_opened_transfer(spi_flash_descriptor_t* descriptor_pt, uint8_t* data, uint32_t length) {
+    PROFILING_START(profiling_start);
+    emu_latency_account(EMU_LATENCY_DATAFLASH, EMU_LATENCY_TRANSFER, length);
     read(bundle_fd, data, length);
+    PROFILING_STOP(PROFILING_DATAFLASH_READ, profiling_start);
 }
 
 void dataflash_send_command(spi_flash_descriptor_t* descriptor_pt, uint8_t* data, uint32_t length){}
 void dataflash_send_single_byte_command(spi_flash_descriptor_t* descriptor_pt, uint8_t command){}
 void dataflash_read_data_array_start(spi_flash_descriptor_t* descriptor_pt, uint32_t address) {
+    emu_latency_account(EMU_LATENCY_DATAFLASH, EMU_LATENCY_ACCESS, 0);
     lseek(bundle_fd, address, SEEK_SET);
 }
 
@@ -1,33 +1,117 @@
 #include "dbflash.h"
 #include "emu_storage.h"
+#include "emu_latency.h"
+#include "driver_timer.h"
 
 #include <stdlib.h>
 #include <string.h>
 
+/* Same write-through read cache as the firmware, so its statistics can be checked on the emulator */
+static dbflash_read_cache_entry_t read_cache[DBFLASH_READ_CACHE_NB_ENTRIES];
+static uint32_t read_cache_access_counter = 0;
+static uint32_t read_cache_nb_hits = 0;
+static uint32_t read_cache_nb_misses = 0;
+
+void dbflash_get_read_cache_stats(uint32_t* nb_hits, uint32_t* nb_misses)
+{
+    *nb_hits = read_cache_nb_hits;
+    *nb_misses = read_cache_nb_misses;
+}
+
+void dbflash_read_cache_invalidate(void)
+{
+    for(uint16_t i = 0; i < DBFLASH_READ_CACHE_NB_ENTRIES; i++) {
+        read_cache[i].size = 0;
+    }
+}
+
+static RET_TYPE read_cache_lookup(uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void *data)
+{
+    for(uint16_t i = 0; i < DBFLASH_READ_CACHE_NB_ENTRIES; i++) {
+        dbflash_read_cache_entry_t *e = &read_cache[i];
+        if(e->size != 0 && e->page == pageNumber && offset >= e->offset && offset + dataSize <= e->offset + e->size) {
+            memcpy(data, &e->data[offset - e->offset], dataSize);
+            e->last_used = read_cache_access_counter++;
+            read_cache_nb_hits++;
+            return RETURN_OK;
+        }
+    }
+
+    read_cache_nb_misses++;
+    return RETURN_NOK;
+}
+
+static void read_cache_store(uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void *data)
+{
+    dbflash_read_cache_entry_t *e = &read_cache[0];
+
+    /* Empty or least recently used entry */
+    for(uint16_t i = 0; i < DBFLASH_READ_CACHE_NB_ENTRIES && e->size != 0; i++) {
+        if(read_cache[i].size == 0 || read_cache[i].last_used < e->last_used)
+            e = &read_cache[i];
+    }
+
+    memcpy(e->data, data, dataSize);
+    e->last_used = read_cache_access_counter++;
+    e->page = pageNumber;
+    e->offset = offset;
+    e->size = dataSize;
+}
+
+static void read_cache_write_through(uint16_t pageNumber, uint16_t offset, uint16_t dataSize, const uint8_t *data)
+{
+    for(uint16_t i = 0; i < DBFLASH_READ_CACHE_NB_ENTRIES; i++) {
+        dbflash_read_cache_entry_t *e = &read_cache[i];
+        if(e->size == 0 || e->page != pageNumber || offset >= e->offset + e->size || e->offset >= offset + dataSize)
+            continue;
+
+        uint16_t start = offset > e->offset ? offset : e->offset;
+        uint16_t end = offset + dataSize < e->offset + e->size ? offset + dataSize : e->offset + e->size;
+        memcpy(&e->data[start - e->offset], &data[start - offset], end - start);
+    }
+}
+
 void dbflash_write_data_pattern_to_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize, uint8_t pattern)
 {
-    char *tmp = malloc(dataSize);
+    uint8_t tmp[BYTES_PER_PAGE];
+
+    /* Writes can't be longer than a page on the real chip */
+    if(dataSize > BYTES_PER_PAGE)
+        dataSize = BYTES_PER_PAGE;
+
     memset(tmp, pattern, dataSize);
     dbflash_write_data_to_flash(descriptor_pt, pageNumber, offset, dataSize, tmp);
-    free(tmp);
 }
 
 void dbflash_read_data_from_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void *data)
 {
+    BOOL cacheable = dataSize <= DBFLASH_READ_CACHE_ENTRY_SIZE && offset + dataSize <= BYTES_PER_PAGE;
+    if(cacheable && read_cache_lookup(pageNumber, offset, dataSize, data) == RETURN_OK)
+        return;
+
+    PROFILING_START(profiling_start);
+    emu_latency_account(EMU_LATENCY_DBFLASH, EMU_LATENCY_ACCESS, dataSize);
     emu_dbflash_read(pageNumber * BYTES_PER_PAGE + offset, data, dataSize);
+    PROFILING_STOP(PROFILING_DBFLASH_READ, profiling_start);
+
+    if(cacheable)
+        read_cache_store(pageNumber, offset, dataSize, data);
 }
 
 void dbflash_write_data_to_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void *data)
 {
+    /* Page to buffer transfer, buffer write, then page program */
+    PROFILING_START(profiling_start);
+    emu_latency_account(EMU_LATENCY_DBFLASH, EMU_LATENCY_ACCESS, 0);
+    emu_latency_account(EMU_LATENCY_DBFLASH, EMU_LATENCY_PROGRAM, dataSize);
     emu_dbflash_write(pageNumber * BYTES_PER_PAGE + offset, data, dataSize);
+    PROFILING_STOP(PROFILING_DBFLASH_WRITE, profiling_start);
+    read_cache_write_through(pageNumber, offset, dataSize, data);
 }
 
 void dbflash_page_erase(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber)
 {
-    char *tmp = malloc(BYTES_PER_PAGE);
-    memset(tmp, 0xFF, BYTES_PER_PAGE);
-    dbflash_write_data_to_flash(descriptor_pt, pageNumber, 0, BYTES_PER_PAGE, tmp);
-    free(tmp);
+    dbflash_write_data_pattern_to_flash(descriptor_pt, pageNumber, 0, BYTES_PER_PAGE, 0xFF);
 }
 
 static BOOL initialized = FALSE;
@@ -36,7 +120,7 @@ RET_TYPE dbflash_check_presence(spi_flash_descriptor_t* descriptor_pt)
 {   
     if(!initialized) {
         initialized = TRUE;
-        emu_dbflash_open();
+        emu_dbflash_open(PAGE_COUNT * BYTES_PER_PAGE);
     }
 
     return RETURN_OK;
@@ -10,6 +10,15 @@ void dma_aux_mcu_init_tx_transfer(Sercom* sercom, void* datap, uint16_t size)
     emu_send_aux(datap, size);
 }
 
+// the emulated aux MCU always uses full frames
+void dma_aux_mcu_init_compact_tx_transfer(Sercom* sercom, aux_mcu_message_t* message)
+{
+    emu_send_aux((char*)message, sizeof(*message));
+}
+void dma_aux_mcu_set_compact_frames_enabled(BOOL enabled){}
+BOOL dma_aux_mcu_are_compact_frames_enabled(void){return FALSE;}
+BOOL dma_aux_mcu_get_and_clear_compact_frame_lost(void){return FALSE;}
+
 static BOOL dma_aux_mcu_packet_received = FALSE;
 static char *aux_rcvbuf;
 static int aux_rcv_remain;
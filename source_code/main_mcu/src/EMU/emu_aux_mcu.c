@@ -1,12 +1,14 @@
 #include "emu_aux_mcu.h"
 #include "comms_aux_mcu.h"
 #include "emulator.h"
+#include "emu_latency.h"
 
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
 
 static BOOL typing_return;
+static BOOL typing_done_pending;
 static BOOL response_valid;
 static aux_mcu_message_t response;
 static BOOL has_been_already_paired_to_device = FALSE;
@@ -24,12 +26,19 @@ void emu_send_aux(char *data, int size)
     assert(size == sizeof(aux_mcu_message_t));
     assert(response_valid == FALSE);
 
+    emu_latency_account(EMU_LATENCY_AUX, EMU_LATENCY_ACCESS, size);
+
     switch(msg->message_type) {
         case AUX_MCU_MSG_TYPE_USB:
             send_hid_message(msg);
             break;
             
         case AUX_MCU_MSG_TYPE_KEYBOARD_TYPE:
+            /* queued symbols are "typed" right away, completion event sent on next receive */
+            if((msg->keyboard_type_message.interface_identifier & KEYBOARD_TYPE_QUEUE_FLAG) != 0) {
+                typing_done_pending = TRUE;
+                break;
+            }
             memset(&response, 0, sizeof(response));
             response.message_type = AUX_MCU_MSG_TYPE_KEYBOARD_TYPE;
             response.payload_as_uint16[0] = (uint16_t)typing_return;
@@ -215,6 +224,13 @@ static BOOL process_main_cmd(aux_mcu_message_t *msg, aux_mcu_message_t *resp)
             resp->payload_length1 = sizeof(resp->aux_mcu_event_message.event_id);
             return TRUE;
 
+        case MAIN_MCU_COMMAND_HID_MSG_SYNC:
+            /* HID messages are forwarded as soon as they're sent */
+            resp->message_type = AUX_MCU_MSG_TYPE_AUX_MCU_EVENT;
+            resp->aux_mcu_event_message.event_id = AUX_MCU_EVENT_HID_MSG_SYNCED;
+            resp->payload_length1 = sizeof(resp->aux_mcu_event_message.event_id);
+            return TRUE;
+
         case MAIN_MCU_COMMAND_DETACH_USB:
             emu_charger_status = LB_IDLE;
             emu_charger_enable(FALSE);
@@ -239,11 +255,26 @@ int emu_rcv_aux(char *data, int size)
     assert(size == sizeof(aux_mcu_message_t));
 
     if(response_valid) {
+        emu_latency_account(EMU_LATENCY_AUX, EMU_LATENCY_ACCESS, sizeof(response));
         memcpy(data, &response, sizeof(response));
         response_valid = FALSE;
         return sizeof(response);
     }
 
+    /* generate "typing done" event for queued symbols */
+    if(typing_done_pending) {
+        typing_done_pending = FALSE;
+        memset(&response, 0, sizeof(response));
+        response.message_type = AUX_MCU_MSG_TYPE_AUX_MCU_EVENT;
+        response.payload_length1 = sizeof(response.aux_mcu_event_message.event_id) + sizeof(uint16_t);
+        response.aux_mcu_event_message.event_id = AUX_MCU_EVENT_TYPING_DONE;
+        response.aux_mcu_event_message.payload_as_uint16[0] = (uint16_t)typing_return;
+        typing_return = !typing_return;
+        emu_latency_account(EMU_LATENCY_AUX, EMU_LATENCY_ACCESS, sizeof(response));
+        memcpy(data, &response, sizeof(response));
+        return sizeof(response);
+    }
+
     /* generate "charging done" message */
     if(emu_charger_status == LB_CHARGE_START_RAMPING) {
         if(emu_get_battery_level() == 100) {
@@ -253,12 +284,17 @@ int emu_rcv_aux(char *data, int size)
             response.message_type = AUX_MCU_MSG_TYPE_AUX_MCU_EVENT;
             response.payload_length1 = sizeof(response.aux_mcu_event_message.event_id);
             response.aux_mcu_event_message.event_id = AUX_MCU_EVENT_CHARGE_DONE;
+            emu_latency_account(EMU_LATENCY_AUX, EMU_LATENCY_ACCESS, sizeof(response));
             memcpy(data, &response, sizeof(response));
             return sizeof(response);
         }
     }
 
-    return emu_rcv_aux_hid((aux_mcu_message_t*)data);
+    int nb = emu_rcv_aux_hid((aux_mcu_message_t*)data);
+    if(nb > 0)
+        emu_latency_account(EMU_LATENCY_AUX, EMU_LATENCY_ACCESS, nb);
+
+    return nb;
 }
 
 /*! \fn     send_hid_message(aux_mcu_message_t *msg)
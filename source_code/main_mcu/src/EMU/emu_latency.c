@@ -0,0 +1,130 @@
+#include "emu_latency.h"
+#include "platform_defines.h"
+#include "emulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Byte durations derived from the real bus clocks (see platform_defines.h) */
+#define SPI_BYTE_NS(divider)    (8ULL * 2 * ((divider) + 1) * 1000000000ULL / CPU_SPEED_HF)
+/* Aux link: USART at max baud (8x oversampling), 10 bits per byte */
+#define AUX_BYTE_NS             (10ULL * 8 * 1000000000ULL / CPU_SPEED_HF)
+
+typedef struct {
+    const char *name;
+    uint64_t cmd_ns;        // fixed cost of each access (opcode, address, dummy bytes)
+    uint64_t byte_ns;       // cost per transferred byte
+    uint64_t program_ns;    // cost of a non volatile write cycle
+} emu_latency_params_t;
+
+typedef struct {
+    uint64_t nb_ops;
+    uint64_t nb_bytes;
+    uint64_t nb_programs;
+    uint64_t total_ns;
+} emu_latency_stats_t;
+
+static emu_latency_params_t params[EMU_LATENCY_NB_SUBSYSTEMS] = {
+    /* AT45 db flash: opcode + 3 address + 4 dummy bytes, buffer to page program with built-in erase */
+    [EMU_LATENCY_DBFLASH] = {"dbflash", 8 * SPI_BYTE_NS(DBFLASH_BAUD_DIVIDER), SPI_BYTE_NS(DBFLASH_BAUD_DIVIDER), 12000000},
+    /* Bundle data flash: opcode + 3 address bytes, read only */
+    [EMU_LATENCY_DATAFLASH] = {"dataflash", 4 * SPI_BYTE_NS(DATAFLASH_BAUD_DIVIDER), SPI_BYTE_NS(DATAFLASH_BAUD_DIVIDER), 0},
+    /* Smartcard: address setup, EEPROM erase/write cycle */
+    [EMU_LATENCY_SMARTCARD] = {"smartcard", 2 * SPI_BYTE_NS(SMARTCARD_BAUD_DIVIDER), SPI_BYTE_NS(SMARTCARD_BAUD_DIVIDER), 5000000},
+    /* Aux MCU link: whole messages are exchanged */
+    [EMU_LATENCY_AUX] = {"aux", 0, AUX_BYTE_NS, 0},
+};
+
+static emu_latency_stats_t stats[EMU_LATENCY_NB_SUBSYSTEMS];
+static BOOL latency_model_enabled = FALSE;
+
+/* Spec: "default" or a comma separated list of <subsystem>_<cmd|byte|program>_ns=<value> overrides */
+BOOL emu_latency_configure(const char *spec)
+{
+    char *copy = strdup(spec);
+
+    for(char *tok = strtok(copy, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        char *value = strchr(tok, '=');
+        BOOL found = FALSE;
+
+        if(strcmp(tok, "default") == 0)
+            continue;
+
+        if(value != NULL) {
+            *value++ = 0;
+            for(int i = 0; i < EMU_LATENCY_NB_SUBSYSTEMS && !found; i++) {
+                size_t name_len = strlen(params[i].name);
+                const char *field = tok + name_len + 1;
+
+                if(strncmp(tok, params[i].name, name_len) != 0 || tok[name_len] != '_')
+                    continue;
+
+                found = TRUE;
+                if(strcmp(field, "cmd_ns") == 0)
+                    params[i].cmd_ns = strtoull(value, NULL, 0);
+                else if(strcmp(field, "byte_ns") == 0)
+                    params[i].byte_ns = strtoull(value, NULL, 0);
+                else if(strcmp(field, "program_ns") == 0)
+                    params[i].program_ns = strtoull(value, NULL, 0);
+                else
+                    found = FALSE;
+            }
+        }
+
+        if(!found) {
+            fprintf(stderr, "Invalid latency model parameter: %s\n", tok);
+            free(copy);
+            return FALSE;
+        }
+    }
+
+    free(copy);
+    latency_model_enabled = TRUE;
+    return TRUE;
+}
+
+void emu_latency_account(emu_latency_subsystem_te subsystem, emu_latency_op_te op, uint32_t nb_bytes)
+{
+    if(!latency_model_enabled)
+        return;
+
+    emu_latency_params_t *p = &params[subsystem];
+    emu_latency_stats_t *s = &stats[subsystem];
+    uint64_t ns = p->byte_ns * nb_bytes;
+
+    if(op == EMU_LATENCY_PROGRAM) {
+        ns += p->cmd_ns + p->program_ns;
+        s->nb_programs++;
+        s->nb_ops++;
+    } else if(op == EMU_LATENCY_ACCESS) {
+        ns += p->cmd_ns;
+        s->nb_ops++;
+    }
+
+    s->nb_bytes += nb_bytes;
+    s->total_ns += ns;
+
+    /* In virtual time mode, the device spends that time waiting for the bus */
+    emu_consume_time_ns(ns);
+}
+
+void emu_latency_report(void)
+{
+    uint64_t total_ns = 0;
+
+    if(!latency_model_enabled)
+        return;
+
+    for(int i = 0; i < EMU_LATENCY_NB_SUBSYSTEMS; i++)
+        total_ns += stats[i].total_ns;
+
+    fprintf(stderr, "Latency model, %llu ms emulated:\n", (unsigned long long)emu_get_elapsed_ms());
+    fprintf(stderr, "%-10s %10s %12s %10s %12s %7s\n", "subsystem", "accesses", "bytes", "programs", "time (ms)", "share");
+    for(int i = 0; i < EMU_LATENCY_NB_SUBSYSTEMS; i++) {
+        fprintf(stderr, "%-10s %10llu %12llu %10llu %12.3f %6.1f%%\n", params[i].name,
+                (unsigned long long)stats[i].nb_ops, (unsigned long long)stats[i].nb_bytes, (unsigned long long)stats[i].nb_programs,
+                stats[i].total_ns / 1e6, total_ns ? stats[i].total_ns * 100.0 / total_ns : 0.0);
+    }
+    fprintf(stderr, "%-10s %10s %12s %10s %12.3f\n", "total", "", "", "", total_ns / 1e6);
+}
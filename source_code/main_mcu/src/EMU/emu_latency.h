@@ -0,0 +1,33 @@
+#ifndef EMU_LATENCY_H
+#define EMU_LATENCY_H
+#include <inttypes.h>
+#include "defines.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Optional timing model of the slow peripherals: the emulator answers them instantly */
+typedef enum {
+    EMU_LATENCY_DBFLASH = 0,
+    EMU_LATENCY_DATAFLASH,
+    EMU_LATENCY_SMARTCARD,
+    EMU_LATENCY_AUX,
+    EMU_LATENCY_NB_SUBSYSTEMS
+} emu_latency_subsystem_te;
+
+typedef enum {
+    EMU_LATENCY_ACCESS = 0,     // new command: fixed cost + bytes
+    EMU_LATENCY_TRANSFER,       // bytes of an already started transfer
+    EMU_LATENCY_PROGRAM         // non volatile write cycle + bytes
+} emu_latency_op_te;
+
+BOOL emu_latency_configure(const char *spec);
+void emu_latency_account(emu_latency_subsystem_te subsystem, emu_latency_op_te op, uint32_t nb_bytes);
+void emu_latency_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,6 +7,7 @@ extern "C" {
 }
 
 #include "qt_metacall_helper.h"
+#include "emu_script.h"
 #include <QMutex>
 #include <QSemaphore>
 #include <QApplication>
@@ -16,6 +17,9 @@ extern "C" {
 #include <QKeyEvent>
 #include <QThread>
 #include <QTimer>
+#include <QDir>
+#include <QFile>
+#include <cstdio>
 
 #define FB_WIDTH (256)
 #define FB_HEIGHT (64)
@@ -92,9 +96,121 @@ static QMutex fb_update;
 static uint8_t framebuffers[2][256*64];
 static int fb_next=0, fb_pending=-1;
 
+// last flushed frame, used to skip flushes that don't change the display
+static uint64_t last_flushed_hash;
+static bool last_flushed_hash_valid = false;
+static bool oled_headless = false;
+
+// frame capture for automated UI runs
+static bool capture_enabled = false;
+static bool capture_raw = false;
+static QDir capture_dir;
+static QFile capture_index;
+static uint32_t nb_flushes = 0, nb_unique_frames = 0;
+static uint64_t first_frame_ms, last_frame_ms;
+
+static uint64_t oled_fb_hash(const uint8_t *fb)
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(int i=0;i<FB_WIDTH*FB_HEIGHT;i++) {
+        hash ^= fb[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static void capture_frame(uint64_t hash, uint64_t timestamp_ms)
+{
+    QString name = QString("frame_%1_%2ms.%3").arg(nb_unique_frames, 6, 10, QChar('0')).arg(timestamp_ms).arg(capture_raw ? "bin" : "png");
+    QString path = capture_dir.filePath(name);
+
+    if(capture_raw) {
+        // 4bpp, 2 pixels per byte: same layout as the SH1122 GDDRAM
+        uint8_t packed[FB_WIDTH * FB_HEIGHT / 2];
+        for(int i=0;i<FB_WIDTH*FB_HEIGHT/2;i++)
+            packed[i] = (oled_fb[2*i] & 0xf0) | (oled_fb[2*i+1] >> 4);
+
+        QFile f(path);
+        if(f.open(QIODevice::WriteOnly))
+            f.write((const char *)packed, sizeof(packed));
+    } else {
+        QImage img(oled_fb, FB_WIDTH, FB_HEIGHT, FB_WIDTH, QImage::Format_Grayscale8);
+        img.save(path);
+    }
+
+    if(capture_index.isOpen()) {
+        QString line = QString("%1,%2,%3\n").arg(timestamp_ms).arg(hash, 16, 16, QChar('0')).arg(name);
+        capture_index.write(line.toUtf8());
+        capture_index.flush();
+    }
+}
+
+void emu_oled_set_headless(bool headless)
+{
+    oled_headless = headless;
+}
+
+bool emu_oled_start_capture(const QString &dir, bool raw)
+{
+    capture_dir = QDir(dir);
+    if(!capture_dir.mkpath(".")) {
+        fprintf(stderr, "Could not create frame capture directory %s\n", dir.toUtf8().constData());
+        return false;
+    }
+
+    capture_index.setFileName(capture_dir.filePath("frames.csv"));
+    if(!capture_index.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        fprintf(stderr, "Could not create %s\n", capture_index.fileName().toUtf8().constData());
+        return false;
+    }
+    capture_index.write("timestamp_ms,hash,file\n");
+
+    capture_raw = raw;
+    capture_enabled = true;
+    return true;
+}
+
+void emu_oled_stop_capture(void)
+{
+    if(!capture_enabled)
+        return;
+
+    capture_enabled = false;
+    capture_index.close();
+
+    uint64_t span_ms = last_frame_ms - first_frame_ms;
+    fprintf(stderr, "OLED: %u flushes, %u unique frames", nb_flushes, nb_unique_frames);
+    if(nb_unique_frames > 1 && span_ms > 0)
+        fprintf(stderr, ", %.2f frames/s over %llu ms", (nb_unique_frames - 1) * 1000.0 / span_ms, (unsigned long long)span_ms);
+    fprintf(stderr, "\n");
+}
+
 void emu_oled_flush(void)
 {
     emu_appexit_test();
+
+    // nothing to do when the display content didn't change since the last flush
+    nb_flushes++;
+    uint64_t hash = oled_fb_hash(oled_fb);
+    if(last_flushed_hash_valid && hash == last_flushed_hash)
+        return;
+
+    last_flushed_hash = hash;
+    last_flushed_hash_valid = true;
+
+    if(capture_enabled) {
+        uint64_t now = emu_get_elapsed_ms();
+        if(nb_unique_frames == 0)
+            first_frame_ms = now;
+        last_frame_ms = now;
+        capture_frame(hash, now);
+        nb_unique_frames++;
+    }
+
+    if(oled_headless)
+        return;
+
     fb_update.lock();
     if(fb_pending >= 0) {
         // an update is queued, just replace the contents
@@ -121,6 +237,7 @@ void emu_oled_flush(void)
 }
 
 OLEDWidget::OLEDWidget(): display(256, 64, QImage::Format_RGB888) {
+    display.fill(Qt::black);
     setMinimumSize(display.size());
     setMaximumSize(display.size());
 }
@@ -132,15 +249,26 @@ OLEDWidget::~OLEDWidget() {
 }
 
 void OLEDWidget::update_display(const uint8_t *fb) {
-    uint8_t *optr = display.bits();
-
-    for(int y=0;y<64;y++)
-        for(int x=0;x<256;x++) {
-            optr[0] = optr[1] = optr[2] = *fb++;
+    int x_min = FB_WIDTH, y_min = FB_HEIGHT, x_max = -1, y_max = -1;
+
+    // only copy and repaint the pixels that changed
+    for(int y=0;y<FB_HEIGHT;y++) {
+        uint8_t *optr = display.scanLine(y);
+        for(int x=0;x<FB_WIDTH;x++) {
+            if(optr[0] != *fb) {
+                optr[0] = optr[1] = optr[2] = *fb;
+                if(x < x_min) x_min = x;
+                if(x > x_max) x_max = x;
+                if(y < y_min) y_min = y;
+                y_max = y;
+            }
+            fb++;
             optr+=3;
         }
-   
-    repaint();
+    }
+
+    if(x_max >= 0)
+        update(QRect(x_min, y_min, x_max - x_min + 1, y_max - y_min + 1));
 }
 
 void OLEDWidget::set_display_on(bool on) {
@@ -206,59 +334,61 @@ extern "C" void inputs_scan(void)
 }
 
 
-void OLEDWidget::wheelEvent(QWheelEvent *evt) {
-    int delta = evt->angleDelta().y()/120;
+void emu_wheel_turn(int increment)
+{
     irq_mutex.lock();
-    inputs_wheel_cur_increment -= delta;
+    inputs_wheel_cur_increment += increment;
     irq_mutex.unlock();
+    emu_script_record(QString("wheel %1").arg(increment));
 }
 
-void OLEDWidget::mousePressEvent(QMouseEvent *evt) {
+void emu_wheel_press(bool pressed, bool long_press)
+{
     irq_mutex.lock();
-    if((evt->button() == Qt::BackButton) || (evt->button() == Qt::RightButton))
-    {
-        set_emulated_wheel_state(true, 3000);
-    }
-    else if(evt->button() == Qt::LeftButton)
-        set_emulated_wheel_state(true, -1);
-
+    set_emulated_wheel_state(pressed, long_press ? 3000 : -1);
     irq_mutex.unlock();
+    emu_script_record(pressed ? (long_press ? "long-press" : "press") : "release");
 }
 
-void OLEDWidget::mouseReleaseEvent(QMouseEvent *evt) {
-    irq_mutex.lock();
+void OLEDWidget::wheelEvent(QWheelEvent *evt) {
+    int delta = evt->angleDelta().y()/120;
+    emu_wheel_turn(-delta);
+}
+
+void OLEDWidget::mousePressEvent(QMouseEvent *evt) {
     if((evt->button() == Qt::BackButton) || (evt->button() == Qt::RightButton))
-        set_emulated_wheel_state(false, -1);
+        emu_wheel_press(true, true);
     else if(evt->button() == Qt::LeftButton)
-        set_emulated_wheel_state(false, -1);
-    irq_mutex.unlock();
+        emu_wheel_press(true, false);
+}
+
+void OLEDWidget::mouseReleaseEvent(QMouseEvent *evt) {
+    if((evt->button() == Qt::BackButton) || (evt->button() == Qt::RightButton) || (evt->button() == Qt::LeftButton))
+        emu_wheel_press(false, false);
 }
 
 void OLEDWidget::keyPressEvent(QKeyEvent *evt) {
-    irq_mutex.lock();
     switch(evt->key()) {
     case Qt::Key_Up:
-        inputs_wheel_cur_increment--;
+        emu_wheel_turn(-1);
         break;
     case Qt::Key_Down:
-        inputs_wheel_cur_increment++;
+        emu_wheel_turn(1);
         break;
     case Qt::Key_Right:
     case Qt::Key_Space:
     case Qt::Key_Enter:
     case Qt::Key_Return:
-        set_emulated_wheel_state(true, -1);
+        emu_wheel_press(true, false);
         break;
     case Qt::Key_Left:
     case Qt::Key_Backspace:
-        set_emulated_wheel_state(true, 3000);
+        emu_wheel_press(true, true);
         break;
     }
-    irq_mutex.unlock();
 }
 
 void OLEDWidget::keyReleaseEvent(QKeyEvent *evt) {
-    irq_mutex.lock();
     switch(evt->key()) {
     case Qt::Key_Right:
     case Qt::Key_Space:
@@ -266,9 +396,7 @@ void OLEDWidget::keyReleaseEvent(QKeyEvent *evt) {
     case Qt::Key_Return:
     case Qt::Key_Left:
     case Qt::Key_Backspace:
-        set_emulated_wheel_state(false, -1);
+        emu_wheel_press(false, false);
         break;
     }
-    irq_mutex.unlock();
-
 }
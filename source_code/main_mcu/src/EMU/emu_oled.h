@@ -26,6 +26,13 @@ protected:
     virtual void keyReleaseEvent(QKeyEvent *evt);
 };
 
+void emu_oled_set_headless(bool headless);
+bool emu_oled_start_capture(const QString &dir, bool raw);
+void emu_oled_stop_capture(void);
+
+void emu_wheel_turn(int increment);
+void emu_wheel_press(bool pressed, bool long_press);
+
 extern "C" {
 #endif
 
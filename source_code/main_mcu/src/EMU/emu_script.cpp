@@ -0,0 +1,194 @@
+#include "emu_script.h"
+#include "emulator.h"
+#include "emu_oled.h"
+#include "emu_smartcard.h"
+
+#include <QApplication>
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <cstdio>
+#include <cstring>
+
+struct script_event_t {
+    uint64_t timestamp_ms;
+    QStringList args;
+    int line;
+};
+
+static QMutex script_mutex;
+static QVector<script_event_t> script_events;
+static int script_next_event = 0;
+static QByteArray injected_hid;
+
+static QMutex record_mutex;
+static QFile record_file;
+
+bool emu_script_load(const QString &path)
+{
+    QFile f(path);
+    if(!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        fprintf(stderr, "Could not open script %s\n", path.toUtf8().constData());
+        return false;
+    }
+
+    QVector<script_event_t> events;
+    uint64_t last_timestamp = 0;
+    int line_nb = 0;
+
+    QTextStream in(&f);
+    while(!in.atEnd()) {
+        QString line = in.readLine();
+        line_nb++;
+
+        int comment = line.indexOf('#');
+        if(comment >= 0)
+            line.truncate(comment);
+
+        QStringList args = line.split(' ', QString::SkipEmptyParts);
+        if(args.isEmpty())
+            continue;
+
+        bool ok = false;
+        script_event_t evt;
+        evt.timestamp_ms = args.takeFirst().toULongLong(&ok);
+        evt.args = args;
+        evt.line = line_nb;
+        if(!ok || args.isEmpty() || evt.timestamp_ms < last_timestamp) {
+            fprintf(stderr, "%s:%d: invalid event\n", path.toUtf8().constData(), line_nb);
+            return false;
+        }
+
+        last_timestamp = evt.timestamp_ms;
+        events.append(evt);
+    }
+
+    script_mutex.lock();
+    script_events = events;
+    script_next_event = 0;
+    script_mutex.unlock();
+    return true;
+}
+
+bool emu_script_start_recording(const QString &path)
+{
+    QMutexLocker locker(&record_mutex);
+    record_file.setFileName(path);
+    if(!record_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        fprintf(stderr, "Could not create %s\n", path.toUtf8().constData());
+        return false;
+    }
+    return true;
+}
+
+void emu_script_stop_recording(void)
+{
+    QMutexLocker locker(&record_mutex);
+    record_file.close();
+}
+
+void emu_script_record(const QString &event)
+{
+    QMutexLocker locker(&record_mutex);
+    if(!record_file.isOpen())
+        return;
+
+    QString line = QString("%1 %2\n").arg(emu_get_elapsed_ms()).arg(event);
+    record_file.write(line.toUtf8());
+    record_file.flush();
+}
+
+void emu_script_record_hid(const char *event, const char *data, int size)
+{
+    record_mutex.lock();
+    bool recording = record_file.isOpen();
+    record_mutex.unlock();
+    if(!recording)
+        return;
+
+    emu_script_record(QString("%1 %2").arg(event).arg(QString(QByteArray(data, size).toHex())));
+}
+
+int emu_script_get_injected_hid(char *data, int size)
+{
+    QMutexLocker locker(&script_mutex);
+    int nb = qMin(size, injected_hid.size());
+    if(nb > 0) {
+        memcpy(data, injected_hid.constData(), nb);
+        injected_hid.remove(0, nb);
+    }
+    return nb;
+}
+
+static void run_event(const script_event_t &evt)
+{
+    const QString &cmd = evt.args[0];
+    const QString arg = evt.args.value(1);
+
+    if(cmd == "wheel") {
+        emu_wheel_turn(arg.toInt());
+
+    } else if(cmd == "press" || cmd == "long-press") {
+        emu_wheel_press(true, cmd == "long-press");
+
+    } else if(cmd == "release") {
+        emu_wheel_press(false, false);
+
+    } else if(cmd == "card") {
+        QString file = evt.args.mid(2).join(' ');
+        bool ok = true;
+        if(arg == "insert")
+            ok = emu_insert_smartcard(file);
+        else if(arg == "new")
+            ok = emu_insert_new_smartcard(file, EMU_SMARTCARD_REGULAR);
+        else if(arg == "invalid")
+            ok = emu_insert_new_smartcard(QString(), EMU_SMARTCARD_INVALID);
+        else if(arg == "broken")
+            ok = emu_insert_new_smartcard(QString(), EMU_SMARTCARD_BROKEN);
+        else if(arg == "remove")
+            emu_remove_smartcard();
+        else
+            ok = false;
+
+        if(ok)
+            emu_script_record(evt.args.join(' '));
+        else
+            fprintf(stderr, "script line %d: card event failed\n", evt.line);
+
+    } else if(cmd == "hid") {
+        QByteArray data = QByteArray::fromHex(arg.toLatin1());
+        script_mutex.lock();
+        injected_hid.append(data);
+        script_mutex.unlock();
+        emu_script_record_hid("hid", data.constData(), data.size());
+
+    } else if(cmd == "hid-out") {
+        // device output from a recording, nothing to replay
+
+    } else if(cmd == "quit") {
+        emu_script_record("quit");
+        QMetaObject::invokeMethod(qApp, "quit", Qt::QueuedConnection);
+
+    } else {
+        fprintf(stderr, "script line %d: unknown event %s\n", evt.line, cmd.toUtf8().constData());
+    }
+}
+
+void emu_script_tick(void)
+{
+    uint64_t now = emu_get_elapsed_ms();
+
+    script_mutex.lock();
+    while(script_next_event < script_events.size() && script_events[script_next_event].timestamp_ms <= now) {
+        script_event_t evt = script_events[script_next_event++];
+
+        // events may take other locks (irq, smartcard): run them without holding ours
+        script_mutex.unlock();
+        run_event(evt);
+        script_mutex.lock();
+    }
+    script_mutex.unlock();
+}
@@ -0,0 +1,29 @@
+#ifndef EMU_SCRIPT_H
+#define EMU_SCRIPT_H
+
+#include <QString>
+
+/* Scripted input / session recording
+ * One event per line: "<timestamp_ms> <event> [args]", '#' starts a comment
+ *   wheel <increment>        turn the wheel (positive: down)
+ *   press | long-press       press the wheel (long-press: reported as a 3s press)
+ *   release                  release the wheel
+ *   card insert <file>       insert an existing smartcard image
+ *   card new <file>          insert a new blank smartcard, stored in <file>
+ *   card invalid | broken    insert an invalid / broken smartcard
+ *   card remove              remove the smartcard
+ *   hid <hex bytes>          raw data sent by the host on the HID socket
+ *   hid-out <hex bytes>      raw data sent by the device (recorded only, ignored on replay)
+ *   quit                     quit the emulator
+ * Timestamps are emulator time (see emu_get_elapsed_ms), so recordings can be replayed as is
+ */
+
+bool emu_script_load(const QString &path);
+bool emu_script_start_recording(const QString &path);
+void emu_script_stop_recording(void);
+void emu_script_tick(void);
+void emu_script_record(const QString &event);
+void emu_script_record_hid(const char *event, const char *data, int size);
+int emu_script_get_injected_hid(char *data, int size);
+
+#endif
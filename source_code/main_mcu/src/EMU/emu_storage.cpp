@@ -1,11 +1,27 @@
 #include "emu_storage.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <QDebug>
 #include <QFile>
 
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// default to the working directory, see emu_storage_set_paths()
 static QFile eeprom("eeprom.bin");
 static QFile dbflash("dbflash.bin");
+
+// dbflash image is memory mapped, only synced to disk on each write when asked to
+static uchar *dbflash_map = NULL;
+static int dbflash_map_size = 0;
+static bool dbflash_sync_on_write = false;
+
 static bool emu_open_flash(QFile & flashFile)
 {
     if(!flashFile.open(QIODevice::ReadWrite)) {
@@ -49,6 +65,17 @@ static void emu_flash_write(QFile & flashFile, int offset, uint8_t *buf, int len
     }
 }
 
+void emu_storage_set_paths(const QString &eeprom_path, const QString &dbflash_path)
+{
+    // only valid before the firmware opens its storage
+    Q_ASSERT(!eeprom.isOpen() && !dbflash.isOpen());
+
+    if(!eeprom_path.isEmpty())
+        eeprom.setFileName(eeprom_path);
+    if(!dbflash_path.isEmpty())
+        dbflash.setFileName(dbflash_path);
+}
+
 BOOL emu_eeprom_open()
 {
     return emu_open_flash(eeprom);
@@ -64,18 +91,55 @@ void emu_eeprom_write(int offset, uint8_t *buf, int length)
     return emu_flash_write(eeprom, offset, buf, length);
 }
 
-BOOL emu_dbflash_open()
+void emu_dbflash_set_sync_on_write(BOOL sync_on_write)
 {
-    return emu_open_flash(dbflash);
+    dbflash_sync_on_write = sync_on_write != FALSE;
+}
+
+BOOL emu_dbflash_open(int size)
+{
+    BOOL was_populated = emu_open_flash(dbflash);
+
+    // preallocate the whole image once, then map it
+    emu_extend_flash(dbflash, size);
+    dbflash_map = dbflash.map(0, size);
+    if(dbflash_map == NULL) {
+        qWarning() << "Failed to map emulated flash" << dbflash.fileName();
+        abort();
+    }
+    dbflash_map_size = size;
+
+    return was_populated;
+}
+
+static void emu_dbflash_sync(int offset, int length)
+{
+#ifdef Q_OS_WIN
+    FlushViewOfFile(dbflash_map + offset, length);
+    FlushFileBuffers((HANDLE)_get_osfhandle(dbflash.handle()));
+#else
+    // msync needs a page aligned address
+    long page_size = sysconf(_SC_PAGESIZE);
+    int aligned_offset = offset - (offset % page_size);
+    msync(dbflash_map + aligned_offset, length + offset - aligned_offset, MS_SYNC);
+#endif
 }
 
 void emu_dbflash_read(int offset, uint8_t *buf, int length)
 {
-    return emu_flash_read(dbflash, offset, buf, length);
+    if(dbflash_map != NULL && offset >= 0 && offset + length <= dbflash_map_size) {
+        memcpy(buf, dbflash_map + offset, length);
+    } else {
+        memset(buf, 0xff, length);
+    }
 }
 
 void emu_dbflash_write(int offset, uint8_t *buf, int length)
 {
-    return emu_flash_write(dbflash, offset, buf, length);
-}
+    if(dbflash_map != NULL && offset >= 0 && offset + length <= dbflash_map_size) {
+        memcpy(dbflash_map + offset, buf, length);
 
+        if(dbflash_sync_on_write)
+            emu_dbflash_sync(offset, length);
+    }
+}
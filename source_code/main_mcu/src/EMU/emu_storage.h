@@ -11,12 +11,16 @@ BOOL emu_eeprom_open(void);
 void emu_eeprom_read(int offset, uint8_t *buf, int length);
 void emu_eeprom_write(int offset, uint8_t *buf, int length);
 
-BOOL emu_dbflash_open(void);
+BOOL emu_dbflash_open(int size);
+void emu_dbflash_set_sync_on_write(BOOL sync_on_write);
 void emu_dbflash_read(int offset, uint8_t *buf, int length);
 void emu_dbflash_write(int offset, uint8_t *buf, int length);
 
 #ifdef __cplusplus
 }
+
+#include <QString>
+void emu_storage_set_paths(const QString &eeprom_path, const QString &dbflash_path);
 #endif
 
 
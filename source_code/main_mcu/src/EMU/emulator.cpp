@@ -16,11 +16,18 @@ extern "C" {
 #include <QLocalSocket>
 #include <QCommandLineParser>
 #include <QElapsedTimer>
+#include <QAtomicInteger>
+#include <QDir>
+#include <cstdio>
+#include <cstring>
 
 #include "emu_oled.h"
 #include "emu_smartcard.h"
 #include "emu_dataflash.h"
+#include "emu_storage.h"
 #include "emulator_ui.h"
+#include "emu_script.h"
+#include "emu_latency.h"
 
 static struct emu_port_t _PORT;
 struct emu_port_t *PORT=&_PORT;
@@ -37,9 +44,8 @@ void cpu_irq_leave_critical(void)
     irq_mutex.unlock();
 }
 
-static void pseudo_irq(void)
+static void pseudo_irq_locked(void)
 {
-    irq_mutex.lock();
     timer_ms_tick();
 
     /* Scan buttons */
@@ -47,8 +53,65 @@ static void pseudo_irq(void)
     
     /* Power logic */
     logic_power_ms_tick();
+}
+
+static void pseudo_irq(void)
+{
+    irq_mutex.lock();
+    pseudo_irq_locked();
+    irq_mutex.unlock();
+}
+
+/* Virtual time: the clock only moves forward when the app thread idles */
+static bool virtual_time = false;
+static QAtomicInteger<quint64> virtual_ms;
+static uint64_t virtual_time_limit_ms = 0;
+
+// milliseconds and nanoseconds the app thread owes to the virtual clock (only touched by the app thread)
+static uint64_t virtual_pending_ms = 0;
+static uint64_t virtual_pending_ns = 0;
+
+static void advance_virtual_time(uint64_t nb_ms)
+{
+    virtual_pending_ms += nb_ms;
 
+    // the app thread may already be in a critical section: the "irqs" will then fire at the next call
+    if(!irq_mutex.tryLock())
+        return;
+
+    uint64_t now = virtual_ms;
+    for(; virtual_pending_ms > 0; virtual_pending_ms--) {
+        now = ++virtual_ms;
+        pseudo_irq_locked();
+    }
     irq_mutex.unlock();
+
+    emu_script_tick();
+
+    static bool quit_requested = false;
+    if(virtual_time_limit_ms != 0 && now >= virtual_time_limit_ms && !quit_requested) {
+        quit_requested = true;
+        QMetaObject::invokeMethod(qApp, "quit", Qt::QueuedConnection);
+    }
+}
+
+void emu_idle(void)
+{
+    if(virtual_time)
+        advance_virtual_time(1);
+}
+
+void emu_consume_time_ns(uint64_t ns)
+{
+    if(!virtual_time)
+        return;
+
+    virtual_pending_ns += ns;
+    if(virtual_pending_ns >= 1000000) {
+        uint64_t nb_ms = virtual_pending_ns / 1000000;
+        virtual_pending_ns %= 1000000;
+        advance_virtual_time(nb_ms);
+    }
 }
 
 extern "C" void minible_main();
@@ -60,10 +123,11 @@ private:
     QSemaphore app_thread_blocked;
 
     QLocalSocket *hid;
+    QString hid_socket_name = "moolticuted_local_dev";
 
     bool reconnect_hid() {
         if(hid->state() != QLocalSocket::ConnectedState) {
-            hid->connectToServer("moolticuted_local_dev");
+            hid->connectToServer(hid_socket_name);
             hid->waitForConnected(10);
         }
         
@@ -76,6 +140,11 @@ public:
         minible_main();
     }
 
+    // must be called before the thread is started
+    void set_hid_socket_name(const QString &name) {
+        hid_socket_name = name;
+    }
+
     void stop() {
         appexit_mutex.lock();
         app_exiting = true;
@@ -113,11 +182,19 @@ public:
 
     int rcv_hid(char *data, int size) {
         test_stop();
+
+        // scripted packets take precedence over the socket
+        int nb = emu_script_get_injected_hid(data, size);
+        if(nb > 0)
+            return nb;
+
         if(!reconnect_hid())
             return -1;
 
         hid->waitForReadyRead(0);
-        int nb = hid->read(data, size);
+        nb = hid->read(data, size);
+        if(nb > 0)
+            emu_script_record_hid("hid", data, nb);
         return nb > 0 ? nb : 0;
     }
 };
@@ -132,23 +209,47 @@ OLEDWidget *oled;
 
 void emu_send_hid(char *data, int size)
 {
+    emu_script_record_hid("hid-out", data, size);
     app_thread.send_hid(data, size);
 }
 
 int emu_rcv_hid(char *data, int size)
 {
-    return app_thread.rcv_hid(data, size);
+    int nb = app_thread.rcv_hid(data, size);
+
+    // nothing received: the main loop has nothing to do
+    if(nb <= 0)
+        emu_idle();
+
+    return nb;
 }
 
 static QElapsedTimer systick_timer;
 static QMutex systick_mutex;
 static uint64_t last_systick;
 
+uint64_t emu_get_elapsed_ms(void)
+{
+    if(virtual_time)
+        return virtual_ms;
+
+    return systick_timer.elapsed();
+}
+
+uint32_t emu_get_cycle_counter(void)
+{
+    // 48MHz cycles, wrapping like the device counter
+    if(virtual_time)
+        return (uint32_t)(virtual_ms * (uint64_t)48000);
+
+    return (uint32_t)(systick_timer.nsecsElapsed() * 48 / 1000);
+}
+
 BOOL emu_get_systick(uint32_t *value)
 {
     systick_mutex.lock();
     // milliseconds to 48MHz ticks
-    uint64_t systick = systick_timer.elapsed() * (uint64_t)48000;
+    uint64_t systick = emu_get_elapsed_ms() * (uint64_t)48000;
     BOOL wrapped = FALSE;
     if((systick & 0xffffff) != (last_systick & 0xffffff))
         wrapped = TRUE;
@@ -162,6 +263,14 @@ BOOL emu_get_systick(uint32_t *value)
 
 int main(int ac, char ** av)
 {
+    // headless runs (CI) must not need a windowing system: select the platform plugin before creating the application
+    bool headless = false;
+    for(int i=1;i<ac;i++)
+        if(strcmp(av[i], "--headless") == 0)
+            headless = true;
+    if(headless)
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
     // Qt needs to run on the main thread. We run the application code on a separate thread
     // (1) to ensure responsiveness when the main code blocks
     // (2) to have our input behave in an interrupt-like manner
@@ -177,16 +286,33 @@ int main(int ac, char ** av)
 
     parser.addOption(QCommandLineOption("smartcard", "Smartcard file to be used at startup", "smartcard"));
     parser.addOption(QCommandLineOption("bundle", "Specify path to bundle.img file", "bundle"));
+    parser.addOption(QCommandLineOption("sync-on-write", "Sync the emulated database flash to disk after each write"));
+    parser.addOption(QCommandLineOption("headless", "Run without any visible window"));
+    parser.addOption(QCommandLineOption("capture-frames", "Write each new display frame to the given directory", "directory"));
+    parser.addOption(QCommandLineOption("capture-raw", "Capture frames as raw 4bpp data instead of PNG"));
+    parser.addOption(QCommandLineOption("run-for", "Quit after the given number of (virtual) milliseconds", "ms"));
+    parser.addOption(QCommandLineOption("virtual-time", "Advance time whenever the device idles instead of following the wall clock"));
+    parser.addOption(QCommandLineOption("storage-dir", "Directory holding the eeprom.bin and dbflash.bin storage files", "directory"));
+    parser.addOption(QCommandLineOption("eeprom", "Path to the emulated eeprom file (overrides --storage-dir)", "file"));
+    parser.addOption(QCommandLineOption("dbflash", "Path to the emulated database flash file (overrides --storage-dir)", "file"));
+    parser.addOption(QCommandLineOption("hid-socket", "Name of the local socket used for HID communications", "name", "moolticuted_local_dev"));
+    parser.addOption(QCommandLineOption("latency-model", "Model SPI flash, smartcard and aux link latencies: \"default\" or comma separated <subsystem>_<cmd|byte|program>_ns=<value> overrides", "spec"));
+    parser.addOption(QCommandLineOption("script", "Replay the input events and HID packets of the given script or recording", "file"));
+    parser.addOption(QCommandLineOption("record", "Record input events and HID traffic to the given file", "file"));
     parser.process(app);
 
+    virtual_time = parser.isSet("virtual-time");
+
     QTimer ms_timer;
     ms_timer.setInterval(1);
-    ms_timer.start();
+    if(!virtual_time)
+        ms_timer.start();
 
     QObject::connect(&ms_timer, &QTimer::timeout, [] () {
         if (true)
         {
             pseudo_irq();
+            emu_script_tick();
         }
         else
         {
@@ -199,21 +325,62 @@ int main(int ac, char ** av)
     });
 
     oled = new OLEDWidget;
-
-    if(parser.isSet("smartcard"))
+    emu_oled_set_headless(headless);
+    if(parser.isSet("capture-frames") && !emu_oled_start_capture(parser.value("capture-frames"), parser.isSet("capture-raw")))
+        return 1;
+
+    if(parser.isSet("latency-model") && !emu_latency_configure(parser.value("latency-model").toUtf8().constData()))
+        return 1;
+    if(parser.isSet("script") && !emu_script_load(parser.value("script")))
+        return 1;
+    if(parser.isSet("record") && !emu_script_start_recording(parser.value("record")))
+        return 1;
+
+    if(parser.isSet("smartcard")) {
         emu_insert_smartcard(parser.value("smartcard"));
+        emu_script_record("card insert " + parser.value("smartcard"));
+    }
+
+    // storage and socket names, so that several instances can run side by side
+    QString eeprom_path = parser.value("eeprom");
+    QString dbflash_path = parser.value("dbflash");
+    if(parser.isSet("storage-dir")) {
+        QDir storage_dir(parser.value("storage-dir"));
+        if(!storage_dir.mkpath(".")) {
+            fprintf(stderr, "Could not create storage directory %s\n", parser.value("storage-dir").toUtf8().constData());
+            return 1;
+        }
+        if(eeprom_path.isEmpty())
+            eeprom_path = storage_dir.filePath("eeprom.bin");
+        if(dbflash_path.isEmpty())
+            dbflash_path = storage_dir.filePath("dbflash.bin");
+    }
+    emu_storage_set_paths(eeprom_path, dbflash_path);
+    app_thread.set_hid_socket_name(parser.value("hid-socket"));
 
     emu_dataflash_init(parser.value("bundle").toUtf8().constData());
+    emu_dbflash_set_sync_on_write(parser.isSet("sync-on-write") ? TRUE : FALSE);
 
     EmuWindow emu_window;
-    emu_window.show();
-
-    oled->show();
+    if(!headless) {
+        emu_window.show();
+        oled->show();
+    }
     app_thread.start();
 
+    if(parser.isSet("run-for")) {
+        if(virtual_time)
+            virtual_time_limit_ms = parser.value("run-for").toULongLong();
+        else
+            QTimer::singleShot(parser.value("run-for").toInt(), &app, &QApplication::quit);
+    }
+
     app.exec();
 
     app_thread.stop();
+    emu_oled_stop_capture();
+    emu_script_stop_recording();
+    emu_latency_report();
 
     delete oled;
     return 0;
@@ -23,6 +23,10 @@ BOOL emu_get_usb_charging(void);
 void emu_charger_enable(BOOL en);
 
 BOOL emu_get_systick(uint32_t *value);
+uint64_t emu_get_elapsed_ms(void);
+uint32_t emu_get_cycle_counter(void);
+void emu_idle(void);
+void emu_consume_time_ns(uint64_t ns);
 
 BOOL emu_get_lefthanded(void);
 
@@ -12,6 +12,7 @@
 
 #include "emulator.h"
 #include "emu_smartcard.h"
+#include "emu_script.h"
 
 EmuWindow::EmuWindow()
 {
@@ -48,6 +49,7 @@ QWidget *EmuWindow::createSmartcardUi()
     auto act_invalid = btn_insert_menu->addAction("Invalid");
     QObject::connect(act_invalid, &QAction::triggered, this, [=]() {
         if(emu_insert_new_smartcard(QString(), EMU_SMARTCARD_INVALID)) {
+            emu_script_record("card invalid");
             btn_remove->setEnabled(true);
             btn_insert->setEnabled(false);
         }
@@ -56,6 +58,7 @@ QWidget *EmuWindow::createSmartcardUi()
     auto act_broken = btn_insert_menu->addAction("Broken");
     QObject::connect(act_broken, &QAction::triggered, this, [=]() {
         if(emu_insert_new_smartcard(QString(), EMU_SMARTCARD_BROKEN)) {
+            emu_script_record("card broken");
             btn_remove->setEnabled(true);
             btn_insert->setEnabled(false);
         }
@@ -70,6 +73,7 @@ QWidget *EmuWindow::createSmartcardUi()
         if (dialog.exec() == QDialog::Accepted) {
             auto fileName = dialog.selectedFiles().value(0);
             if(emu_insert_new_smartcard(fileName, EMU_SMARTCARD_REGULAR)) {
+                emu_script_record("card new " + fileName);
                 btn_remove->setEnabled(true);
                 btn_insert->setEnabled(false);
             }
@@ -83,6 +87,7 @@ QWidget *EmuWindow::createSmartcardUi()
             return;
 
         if(emu_insert_smartcard(fileName)) {
+            emu_script_record("card insert " + fileName);
             btn_remove->setEnabled(true);
             btn_insert->setEnabled(false);
         }
@@ -92,6 +97,7 @@ QWidget *EmuWindow::createSmartcardUi()
 
     QObject::connect(btn_remove, &QPushButton::clicked, this, [=]() {
         emu_remove_smartcard();
+        emu_script_record("card remove");
         btn_remove->setEnabled(false);
         btn_insert->setEnabled(true);
     });
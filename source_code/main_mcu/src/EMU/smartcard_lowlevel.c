@@ -2,6 +2,7 @@
 #include "smartcard_highlevel.h"
 #include "emu_smartcard.h"
 #include "emulator.h"
+#include "emu_latency.h"
 #include <string.h>
 
 static det_ret_type_te smartcard_status = RETURN_REL;
@@ -63,7 +64,7 @@ uint8_t* smartcard_lowlevel_read_smc(uint16_t nb_bytes_total_read, uint16_t star
     int i;
     if(smartcard == NULL)
         return 0;
-    
+
     /* nb_bytes_total_read name is horribly misleading :( */
     for(i=start_record_index;i < nb_bytes_total_read;i++) {
         BOOL allowed = TRUE;
@@ -79,30 +80,34 @@ uint8_t* smartcard_lowlevel_read_smc(uint16_t nb_bytes_total_read, uint16_t star
         data_to_receive[i - start_record_index] = allowed ? smartcard->storage.smc[i] : 0xff;
     }
     emu_close_smartcard(FALSE);
+
+    /* Accounted without the smartcard lock: virtual time may run scripted card events */
+    emu_latency_account(EMU_LATENCY_SMARTCARD, EMU_LATENCY_ACCESS, nb_bytes_total_read - start_record_index);
     return data_to_receive;
 }
 
 void smartcard_lowlevel_write_smc(uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write)
 {
     struct emu_smartcard_t *smartcard = emu_open_smartcard();
+    BOOL written = FALSE;
 
     if(smartcard == NULL)
         return;
 
     /* these tests are not bulletproof, but they work with normally behaved accesses */
     if(start_index_bit >= 1424 && start_index_bit < 1440 && smartcard->storage.fuses[MAN_FUSE]) {
-        emu_close_smartcard(FALSE);
-        return;
-    }
-
-    if(smartcard->storage.type == EMU_SMARTCARD_BROKEN) {
-        emu_close_smartcard(FALSE);
-        return;
+        /* manufacturer zone fused */
+    } else if(smartcard->storage.type == EMU_SMARTCARD_BROKEN) {
+        /* writes are lost */
+    } else {
+        /* FIXME: doesn't support sub-byte accesses */
+        memcpy(smartcard->storage.smc + start_index_bit/8, data_to_write, nb_bits/8);
+        written = TRUE;
     }
+    emu_close_smartcard(written);
 
-    /* FIXME: doesn't support sub-byte accesses */
-    memcpy(smartcard->storage.smc + start_index_bit/8, data_to_write, nb_bits/8);
-    emu_close_smartcard(TRUE);
+    /* Accounted without the smartcard lock, see smartcard_lowlevel_read_smc */
+    emu_latency_account(EMU_LATENCY_SMARTCARD, EMU_LATENCY_PROGRAM, nb_bits/8);
 }
 
 pin_check_return_te smartcard_lowlevel_validate_code(volatile uint16_t* code)
@@ -112,17 +117,21 @@ pin_check_return_te smartcard_lowlevel_validate_code(volatile uint16_t* code)
     if(smartcard == NULL)
         return RETURN_PIN_NOK_0;
 
+    pin_check_return_te ret;
     if((*code & 0xff) == smartcard->storage.smc[11] && (*code >> 8) == smartcard->storage.smc[10]) {
         smartcard->storage.smc[12] = 0xf0;
         smartcard->unlocked = TRUE; // "The SV flag remains set until power to the card is turned off."
-        emu_close_smartcard(TRUE);
-        return RETURN_PIN_OK; 
+        ret = RETURN_PIN_OK;
 
     } else {
         smartcard->storage.smc[12] >>= 1; // remove one attempt bit
-        emu_close_smartcard(TRUE);
-        return RETURN_PIN_NOK_0; 
+        ret = RETURN_PIN_NOK_0;
     }
+    emu_close_smartcard(TRUE);
+
+    /* Code comparison, then attempt counter update. Accounted without the smartcard lock, see smartcard_lowlevel_read_smc */
+    emu_latency_account(EMU_LATENCY_SMARTCARD, EMU_LATENCY_PROGRAM, sizeof(*code));
+    return ret;
 }
 
 void smartcard_lowlevel_erase_application_zone1_nzone2(BOOL zone1_nzone2){}
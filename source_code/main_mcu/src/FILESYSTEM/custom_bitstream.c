@@ -25,6 +25,85 @@
 #include "custom_fs.h"
 #include "dma.h"
 
+/* Lookup tables to expand 1/2/3/4bpp pixels to 4bpp, replaces the (x*15)/mask division (still used for deeper bitmaps) */
+static const uint8_t bitstream_bitmap_depth_expansion_lut[4][16] = 
+{
+    {0, 15},
+    {0, 5, 10, 15},
+    {0, 2, 4, 6, 8, 10, 12, 15},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}
+};
+
+/*! \fn     bitstream_bitmap_get_depth_lut(uint8_t bits_per_pixel)
+*   \brief  Get the 4bpp expansion lookup table for a given pixel depth
+*   \param  bits_per_pixel  Number of bits per pixel
+*   \return Pointer to the lookup table, or 0 if depth isn't supported by our tables
+*/
+static inline const uint8_t* bitstream_bitmap_get_depth_lut(uint8_t bits_per_pixel)
+{
+    if ((bits_per_pixel == 0) || (bits_per_pixel > 4))
+    {
+        return 0;
+    }
+    else
+    {
+        return bitstream_bitmap_depth_expansion_lut[bits_per_pixel-1];
+    }
+}
+
+/*! \fn     bitstream_bitmap_expand_pixel(bitstream_bitmap_t* bs, uint16_t pixel)
+*   \brief  Expand a masked pixel value to 4bpp
+*   \param  bs          Pointer to a bitmap bitstream structure
+*   \param  pixel       Pixel value, lower or equal to bs->mask
+*   \return 4bpp pixel value
+*/
+static inline uint8_t bitstream_bitmap_expand_pixel(bitstream_bitmap_t* bs, uint16_t pixel)
+{
+    if (bs->_depth_lut != 0)
+    {
+        return bs->_depth_lut[pixel];
+    }
+    else
+    {
+        return (uint8_t)((pixel * 15) / bs->mask);
+    }
+}
+
+/*! \fn     bitstream_bitmap_fill_bytes(uint8_t* data, uint8_t value, uint16_t nb_bytes)
+*   \brief  Fill a byte array using 32-bit stores where alignment allows it
+*   \param  data        Pointer to the array to fill
+*   \param  value       Byte value to fill with
+*   \param  nb_bytes    Number of bytes to fill
+*/
+static inline void bitstream_bitmap_fill_bytes(uint8_t* data, uint8_t value, uint16_t nb_bytes)
+{
+    uint32_t word_value = value * 0x01010101UL;
+    uint32_t* word_pt;
+    
+    /* Byte stores until we're 32-bit aligned */
+    while ((nb_bytes != 0) && ((((uintptr_t)data) & 0x03) != 0))
+    {
+        *data++ = value;
+        nb_bytes--;
+    }
+    
+    /* 32-bit stores */
+    word_pt = (uint32_t*)data;
+    while (nb_bytes >= sizeof(uint32_t))
+    {
+        *word_pt++ = word_value;
+        nb_bytes -= sizeof(uint32_t);
+    }
+    
+    /* Remaining bytes */
+    data = (uint8_t*)word_pt;
+    while (nb_bytes != 0)
+    {
+        *data++ = value;
+        nb_bytes--;
+    }
+}
+
 
 /*! \fn     bitstream_bitmap_init(bitstream_bitmap_t* bs, bitmap_t* bitmap, custom_fs_address_t address, BOOL exclusive)
 *   \brief  Initialize a bitmap bitstream
@@ -44,6 +123,7 @@ void bitstream_bitmap_init(bitstream_bitmap_t* bs, bitmap_t* bitmap, custom_fs_a
     bs->_word = 0xAA55;
     bs->_count = 0;
     bs->_flags = bitmap->flags;
+    bs->_depth_lut = bitstream_bitmap_get_depth_lut(bs->bitsPerPixel);
     bs->addr = address;
     bs->bufSel = 0;
     bs->_exclusive_transfer = exclusive;
@@ -109,6 +189,7 @@ void bitstream_glyph_bitmap_init(bitstream_bitmap_t* bs, font_header_t* font, fo
     bs->_word = 0xAA55;
     bs->_count = 0;
     bs->_flags = 0;
+    bs->_depth_lut = bitstream_bitmap_get_depth_lut(bs->bitsPerPixel);
     bs->addr = address;
     bs->bufSel = 0;
     bs->_exclusive_transfer = exclusive;
@@ -218,6 +299,8 @@ void bitstream_bitmap_array_read(bitstream_bitmap_t* bs, uint8_t* data, uint16_t
 {
     if (bs->_flags & CUSTOM_FS_BITMAP_RLE_FLAG)
     {
+        BOOL high_nibble = TRUE;
+        
         while (nb_pixels != 0)
         {
             if (bs->_bits == 0)
@@ -228,24 +311,52 @@ void bitstream_bitmap_array_read(bitstream_bitmap_t* bs, uint8_t* data, uint16_t
                 bs->_pixel = byte & 0x0F;
             }
             
-            /* We have pixels of the same color to store */
-            *data = bs->_pixel << 4;
-            bs->_bits--;
-            nb_pixels--;
-                
-            if (bs->_bits == 0)
+            if ((high_nibble != FALSE) && (bs->_bits >= 2) && (nb_pixels >= 2))
             {
-                /* We have read all pixels of the same color */
-                uint8_t byte = bitstream_bitmap_get_next_byte(bs);
-                bs->_bits = (byte >> 4) + 1;
-                bs->_pixel = byte & 0x0F;
+                /* Byte aligned: store as many full bytes as the current run allows */
+                uint16_t nb_bytes = bs->_bits >> 1;
+                if (nb_bytes > (nb_pixels >> 1))
+                {
+                    nb_bytes = nb_pixels >> 1;
+                }
+                bitstream_bitmap_fill_bytes(data, bs->_pixel * 0x11, nb_bytes);
+                bs->_bits -= (uint8_t)(nb_bytes << 1);
+                nb_pixels -= nb_bytes << 1;
+                data += nb_bytes;
             }
-            
-            /* We have pixels of the same color to store */
-            *data |= bs->_pixel;
-            bs->_bits--;
-            nb_pixels--;
-            data++;
+            else if (high_nibble != FALSE)
+            {
+                /* Single pixel left in current run (or in our request) */
+                *data = bs->_pixel << 4;
+                bs->_bits--;
+                nb_pixels--;
+                high_nibble = FALSE;
+            }
+            else
+            {
+                /* Second pixel of a byte */
+                *data++ |= bs->_pixel;
+                bs->_bits--;
+                nb_pixels--;
+                high_nibble = TRUE;
+            }
+        }
+    }
+    else if ((bs->bitsPerPixel == 4) && (bs->_bits == 0))
+    {
+        /* 4bpp aligned data: flash bytes are already in our display format */
+        while (nb_pixels >= 2)
+        {
+            *data++ = bitstream_bitmap_get_next_byte(bs);
+            nb_pixels -= 2;
+        }
+        
+        /* Odd number of pixels: keep the remaining one for the next read */
+        if (nb_pixels != 0)
+        {
+            bs->_word = bitstream_bitmap_get_next_byte(bs);
+            bs->_bits = 4;
+            *data = bs->_word & 0xF0;
         }
     }
     else
@@ -266,7 +377,7 @@ void bitstream_bitmap_array_read(bitstream_bitmap_t* bs, uint8_t* data, uint16_t
                 {
                     /* Move pixel data from _word to data */
                     bs->_bits -= bs->bitsPerPixel;
-                    *data |= (((bs->_word >> bs->_bits) & bs->mask) * 15) / bs->mask;
+                    *data |= bitstream_bitmap_expand_pixel(bs, (bs->_word >> bs->_bits) & bs->mask);
                 }
                 else
                 {
@@ -275,7 +386,7 @@ void bitstream_bitmap_array_read(bitstream_bitmap_t* bs, uint8_t* data, uint16_t
                     *data |= (bs->_word << offset & bs->mask);
                     bs->_bits += 8 - bs->bitsPerPixel;
                     bs->_word = bitstream_bitmap_get_next_byte(bs);
-                    *data |= ((bs->_word >> bs->_bits) * 15) / bs->mask;
+                    *data |= bitstream_bitmap_expand_pixel(bs, bs->_word >> bs->_bits);
                 }                
             }
             if (nb_pixels == 1)
@@ -360,7 +471,7 @@ uint8_t bitstream_bitmap_two_pixel_read(bitstream_bitmap_t* bs)
             {
                 /* Move pixel data from _word to data */
                 bs->_bits -= bs->bitsPerPixel;
-                data |= (((bs->_word >> bs->_bits) & bs->mask) * 15) / bs->mask;
+                data |= bitstream_bitmap_expand_pixel(bs, (bs->_word >> bs->_bits) & bs->mask);
             }
             else 
             {
@@ -369,7 +480,7 @@ uint8_t bitstream_bitmap_two_pixel_read(bitstream_bitmap_t* bs)
                 data |= (bs->_word << offset & bs->mask);
                 bs->_bits += 8 - bs->bitsPerPixel;
                 bs->_word = bitstream_bitmap_get_next_byte(bs);
-                data |= ((bs->_word >> bs->_bits) * 15) / bs->mask;
+                data |= bitstream_bitmap_expand_pixel(bs, bs->_word >> bs->_bits);
             }
         }
     }
@@ -422,7 +533,7 @@ uint16_t bitstream_bitmap_read(bitstream_bitmap_t* bs, uint16_t nb_pixels)
             {
                 /* Move pixel data from _word to data */
                 bs->_bits -= bs->bitsPerPixel;
-                data |= (((bs->_word >> bs->_bits) & bs->mask) * 15) / bs->mask;
+                data |= bitstream_bitmap_expand_pixel(bs, (bs->_word >> bs->_bits) & bs->mask);
             }
             else 
             {
@@ -431,7 +542,7 @@ uint16_t bitstream_bitmap_read(bitstream_bitmap_t* bs, uint16_t nb_pixels)
                 data |= (bs->_word << offset & bs->mask);
                 bs->_bits += 8 - bs->bitsPerPixel;
                 bs->_word = bitstream_bitmap_get_next_byte(bs);
-                data |= ((bs->_word >> bs->_bits) * 15) / bs->mask;
+                data |= bitstream_bitmap_expand_pixel(bs, bs->_word >> bs->_bits);
             }
         }
     }
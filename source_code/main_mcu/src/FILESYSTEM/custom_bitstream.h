@@ -41,6 +41,7 @@ typedef struct
     uint16_t _count;            //*< number of bytes / words read
     uint8_t _pixel;             //*< current pixel for RLE decompress
     uint8_t _flags;		        //*< format flags.  E.g. RLE=1
+    const uint8_t* _depth_lut;  //*< bpp to 4bpp expansion table, NULL when depth is above 4 bits
     custom_fs_address_t addr;	//*< address of data in SPI FLASH store.
     uint8_t buf[2][32];	        //*< FLASH read-ahead buffer
     uint32_t bufInd;	        //*< read-ahead buffer index
@@ -66,7 +66,8 @@ const uint8_t custom_fs_default_device_settings[NB_DEVICE_SETTINGS] = { 0,
                                                                         30,                                      // SETTINGS_INFORMATION_TIME_DELAY
                                                                         FALSE,                                   // SETTINGS_BLUETOOTH_SHORTCUTS
                                                                         0,                                       // SETTINGS_SCREEN_SAVER_ID
-                                                                        TRUE};                                   // SETTINGS_PREF_ST_SERV_FEATURE
+                                                                        TRUE,                                    // SETTINGS_PREF_ST_SERV_FEATURE
+                                                                        FALSE};                                  // SETTINGS_FAST_TYPING
 #ifndef EMULATOR_BUILD
 /* Pointer to the platform unique data, stored at the last page of our bootloader */
 platform_unique_data_t* custom_fs_plat_data_ptr = (platform_unique_data_t*)(FLASH_ADDR + APP_START_ADDR - NVMCTRL_ROW_SIZE);
@@ -96,6 +97,11 @@ custom_fs_address_t custom_fs_usb_keyboard_layout_addr = 0;
 uint8_t custom_fs_cur_usb_keyboard_id = 0;
 custom_fs_address_t custom_fs_ble_keyboard_layout_addr = 0;
 uint8_t custom_fs_cur_ble_keyboard_id = 0;
+#ifdef KEYBOARD_LUT_RAM_CACHE
+/* RAM copy of the last set keyboard layout LUT, shared by the USB & BLE layouts */
+keyboard_lut_cache_t custom_fs_keyboard_lut_cache;
+BOOL custom_fs_keyboard_lut_cache_enabled = TRUE;
+#endif
 /* CPZ look up table */
 cpz_lut_entry_t* custom_fs_cpz_lut;
 
@@ -427,6 +433,124 @@ ret_type_te custom_fs_get_keyboard_descriptor_string(uint8_t keyboard_id, cust_c
     return RETURN_OK;
 }
 
+#ifdef KEYBOARD_LUT_RAM_CACHE
+/*! \fn     custom_fs_load_keyboard_lut_cache(keyboard_lut_cache_t* cache_pt, custom_fs_address_t layout_address)
+*   \brief  Load a keyboard layout LUT into a RAM cache
+*   \param  cache_pt        Pointer to the cache
+*   \param  layout_address  Layout file address
+*   \note   cache_valid is left to FALSE if the layout doesn't fit in the cache
+*/
+static void custom_fs_load_keyboard_lut_cache(keyboard_lut_cache_t* cache_pt, custom_fs_address_t layout_address)
+{
+    /* Layout already loaded (USB & BLE layouts usually are the same) */
+    if (cache_pt->layout_address == layout_address)
+    {
+        return;
+    }
+    
+    custom_fs_address_t lut_address = layout_address + CUSTOM_FS_KEYBOARD_DESC_LGTH*sizeof(cust_char_t) + sizeof(cache_pt->description_intervals);
+    uint16_t symbols_chunk[32];
+    uint16_t point_offset = 0;
+    uint16_t nb_symbols = 0;
+    uint16_t nb_points = 0;
+    
+    /* Invalidate & clear cache */
+    memset(cache_pt, 0, sizeof(*cache_pt));
+    cache_pt->layout_address = layout_address;
+    
+    /* Load the description intervals and compute the number of described points, offsets computed as in custom_fs_get_keyboard_symbols_for_unicode_string */
+    custom_fs_read_from_flash((uint8_t*)cache_pt->description_intervals, layout_address + CUSTOM_FS_KEYBOARD_DESC_LGTH*sizeof(cust_char_t), sizeof(cache_pt->description_intervals));
+    for (uint16_t i = 0; i < ARRAY_SIZE(cache_pt->description_intervals); i++)
+    {
+        cache_pt->interval_point_offsets[i] = point_offset;
+        point_offset += cache_pt->description_intervals[i].interval_end - cache_pt->description_intervals[i].interval_start + 1;
+        if (cache_pt->description_intervals[i].interval_start != 0xFFFF)
+        {
+            nb_points = point_offset;
+        }
+    }
+    
+    /* Too many points: the function using the cache will fall back on flash reads */
+    if (nb_points > CUSTOM_FS_KEYB_CACHE_MAX_POINTS)
+    {
+        return;
+    }
+    
+    /* Read the LUT by chunks */
+    for (uint16_t point_index = 0; point_index < nb_points; point_index++)
+    {
+        if ((point_index % ARRAY_SIZE(symbols_chunk)) == 0)
+        {
+            custom_fs_read_from_flash((uint8_t*)symbols_chunk, lut_address + point_index*sizeof(uint16_t), sizeof(symbols_chunk));
+        }
+        
+        /* 0xFFFF: not supported */
+        uint16_t symbol = symbols_chunk[point_index % ARRAY_SIZE(symbols_chunk)];
+        if (symbol != 0xFFFF)
+        {
+            /* Too many symbols */
+            if (nb_symbols == ARRAY_SIZE(cache_pt->symbols))
+            {
+                return;
+            }
+            cache_pt->supported_points_bitmap[point_index/32] |= (1UL << (point_index%32));
+            cache_pt->symbols[nb_symbols++] = symbol;
+        }
+    }
+    
+    /* Compute ranks for constant time lookups */
+    nb_symbols = 0;
+    for (uint16_t i = 0; i < ARRAY_SIZE(cache_pt->supported_points_bitmap); i++)
+    {
+        cache_pt->supported_points_ranks[i] = nb_symbols;
+        nb_symbols += (uint16_t)__builtin_popcountl(cache_pt->supported_points_bitmap[i]);
+    }
+    
+    cache_pt->cache_valid = TRUE;
+}
+
+/*! \fn     custom_fs_set_keyboard_lut_cache_enabled(BOOL enabled)
+*   \brief  Enable or disable the keyboard layout LUT RAM cache, used for benchmarking
+*   \param  enabled         Set to FALSE to read the LUTs from flash
+*   \note   When enabled, the USB layout is (re)loaded in the cache
+*/
+void custom_fs_set_keyboard_lut_cache_enabled(BOOL enabled)
+{
+    custom_fs_keyboard_lut_cache_enabled = enabled;
+    
+    /* Reload cache */
+    custom_fs_keyboard_lut_cache.cache_valid = FALSE;
+    custom_fs_keyboard_lut_cache.layout_address = 0;
+    if ((enabled != FALSE) && (custom_fs_usb_keyboard_layout_addr != 0))
+    {
+        custom_fs_load_keyboard_lut_cache(&custom_fs_keyboard_lut_cache, custom_fs_usb_keyboard_layout_addr);
+    }
+    else if ((enabled != FALSE) && (custom_fs_ble_keyboard_layout_addr != 0))
+    {
+        custom_fs_load_keyboard_lut_cache(&custom_fs_keyboard_lut_cache, custom_fs_ble_keyboard_layout_addr);
+    }
+}
+
+/*! \fn     custom_fs_is_keyboard_lut_cached(BOOL usb_layout)
+*   \brief  Know if the current keyboard layout LUT is in RAM
+*   \param  usb_layout      Bool for USB/BLE layout
+*   \return TRUE if the layout LUT is cached
+*/
+BOOL custom_fs_is_keyboard_lut_cached(BOOL usb_layout)
+{
+    custom_fs_address_t layout_address = (usb_layout == FALSE)? custom_fs_ble_keyboard_layout_addr : custom_fs_usb_keyboard_layout_addr;
+    
+    if ((custom_fs_keyboard_lut_cache.cache_valid != FALSE) && (custom_fs_keyboard_lut_cache.layout_address == layout_address))
+    {
+        return TRUE;
+    }
+    else
+    {
+        return FALSE;
+    }
+}
+#endif
+
 /*! \fn     custom_fs_set_current_keyboard_id(uint8_t keyboard_id, BOOL usb_layout)
 *   \brief  Set current keyboard ID
 *   \param  keyboard_id     Keyboard ID
@@ -451,16 +575,84 @@ ret_type_te custom_fs_set_current_keyboard_id(uint8_t keyboard_id, BOOL usb_layo
     {
         custom_fs_ble_keyboard_layout_addr = layout_file_addr;
         custom_fs_cur_ble_keyboard_id = keyboard_id;
+        #ifdef KEYBOARD_LUT_RAM_CACHE
+        if (custom_fs_keyboard_lut_cache_enabled != FALSE)
+        {
+            custom_fs_load_keyboard_lut_cache(&custom_fs_keyboard_lut_cache, layout_file_addr);
+        }
+        #endif
     } 
     else
     {
         custom_fs_usb_keyboard_layout_addr = layout_file_addr;
         custom_fs_cur_usb_keyboard_id = keyboard_id;
+        #ifdef KEYBOARD_LUT_RAM_CACHE
+        if (custom_fs_keyboard_lut_cache_enabled != FALSE)
+        {
+            custom_fs_load_keyboard_lut_cache(&custom_fs_keyboard_lut_cache, layout_file_addr);
+        }
+        #endif
     }
     
     return RETURN_OK;
 }
 
+/*! \fn     custom_fs_get_keyboard_symbol_for_non_described_point(cust_char_t point)
+*   \brief  Get keyboard symbol for a unicode point not described in the layout
+*   \param  point       The unicode point
+*   \return The symbol, 0xFFFF if not supported
+*/
+static uint16_t custom_fs_get_keyboard_symbol_for_non_described_point(cust_char_t point)
+{
+    /* Check for tab or return */
+    if (point == 0x09)
+    {
+        return KEY_TAB;
+    } 
+    else if (point == 0x0A)
+    {
+        return KEY_RETURN;
+    } 
+    else
+    {
+        return 0xFFFF;
+    }
+}
+
+#ifdef KEYBOARD_LUT_RAM_CACHE
+/*! \fn     custom_fs_get_keyboard_symbol_from_lut_cache(keyboard_lut_cache_t* cache_pt, cust_char_t point)
+*   \brief  Get keyboard symbol for a given unicode point from a layout LUT RAM cache
+*   \param  cache_pt    Pointer to a valid cache
+*   \param  point       The unicode point
+*   \return The symbol, 0xFFFF if not supported
+*/
+static uint16_t custom_fs_get_keyboard_symbol_from_lut_cache(keyboard_lut_cache_t* cache_pt, cust_char_t point)
+{
+    for (uint16_t i = 0; i < ARRAY_SIZE(cache_pt->description_intervals); i++)
+    {
+        /* Check if char is within this interval */
+        if ((cache_pt->description_intervals[i].interval_start != 0xFFFF) && (cache_pt->description_intervals[i].interval_start <= point) && (cache_pt->description_intervals[i].interval_end >= point))
+        {
+            uint16_t point_index = cache_pt->interval_point_offsets[i] + (point - cache_pt->description_intervals[i].interval_start);
+            uint32_t bitmap_word = cache_pt->supported_points_bitmap[point_index/32];
+            uint32_t point_mask = 1UL << (point_index%32);
+            
+            /* Supported point: symbol index is the number of supported points before it */
+            if ((bitmap_word & point_mask) == 0)
+            {
+                return 0xFFFF;
+            }
+            else
+            {
+                return cache_pt->symbols[cache_pt->supported_points_ranks[point_index/32] + (uint16_t)__builtin_popcountl(bitmap_word & (point_mask - 1))];
+            }
+        }
+    }
+    
+    return custom_fs_get_keyboard_symbol_for_non_described_point(point);
+}
+#endif
+
 /*! \fn     custom_fs_get_keyboard_symbols_for_unicode_string(cust_char_t* string_pt, uint16_t* buffer, BOOL usb_layout)
 *   \brief  Get keyboard symbols (not keys) for a given unicode string
 *   \param  string_pt   Pointer to the unicode BMP string
@@ -490,6 +682,25 @@ ret_type_te custom_fs_get_keyboard_symbols_for_unicode_string(cust_char_t* strin
         layout_address = custom_fs_ble_keyboard_layout_addr;
     }
     
+    #ifdef KEYBOARD_LUT_RAM_CACHE
+    /* Use our RAM copy if it holds this layout and the layout fit in it */
+    keyboard_lut_cache_t* lut_cache_pt = &custom_fs_keyboard_lut_cache;
+    if ((lut_cache_pt->cache_valid != FALSE) && (lut_cache_pt->layout_address == layout_address))
+    {
+        while (*string_pt != 0)
+        {
+            *buffer = custom_fs_get_keyboard_symbol_from_lut_cache(lut_cache_pt, *string_pt);
+            if (*buffer == 0xFFFF)
+            {
+                all_points_described = FALSE;
+            }
+            string_pt++;
+            buffer++;
+        }
+        return (all_points_described == FALSE)? RETURN_NOK : RETURN_OK;
+    }
+    #endif
+    
     /* Load the description intervals */
     custom_fs_read_from_flash((uint8_t*)description_intervals, layout_address + CUSTOM_FS_KEYBOARD_DESC_LGTH*sizeof(cust_char_t), sizeof(description_intervals));
     
@@ -519,19 +730,11 @@ ret_type_te custom_fs_get_keyboard_symbols_for_unicode_string(cust_char_t* strin
         /* Check for described point support */
         if (point_support_described == FALSE)
         {
-            /* Check for tab or return */
-            if (*string_pt == 0x09)
-            {
-                *buffer = KEY_TAB;
-            } 
-            else if (*string_pt == 0x0A)
-            {
-                *buffer = KEY_RETURN;
-            } 
-            else
+            /* Tab or return are supported */
+            *buffer = custom_fs_get_keyboard_symbol_for_non_described_point(*string_pt);
+            if (*buffer == 0xFFFF)
             {
                 all_points_described = FALSE;
-                *buffer = 0xFFFF;
             }
         }
         else
@@ -57,6 +57,8 @@ void custom_fs_erase_256B_at_internal_custom_storage_slot(uint32_t slot_id);
 custom_file_flash_header_t* custom_fs_get_buffered_flash_header_pt(void);
 RET_TYPE custom_fs_get_user_id_for_cpz(uint8_t* cpz, uint8_t* user_id);
 void custom_fs_set_dataflash_descriptor(spi_flash_descriptor_t* desc);
+void custom_fs_set_keyboard_lut_cache_enabled(BOOL enabled);
+BOOL custom_fs_is_keyboard_lut_cached(BOOL usb_layout);
 custom_fs_address_t custom_fs_get_start_address_of_signed_data(void);
 uint8_t custom_fs_get_recommended_layout_for_current_language(void);
 BOOL custom_fs_get_device_flag_value(custom_fs_flag_id_te flag_id);
@@ -48,6 +48,8 @@
 /* Fields sizes */
 #define CUSTOM_FS_KEYBOARD_DESC_LGTH        20
 #define CUSTOM_FS_KEYB_NB_INT_DESCRIBED     20
+#define CUSTOM_FS_KEYB_CACHE_MAX_POINTS     512
+#define CUSTOM_FS_KEYB_CACHE_MAX_SYMBOLS    256
 
 /* Settings IDs */
 #define NB_DEVICE_SETTINGS                  64
@@ -78,8 +80,9 @@
 #define SETTINGS_BLUETOOTH_SHORTCUTS        24
 #define SETTINGS_SCREEN_SAVER_ID            25
 #define SETTINGS_PREF_ST_SERV_FEATURE       26
+#define SETTINGS_FAST_TYPING                27
 /* Set to define the number of settings used */
-#define SETTINGS_NB_USED                    27
+#define SETTINGS_NB_USED                    28
 
 /* Flags IDs */
 #define NB_DEVICE_FLAGS                     32
@@ -215,6 +218,18 @@ typedef struct
     uint16_t interval_end;
 } unicode_interval_desc_t;
 
+// Keyboard layout LUT RAM copy: non supported points are only stored as a cleared bit in the bitmap
+typedef struct
+{
+    BOOL cache_valid;                                                       // Set when the layout fit in the cache
+    custom_fs_address_t layout_address;                                     // Layout file loaded in the cache, 0 if none
+    unicode_interval_desc_t description_intervals[CUSTOM_FS_KEYB_NB_INT_DESCRIBED];
+    uint16_t interval_point_offsets[CUSTOM_FS_KEYB_NB_INT_DESCRIBED];       // Index of each interval first point
+    uint32_t supported_points_bitmap[CUSTOM_FS_KEYB_CACHE_MAX_POINTS/32];   // Bit set for points having a symbol
+    uint16_t supported_points_ranks[CUSTOM_FS_KEYB_CACHE_MAX_POINTS/32];    // Number of symbols before each bitmap word
+    uint16_t symbols[CUSTOM_FS_KEYB_CACHE_MAX_SYMBOLS];                     // Symbols of the supported points
+} keyboard_lut_cache_t;
+
 // Glyph struct
 typedef struct
 {
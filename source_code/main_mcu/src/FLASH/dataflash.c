@@ -106,6 +106,8 @@ void dataflash_write_array_to_memory(spi_flash_descriptor_t* descriptor_pt, uint
 */
 void dataflash_read_data_array(spi_flash_descriptor_t* descriptor_pt, uint32_t address, uint8_t* data, uint32_t length)
 {
+    PROFILING_START(profiling_start);
+    
     /* SS low */
     PORT->Group[descriptor_pt->cs_pin_group].OUTCLR.reg = descriptor_pt->cs_pin_mask;
     
@@ -124,6 +126,7 @@ void dataflash_read_data_array(spi_flash_descriptor_t* descriptor_pt, uint32_t a
     
     /* SS high */
     PORT->Group[descriptor_pt->cs_pin_group].OUTSET.reg = descriptor_pt->cs_pin_mask;    
+    PROFILING_STOP(PROFILING_DATAFLASH_READ, profiling_start);
 }
 
 /*! \fn     dataflash_read_data_array_start(spi_flash_descriptor_t* descriptor_pt, uint32_t address)
@@ -152,11 +155,15 @@ void dataflash_read_data_array_start(spi_flash_descriptor_t* descriptor_pt, uint
 */
 void dataflash_read_bytes_from_opened_transfer(spi_flash_descriptor_t* descriptor_pt, uint8_t* data, uint32_t length)
 {    
+    PROFILING_START(profiling_start);
+    
     /* Send data */
     for (uint32_t i = 0; i < length; i++)
     {
         *data++ = sercom_spi_send_single_byte(descriptor_pt->sercom_pt, 0);
     }    
+    
+    PROFILING_STOP(PROFILING_DATAFLASH_READ, profiling_start);
 }
 
 /*! \fn     dataflash_stop_ongoing_transfer(spi_flash_descriptor_t* descriptor_pt)
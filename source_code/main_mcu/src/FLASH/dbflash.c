@@ -19,10 +19,21 @@
 *    Created:  10/11/2017
 *    Author:   Mathieu Stephan
 */
+#include <string.h>
 #include "platform_defines.h"
 #include "driver_sercom.h"
+#include "driver_timer.h"
 #include "dbflash.h"
 #include "main.h"
+#ifdef DBFLASH_READ_CACHE
+/* Read cache entries */
+dbflash_read_cache_entry_t dbflash_read_cache[DBFLASH_READ_CACHE_NB_ENTRIES];
+/* Read cache access counter, for LRU eviction */
+uint32_t dbflash_read_cache_access_counter = 0;
+/* Read cache statistics */
+uint32_t dbflash_read_cache_nb_hits = 0;
+uint32_t dbflash_read_cache_nb_misses = 0;
+#endif
 
 
 /*! \fn     dbflash_memory_boundary_error_callblack(void)
@@ -37,6 +48,138 @@ void dbflash_memory_boundary_error_callblack(void)
     main_reboot();
 }
 
+/*! \fn     dbflash_get_read_cache_stats(uint32_t* nb_hits, uint32_t* nb_misses)
+*   \brief  Get the read cache statistics
+*   \param  nb_hits     Where to store the number of reads served from the cache
+*   \param  nb_misses   Where to store the number of cacheable reads that went to the flash
+*/
+void dbflash_get_read_cache_stats(uint32_t* nb_hits, uint32_t* nb_misses)
+{
+    #ifdef DBFLASH_READ_CACHE
+        *nb_hits = dbflash_read_cache_nb_hits;
+        *nb_misses = dbflash_read_cache_nb_misses;
+    #else
+        *nb_hits = 0;
+        *nb_misses = 0;
+    #endif
+}
+
+/*! \fn     dbflash_read_cache_invalidate(void)
+*   \brief  Invalidate all the read cache entries
+*/
+void dbflash_read_cache_invalidate(void)
+{
+    #ifdef DBFLASH_READ_CACHE
+        for (uint16_t i = 0; i < DBFLASH_READ_CACHE_NB_ENTRIES; i++)
+        {
+            dbflash_read_cache[i].size = 0;
+        }
+    #endif
+}
+
+#ifdef DBFLASH_READ_CACHE
+/*! \fn     dbflash_read_cache_lookup(uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void* data)
+*   \brief  Try to serve a read from the read cache
+*   \param  pageNumber      Page number
+*   \param  offset          Offset in the page
+*   \param  dataSize        Number of bytes to read
+*   \param  data            Where to store the read bytes
+*   \return RETURN_OK if the read was served
+*/
+static RET_TYPE dbflash_read_cache_lookup(uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void* data)
+{
+    for (uint16_t i = 0; i < DBFLASH_READ_CACHE_NB_ENTRIES; i++)
+    {
+        dbflash_read_cache_entry_t* entry_pt = &dbflash_read_cache[i];
+        
+        if ((entry_pt->size != 0) && (entry_pt->page == pageNumber) && (offset >= entry_pt->offset) && (offset + dataSize <= entry_pt->offset + entry_pt->size))
+        {
+            memcpy(data, &entry_pt->data[offset - entry_pt->offset], dataSize);
+            entry_pt->last_used = dbflash_read_cache_access_counter++;
+            dbflash_read_cache_nb_hits++;
+            return RETURN_OK;
+        }
+    }
+    
+    dbflash_read_cache_nb_misses++;
+    return RETURN_NOK;
+}
+
+/*! \fn     dbflash_read_cache_store(uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void* data)
+*   \brief  Store read bytes in the read cache, evicting the least recently used entry
+*   \param  pageNumber      Page number
+*   \param  offset          Offset in the page
+*   \param  dataSize        Number of bytes read
+*   \param  data            The read bytes
+*/
+static void dbflash_read_cache_store(uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void* data)
+{
+    dbflash_read_cache_entry_t* entry_pt = &dbflash_read_cache[0];
+    
+    /* Find an empty or the least recently used entry */
+    for (uint16_t i = 0; (i < DBFLASH_READ_CACHE_NB_ENTRIES) && (entry_pt->size != 0); i++)
+    {
+        if ((dbflash_read_cache[i].size == 0) || (dbflash_read_cache[i].last_used < entry_pt->last_used))
+        {
+            entry_pt = &dbflash_read_cache[i];
+        }
+    }
+    
+    memcpy(entry_pt->data, data, dataSize);
+    entry_pt->last_used = dbflash_read_cache_access_counter++;
+    entry_pt->page = pageNumber;
+    entry_pt->offset = offset;
+    entry_pt->size = dataSize;
+}
+
+/*! \fn     dbflash_read_cache_write_through(uint16_t pageNumber, uint16_t offset, uint16_t dataSize, uint8_t* data, uint8_t pattern)
+*   \brief  Update the read cache entries overlapping a flash write
+*   \param  pageNumber      Page number
+*   \param  offset          Offset in the page
+*   \param  dataSize        Number of bytes written
+*   \param  data            The written bytes, or 0 for a pattern write
+*   \param  pattern         Pattern written when data is 0
+*/
+static void dbflash_read_cache_write_through(uint16_t pageNumber, uint16_t offset, uint16_t dataSize, uint8_t* data, uint8_t pattern)
+{
+    for (uint16_t i = 0; i < DBFLASH_READ_CACHE_NB_ENTRIES; i++)
+    {
+        dbflash_read_cache_entry_t* entry_pt = &dbflash_read_cache[i];
+        
+        /* Overlapping entry? */
+        if ((entry_pt->size != 0) && (entry_pt->page == pageNumber) && (offset < entry_pt->offset + entry_pt->size) && (entry_pt->offset < offset + dataSize))
+        {
+            uint16_t overlap_start = (offset > entry_pt->offset)? offset : entry_pt->offset;
+            uint16_t overlap_end = (offset + dataSize < entry_pt->offset + entry_pt->size)? offset + dataSize : entry_pt->offset + entry_pt->size;
+            
+            if (data == 0)
+            {
+                memset(&entry_pt->data[overlap_start - entry_pt->offset], pattern, overlap_end - overlap_start);
+            }
+            else
+            {
+                memcpy(&entry_pt->data[overlap_start - entry_pt->offset], &data[overlap_start - offset], overlap_end - overlap_start);
+            }
+        }
+    }
+}
+
+/*! \fn     dbflash_read_cache_invalidate_page(uint16_t pageNumber)
+*   \brief  Invalidate the read cache entries of a given page
+*   \param  pageNumber      Page number
+*/
+static void dbflash_read_cache_invalidate_page(uint16_t pageNumber)
+{
+    for (uint16_t i = 0; i < DBFLASH_READ_CACHE_NB_ENTRIES; i++)
+    {
+        if (dbflash_read_cache[i].page == pageNumber)
+        {
+            dbflash_read_cache[i].size = 0;
+        }
+    }
+}
+#endif
+
 /*! \fn     dbflash_send_command(spi_flash_descriptor_t* descriptor_pt, uint8_t* data, uint32_t length)
 *   \brief  Send a command to the flash
 *   \param  descriptor_pt   Pointer to dbflash descriptor
@@ -244,6 +387,9 @@ void dbflash_sector_zero_erase(spi_flash_descriptor_t* descriptor_pt, uint8_t se
     
     /* Wait until memory is ready */
     dbflash_wait_for_not_busy(descriptor_pt);
+    
+    /* Erased memory isn't tracked by the read cache */
+    dbflash_read_cache_invalidate();
 }
 
 /*! \fn     dbflash_sector_erase(spi_flash_descriptor_t* descriptor_pt, uint8_t sectorNumber)
@@ -267,7 +413,10 @@ void dbflash_sector_erase(spi_flash_descriptor_t* descriptor_pt, uint8_t sectorN
     dbflash_send_command(descriptor_pt, opcode, sizeof(opcode));
     
     /* Wait until memory is ready */
-    dbflash_wait_for_not_busy(descriptor_pt);   
+    dbflash_wait_for_not_busy(descriptor_pt);
+    
+    /* Erased memory isn't tracked by the read cache */
+    dbflash_read_cache_invalidate();
 }
 
 /*! \fn     dbflash_chip_erase(spi_flash_descriptor_t* descriptor_pt)
@@ -280,7 +429,10 @@ void dbflash_chip_erase(spi_flash_descriptor_t* descriptor_pt)
     dbflash_send_command(descriptor_pt, opcode, sizeof(opcode));
     
     /* Wait until memory is ready */
-    dbflash_wait_for_not_busy(descriptor_pt);   
+    dbflash_wait_for_not_busy(descriptor_pt);
+    
+    /* Erased memory isn't tracked by the read cache */
+    dbflash_read_cache_invalidate();
 }
 
 /*! \fn     dbflash_block_erase(spi_flash_descriptor_t* descriptor_pt, uint16_t blockNumber)
@@ -305,6 +457,9 @@ void dbflash_block_erase(spi_flash_descriptor_t* descriptor_pt, uint16_t blockNu
     
     /* Wait until memory is ready */
     dbflash_wait_for_not_busy(descriptor_pt);
+    
+    /* Erased memory isn't tracked by the read cache */
+    dbflash_read_cache_invalidate();
 }
 
 /*! \fn     dbflash_page_erase(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber)
@@ -329,6 +484,11 @@ void dbflash_page_erase(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumb
     
     /* Wait until memory is ready */
     dbflash_wait_for_not_busy(descriptor_pt);
+    
+    /* Update read cache */
+    #ifdef DBFLASH_READ_CACHE
+        dbflash_read_cache_write_through(pageNumber, 0, BYTES_PER_PAGE, 0, 0xFF);
+    #endif
 }
 
 /*! \fn     dbflash_format_flash(spi_flash_descriptor_t* descriptor_pt) 
@@ -409,6 +569,11 @@ void dbflash_write_data_pattern_to_flash(spi_flash_descriptor_t* descriptor_pt,
     
     /* Wait until memory is ready */
     dbflash_wait_for_not_busy(descriptor_pt);
+    
+    /* Update read cache */
+    #ifdef DBFLASH_READ_CACHE
+        dbflash_read_cache_write_through(pageNumber, offset, dataSize, 0, pattern);
+    #endif
 }
 
 /*! \fn     dbflash_write_data_to_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void *data)
@@ -436,6 +601,8 @@ void dbflash_write_data_to_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t
         }
     #endif
     
+    PROFILING_START(profiling_start);
+    
     // If needed, load the page in the internal buffer
     if ((offset != 0) || (dataSize != BYTES_PER_PAGE))
     {
@@ -449,6 +616,12 @@ void dbflash_write_data_to_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t
     
     /* Wait until memory is ready */
     dbflash_wait_for_not_busy(descriptor_pt);
+    PROFILING_STOP(PROFILING_DBFLASH_WRITE, profiling_start);
+    
+    /* Update read cache */
+    #ifdef DBFLASH_READ_CACHE
+        dbflash_read_cache_write_through(pageNumber, offset, dataSize, (uint8_t*)data, 0);
+    #endif
 }
 
 /*! \fn     dbflash_read_data_from_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void *data)
@@ -485,9 +658,28 @@ void dbflash_read_data_from_flash(spi_flash_descriptor_t* descriptor_pt, uint16_
         }
     #endif
     
+    /* Small reads within a page (node headers...) go through the read cache */
+    #ifdef DBFLASH_READ_CACHE
+        BOOL cacheable_read = ((dataSize <= DBFLASH_READ_CACHE_ENTRY_SIZE) && (offset + dataSize <= BYTES_PER_PAGE))? TRUE : FALSE;
+        if ((cacheable_read != FALSE) && (dbflash_read_cache_lookup(pageNumber, offset, dataSize, data) == RETURN_OK))
+        {
+            return;
+        }
+    #endif
+    
+    /* Only actual flash accesses are profiled */
+    PROFILING_START(profiling_start);
     uint8_t opcode[4] = {DBFLASH_OPCODE_LOWF_READ};
     dbflash_fill_page_read_write_erase_opcode_from_address(pageNumber, offset, &opcode[1]);
     dbflash_send_data_with_four_bytes_opcode(descriptor_pt, opcode, data, dataSize);
+    PROFILING_STOP(PROFILING_DBFLASH_READ, profiling_start);
+    
+    #ifdef DBFLASH_READ_CACHE
+        if (cacheable_read != FALSE)
+        {
+            dbflash_read_cache_store(pageNumber, offset, dataSize, data);
+        }
+    #endif
 } 
 
 /*! \fn     dbflash_raw_read(spi_flash_descriptor_t* descriptor_pt, uint8_t* datap, uint16_t addr, uint16_t size)
@@ -536,4 +728,9 @@ void dbflash_flash_write_buffer_to_page(spi_flash_descriptor_t* descriptor_pt, u
     dbflash_fill_page_read_write_erase_opcode_from_address(page, 0, &op[1]);
     dbflash_send_data_with_four_bytes_opcode(descriptor_pt, op, op, 0);
     dbflash_wait_for_not_busy(descriptor_pt);
+    
+    /* Internal buffer contents aren't known: invalidate cached data for that page */
+    #ifdef DBFLASH_READ_CACHE
+        dbflash_read_cache_invalidate_page(page);
+    #endif
 }
\ No newline at end of file
@@ -29,6 +29,23 @@
 // Enable boundary checks
 #define DBFLASH_MEMORY_BOUNDARY_CHECKS
 
+// Enable the write-through read cache, sized for node headers
+#ifndef BOOTLOADER
+    #define DBFLASH_READ_CACHE
+#endif
+#define DBFLASH_READ_CACHE_NB_ENTRIES       8
+#define DBFLASH_READ_CACHE_ENTRY_SIZE       16
+
+/* Typedefs */
+typedef struct
+{
+    uint32_t last_used;
+    uint16_t page;
+    uint16_t offset;
+    uint16_t size;                                  // 0: unused entry
+    uint8_t data[DBFLASH_READ_CACHE_ENTRY_SIZE];
+} dbflash_read_cache_entry_t;
+
 /* Prototypes */
 void dbflash_write_data_pattern_to_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize, uint8_t pattern);
 void dbflash_send_data_with_four_bytes_opcode_no_readback(spi_flash_descriptor_t* descriptor_pt, uint8_t* opcode, uint8_t* buffer, uint16_t buffer_size);
@@ -51,6 +68,8 @@ void dbflash_wait_for_not_busy(spi_flash_descriptor_t* descriptor_pt);
 void dbflash_format_flash(spi_flash_descriptor_t* descriptor_pt);
 void dbflash_chip_erase(spi_flash_descriptor_t* descriptor_pt);
 void dbflash_memory_boundary_error_callblack(void);
+void dbflash_get_read_cache_stats(uint32_t* nb_hits, uint32_t* nb_misses);
+void dbflash_read_cache_invalidate(void);
 
 /* Defines */
 #if defined(DBFLASH_CHIP_1M)      // Used to identify a 1M Flash Chip (AT45DB011D)
@@ -237,6 +237,9 @@ RET_TYPE logic_aux_mcu_flash_firmware_update(BOOL connect_to_usb_if_needed)
     /* Send message */
     comms_aux_mcu_send_message(temp_tx_message_pt);
     
+    /* Aux MCU bootloader only knows about full frames */
+    dma_aux_mcu_set_compact_frames_enabled(FALSE);
+    
     /* Wait for message from aux MCU */
     while(comms_aux_mcu_active_wait(&temp_rx_message, AUX_MCU_MSG_TYPE_BOOTLOADER, FALSE, -1) != RETURN_OK){}
     
@@ -295,6 +298,9 @@ RET_TYPE logic_aux_mcu_flash_firmware_update(BOOL connect_to_usb_if_needed)
     /* Let the aux MCU boot */
     timer_delay_ms(1000);
     
+    /* Switch back to compact frames if the new firmware supports them */
+    comms_aux_mcu_negotiate_compact_frames();
+    
     /* If USB present, send USB attach message */
     if ((platform_io_is_usb_3v3_present() != FALSE) && (connect_to_usb_if_needed != FALSE))
     {
@@ -22,11 +22,63 @@
 #include <string.h>
 #include "logic_encryption.h"
 #include "logic_database.h"
+#include "logic_security.h"
 #include "gui_dispatcher.h"
 #include "nodemgmt.h"
 #include "utils.h"
 
 
+/*! \fn     logic_database_get_fletter_table_index(uint16_t start_address, cust_char_t start_char, uint16_t credential_type_id, nodemgmt_fletter_table_entry_t** table_pt, uint16_t* nb_entries)
+*   \brief  Get the first letter jump table and the index of a given parent first letter in it
+*   \param  start_address       Parent address
+*   \param  start_char          The parent first char
+*   \param  credential_type_id  Credential type ID
+*   \param  table_pt            Where to store the table pointer
+*   \param  nb_entries          Where to store the number of table entries
+*   \return Index in the table, -1 if the table can't be used for this parent
+*/
+static int16_t logic_database_get_fletter_table_index(uint16_t start_address, cust_char_t start_char, uint16_t credential_type_id, nodemgmt_fletter_table_entry_t** table_pt, uint16_t* nb_entries)
+{
+    parent_node_t temp_pnode;
+    
+    if ((start_address == NODE_ADDR_NULL) || (nodemgmt_get_fletter_table(credential_type_id, table_pt, nb_entries) != RETURN_OK))
+    {
+        return -1;
+    }
+    
+    /* The starting parent should be part of the current category and have the provided first char */
+    nodemgmt_read_parent_node(start_address, &temp_pnode, FALSE);
+    if ((temp_pnode.cred_parent.service[0] != start_char) || (nodemgmt_parent_node_has_logins_with_category(start_address, temp_pnode.cred_parent.nextChildAddress, nodemgmt_get_current_category_flags()) == FALSE))
+    {
+        return -1;
+    }
+    
+    /* Binary search on the first char */
+    uint16_t high = *nb_entries;
+    uint16_t low = 0;
+    while (low < high)
+    {
+        uint16_t middle = (low + high) >> 1;
+        if ((*table_pt)[middle].fchar < start_char)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    
+    if ((low < *nb_entries) && ((*table_pt)[low].fchar == start_char))
+    {
+        return (int16_t)low;
+    }
+    else
+    {
+        return -1;
+    }
+}
+
 /*! \fn     logic_database_get_prev_2_fletters_services(uint16_t start_address, cust_char_t start_char, cust_char_t* char_array, uint16_t credential_type_id)
 *   \brief  Get the previous 2 services with different first letters
 *   \param  start_address       Address at which we should start looking
@@ -51,6 +103,57 @@ uint16_t logic_database_get_prev_2_fletters_services(uint16_t start_address, cus
     temp_pnode.cred_parent.prevParentAddress = start_address;
     char_array[0] = ' '; char_array[1] = ' ';
     
+    /* Use the first letter jump table when possible: services being sorted, each first letter is a single block in the parent list */
+    nodemgmt_fletter_table_entry_t* fletter_table;
+    uint16_t nb_fletters;
+    int16_t start_index = logic_database_get_fletter_table_index(start_address, start_char, credential_type_id, &fletter_table, &nb_fletters);
+    if (start_index >= 0)
+    {
+        /* Go through the letter blocks before ours, as the loop below does with the parents */
+        for (uint16_t i = 1; i < nb_fletters; i++)
+        {
+            uint16_t fletter_index = (start_index + nb_fletters - i) % nb_fletters;
+            
+            if (skip_first_change_bool == FALSE)
+            {
+                char_array[storage_index--] = cur_char;
+                
+                /* First next letter, store address */
+                if (storage_index == 0)
+                {
+                    return_value = last_seen_parent_node_that_fits_category;
+                }
+                
+                /* Did we fill the array? */
+                if (storage_index == -1)
+                {
+                    return return_value;
+                }
+            }
+            else
+            {
+                skip_first_change_bool = FALSE;
+            }
+            
+            cur_char = fletter_table[fletter_index].fchar;
+            last_seen_parent_node_that_fits_category = fletter_table[fletter_index].parent_address;
+        }
+        
+        /* Looped back */
+        if (cur_char != start_char)
+        {
+            char_array[storage_index--] = cur_char;
+            
+            /* First next letter, store address */
+            if (storage_index == 0)
+            {
+                return_value = last_seen_parent_node_that_fits_category;
+            }
+        }
+        
+        return return_value;
+    }
+    
     while(TRUE)
     {
         /* Update current node address */
@@ -76,7 +179,7 @@ uint16_t logic_database_get_prev_2_fletters_services(uint16_t start_address, cus
         nodemgmt_read_parent_node(current_node_addr, &temp_pnode, FALSE);
         
         /* Part of current category? */
-        if (nodemgmt_check_for_logins_with_category_in_parent_node(temp_pnode.cred_parent.nextChildAddress, nodemgmt_get_current_category_flags()) != NODE_ADDR_NULL)
+        if (nodemgmt_parent_node_has_logins_with_category(current_node_addr, temp_pnode.cred_parent.nextChildAddress, nodemgmt_get_current_category_flags()) != FALSE)
         {
             /* Check if the fchar changed */
             if (temp_pnode.cred_parent.service[0] != cur_char)
@@ -145,6 +248,45 @@ uint16_t logic_database_get_next_2_fletters_services(uint16_t start_address, cus
     temp_pnode.cred_parent.nextParentAddress = start_address;
     char_array[0] = ' '; char_array[1] = ' ';
     
+    /* Use the first letter jump table when possible: services being sorted, each first letter is a single block in the parent list */
+    nodemgmt_fletter_table_entry_t* fletter_table;
+    uint16_t nb_fletters;
+    int16_t start_index = logic_database_get_fletter_table_index(start_address, cur_char, credential_type_id, &fletter_table, &nb_fletters);
+    if (start_index >= 0)
+    {
+        /* Go through the letter blocks after ours, wrapping over to our block start if we're not on it */
+        for (uint16_t i = 1; i <= nb_fletters; i++)
+        {
+            uint16_t fletter_index = (start_index + i) % nb_fletters;
+            
+            if ((i == nb_fletters) && (fletter_table[fletter_index].parent_address == start_address))
+            {
+                break;
+            }
+            
+            if (fletter_table[fletter_index].fchar != cur_char)
+            {
+                /* Store node */
+                char_array[storage_index++] = fletter_table[fletter_index].fchar;
+                cur_char = fletter_table[fletter_index].fchar;
+                
+                /* First next letter, store address */
+                if (storage_index == 1)
+                {
+                    return_value = fletter_table[fletter_index].parent_address;
+                }
+                
+                /* Did we fill the array? */
+                if (storage_index == 2)
+                {
+                    break;
+                }
+            }
+        }
+        
+        return return_value;
+    }
+    
     while(TRUE)
     {
         /* Check for credential loop */
@@ -163,7 +305,7 @@ uint16_t logic_database_get_next_2_fletters_services(uint16_t start_address, cus
         nodemgmt_read_parent_node(current_node_addr, &temp_pnode, FALSE);
         
         /* Check if the fchar changed */
-        if ((temp_pnode.cred_parent.service[0] != cur_char) && (nodemgmt_check_for_logins_with_category_in_parent_node(temp_pnode.cred_parent.nextChildAddress, nodemgmt_get_current_category_flags()) != NODE_ADDR_NULL))
+        if ((temp_pnode.cred_parent.service[0] != cur_char) && (nodemgmt_parent_node_has_logins_with_category(current_node_addr, temp_pnode.cred_parent.nextChildAddress, nodemgmt_get_current_category_flags()) != FALSE))
         {            
             /* Store node */
             char_array[storage_index++] = temp_pnode.cred_parent.service[0];
@@ -264,7 +406,7 @@ uint16_t logic_database_search_for_next_data_parent_after_addr(uint16_t node_add
 *   \param  cred_type               set to TRUE to search for credential, FALSE for data 
 *   \param  category_id             Credential/Data category ID
 *   \return Address of the found node, NODE_ADDR_NULL otherwise
-*   \note   Full 8Mb database search has been timed at 581ms
+*   \note   Full 8Mb database search has been timed at 581ms, exact matches use the nodemgmt service name index when possible
 */
 uint16_t logic_database_search_service(cust_char_t* name, service_compare_mode_te compare_type, BOOL cred_type, uint16_t category_id)
 {
@@ -274,6 +416,12 @@ uint16_t logic_database_search_service(cust_char_t* name, service_compare_mode_t
     uint16_t next_node_addr;
     int16_t compare_result;
     
+    /* Exact match: try the service name index, not in MMM as nodes may be freely rewritten by the computer */
+    if ((compare_type == COMPARE_MODE_MATCH) && (logic_security_is_management_mode_set() == FALSE) && (nodemgmt_service_index_lookup(name, (cred_type != FALSE)?FALSE:TRUE, category_id, &next_node_addr) == RETURN_OK))
+    {
+        return next_node_addr;
+    }
+    
     /* Get start node */
     if (cred_type != FALSE)
     {
@@ -240,6 +240,7 @@ void logic_encryption_post_ctr_tasks(uint16_t ctr_inc)
 void logic_encryption_ctr_encrypt(uint8_t* data, uint16_t data_length, uint8_t* ctr_val_used)
 {
         uint8_t credential_ctr[AES256_CTR_LENGTH/8];
+        PROFILING_START(profiling_start);
         
         /* Pre CTR encryption tasks */
         logic_encryption_pre_ctr_tasks((data_length*8 + AES256_CTR_LENGTH - 1)/AES256_CTR_LENGTH);
@@ -259,6 +260,7 @@ void logic_encryption_ctr_encrypt(uint8_t* data, uint16_t data_length, uint8_t*
         
         /* Post CTR encryption tasks */
        logic_encryption_post_ctr_tasks((data_length*8 + AES256_CTR_LENGTH - 1)/AES256_CTR_LENGTH);    
+       PROFILING_STOP(PROFILING_AES_CTR, profiling_start);
 }
 
 /*! \fn     logic_encryption_ctr_decrypt(uint8_t* data, uint8_t* cred_ctr, uint16_t data_length, BOOL old_gen_decrypt)
@@ -271,6 +273,7 @@ void logic_encryption_ctr_encrypt(uint8_t* data, uint16_t data_length, uint8_t*
 void logic_encryption_ctr_decrypt(uint8_t* data, uint8_t* cred_ctr, uint16_t data_length, BOOL old_gen_decrypt)
 {
     uint8_t credential_ctr[AES256_CTR_LENGTH/8];
+    PROFILING_START(profiling_start);
     
     /* Current gen decrypt: add nonce to ctr, decrypt */
     if (old_gen_decrypt == FALSE)
@@ -313,6 +316,7 @@ void logic_encryption_ctr_decrypt(uint8_t* data, uint8_t* cred_ctr, uint16_t dat
     
     /* Reset vars */
     memset(credential_ctr, 0, sizeof(credential_ctr));  
+    PROFILING_STOP(PROFILING_AES_CTR, profiling_start);
 }
 
 
@@ -372,6 +376,7 @@ void logic_encryption_edDSA_init(void)
 */
 void logic_encryption_ecc256_sign(uint8_t const* data, uint8_t* sig, uint16_t sig_buf_len)
 {
+    PROFILING_START(profiling_start);
     size_t result = br_ecdsa_i15_sign_raw(logic_encryption_br_ec_algo, logic_encryption_sha256_ctx.vtable, data, &logic_encryption_fido2_signing_key, sig);
     if (result != sig_buf_len)
     {
@@ -380,6 +385,7 @@ void logic_encryption_ecc256_sign(uint8_t const* data, uint8_t* sig, uint16_t si
     
     // Clear private key used to limit leaking
     memset(logic_encryption_fido2_priv_key_buf, 0, sizeof(logic_encryption_fido2_priv_key_buf));
+    PROFILING_STOP(PROFILING_ECC_SIGN, profiling_start);
 }
 
 /*! \fn     logic_encryption_edDSA_sign(uint8_t const* data, uint8_t* sig, uint16_t sig_buf_len)
@@ -392,9 +398,11 @@ void logic_encryption_ecc256_sign(uint8_t const* data, uint8_t* sig, uint16_t si
 */
 void logic_encryption_edDSA_sign(uint8_t const* data, uint32_t data_len, uint8_t* sig, uint16_t sig_buf_len)
 {
+    PROFILING_START(profiling_start);
     crypto_ed25519_sign(sig, logic_encryption_fido2_edDSA_priv_key, logic_encryption_fido2_edDSA_pub_key, data, data_len);
     /* Wipe the secret key if it is no longer needed */
     crypto_wipe(logic_encryption_fido2_edDSA_priv_key, FIDO2_PRIV_KEY_LEN);
+    PROFILING_STOP(PROFILING_ECC_SIGN, profiling_start);
 }
 
 /*! \fn     logic_encryption_ecc256_load_key(uint8_t const* key)
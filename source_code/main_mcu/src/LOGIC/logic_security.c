@@ -23,6 +23,7 @@
 #include "logic_bluetooth.h"
 #include "logic_security.h"
 #include "logic_aux_mcu.h"
+#include "nodemgmt.h"
 /* Inserted card unlocked */
 volatile BOOL logic_security_smartcard_inserted_unlocked = FALSE;
 /* Memory management mode */
@@ -67,6 +68,10 @@ void logic_security_set_management_mode(BOOL from_usb)
 {
     logic_security_management_mode = TRUE;
     logic_security_management_mode_from_usb = from_usb;
+    
+    /* Nodes may be freely changed in MMM: category cache & first letter table are rebuilt when leaving it */
+    nodemgmt_category_cache_invalidate();
+    nodemgmt_fletter_table_invalidate();
 }
 
 /*! \fn     logic_security_should_leave_management_mode(void)
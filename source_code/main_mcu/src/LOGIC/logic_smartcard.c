@@ -28,6 +28,7 @@
 #include "gui_dispatcher.h"
 #include "logic_security.h"
 #include "logic_aux_mcu.h"
+#include "comms_aux_mcu.h"
 #include "driver_timer.h"
 #include "logic_device.h"
 #include "gui_prompts.h"
@@ -80,6 +81,9 @@ void logic_smartcard_handle_removed(void)
     platform_io_smc_remove_function();
     logic_security_clear_security_bools();
     
+    /* Credentials still queued for typing on the aux MCU shouldn't be typed anymore */
+    comms_aux_mcu_send_simple_command_message(MAIN_MCU_COMMAND_DISCARD_TYPING);
+    
     /* Delete encryption context */
     logic_encryption_delete_context();
 }
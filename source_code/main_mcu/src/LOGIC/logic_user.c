@@ -44,6 +44,8 @@
 #include "rng.h"
 // Boolean to specify if user should be logged off flag
 BOOL logic_user_should_be_logged_off_flag = FALSE;
+// Boolean set when the aux MCU couldn't type all queued symbols
+BOOL logic_user_queued_typing_failed_flag = FALSE;
 // Boolean to know state of lock/unlock feature
 BOOL logic_user_lock_unlock_shortcuts = FALSE;
 // Variables used when adding data to a service
@@ -214,6 +216,28 @@ BOOL logic_user_get_and_clear_user_to_be_logged_off_flag(void)
     return return_value;
 }
 
+/*! \fn     logic_user_set_queued_typing_done(BOOL all_symbols_typed)
+*   \brief  Called when the aux MCU is done typing the queued symbols
+*   \param  all_symbols_typed   If the aux MCU could type all the queued symbols
+*/
+void logic_user_set_queued_typing_done(BOOL all_symbols_typed)
+{
+    if (all_symbols_typed == FALSE)
+    {
+        logic_user_queued_typing_failed_flag = TRUE;
+    }
+}
+
+/*! \fn     logic_user_get_and_clear_queued_typing_failed_flag(void)
+*   \brief  Get and clear the flag that informs that the aux MCU couldn't type all queued symbols
+*/
+BOOL logic_user_get_and_clear_queued_typing_failed_flag(void)
+{
+    BOOL return_value = logic_user_queued_typing_failed_flag;
+    logic_user_queued_typing_failed_flag = FALSE;
+    return return_value;
+}
+
 /*! \fn     logic_user_get_user_security_flags(void)
 *   \brief  Get user security choices
 *   \return The bitmask
@@ -258,6 +282,33 @@ void logic_user_set_layout_id(uint16_t layout_id, BOOL usb_layout)
     }
 }
 
+/*! \fn     logic_user_get_keyboard_type_interface_identifier(uint16_t interface_id, uint16_t* keyboard_symbols)
+*   \brief  Get the interface identifier to put in a keyboard type message
+*   \param  interface_id        Interface ID
+*   \param  keyboard_symbols    0 terminated symbols to be typed, as generated for the selected layout
+*   \return Interface identifier, flagged for fast typing if enabled and compatible with the layout
+*   \note   Layouts needing dead keys or key sequences for the symbols keep the standard typing
+*/
+uint16_t logic_user_get_keyboard_type_interface_identifier(uint16_t interface_id, uint16_t* keyboard_symbols)
+{
+    if (custom_fs_settings_get_device_setting(SETTINGS_FAST_TYPING) == FALSE)
+    {
+        return interface_id;
+    }
+    
+    /* Look for dead keys (bit 15) or key sequences (bits 8 to 14), ignoring non typable points */
+    while (*keyboard_symbols != 0)
+    {
+        if ((*keyboard_symbols != 0xFFFF) && ((*keyboard_symbols & 0xFF00) != 0))
+        {
+            return interface_id;
+        }
+        keyboard_symbols++;
+    }
+    
+    return interface_id | KEYBOARD_TYPE_FAST_TYPING_FLAG;
+}
+
 /*! \fn     logic_user_get_current_user_id(void)
 *   \brief  Get current user ID
 *   \return User ID
@@ -649,6 +700,64 @@ fido2_return_code_te logic_user_store_webauthn_credential(cust_char_t* rp_id, ui
     }
 }
 
+/*! \fn     logic_user_fetch_and_decrypt_next_data_chunk(uint8_t* buffer, uint16_t* nb_bytes_written, BOOL just_starting_to_get_data)
+*   \brief  Fetch the next data node of the service currently being read, decrypt it and advance the CTR
+*   \param  buffer                      Where to store the decoded data
+*   \param  nb_bytes_written            Where to store the number of bytes written, 0 when there is no more data
+*   \param  just_starting_to_get_data   Set to TRUE if this is the first chunk of a new data read
+*/
+static void logic_user_fetch_and_decrypt_next_data_chunk(uint8_t* buffer, uint16_t* nb_bytes_written, BOOL just_starting_to_get_data)
+{
+    /* Check for data */
+    if (logic_user_next_data_child_addr == NODE_ADDR_NULL)
+    {
+        *nb_bytes_written = 0;
+        return;
+    }
+    
+    /* Fetch data from database */
+    logic_user_next_data_child_addr = nodemgmt_get_encrypted_data_from_data_node(logic_user_next_data_child_addr, buffer, nb_bytes_written);
+    
+    /* Adjust nb bytes written if previous gen data */
+    if (logic_user_getting_data_from_service_prev_gen_flag != FALSE)
+    {
+        *nb_bytes_written = NODEMGMG_OLD_GEN_DATA_BLOCK_LENGTH;
+    }
+    
+    /* Decrypt data (nb_bytes_written is sanitized by nodemgmt call) */
+    logic_encryption_ctr_decrypt(buffer, logic_user_getting_data_ctr_value, *nb_bytes_written, logic_user_getting_data_from_service_prev_gen_flag);
+    
+    /* Odd case to make moolticute's life easier: directly trim data if the data size is less than 128B */
+    if ((logic_user_getting_data_from_service_prev_gen_flag != FALSE) && (logic_user_next_data_child_addr == NODE_ADDR_NULL) && (just_starting_to_get_data != FALSE))
+    {
+        /* first 4B contain payload size */
+        *nb_bytes_written = buffer[2];
+        *nb_bytes_written <<= 8;
+        *nb_bytes_written += buffer[3];
+        
+        /* Sanitize nb_bytes_written */
+        if (*nb_bytes_written > NODEMGMG_OLD_GEN_DATA_BLOCK_LENGTH)
+        {
+            *nb_bytes_written = NODEMGMG_OLD_GEN_DATA_BLOCK_LENGTH;
+        }
+        
+        /* Shift data */
+        for (uint16_t i = 0; i < NODEMGMG_OLD_GEN_DATA_BLOCK_LENGTH - 4; i++)
+        {
+            buffer[i] = buffer[i + 4];
+        }
+    }
+    
+    /* Increment CTR */
+    uint16_t ctr_inc = ((*nb_bytes_written)*8 + AES256_CTR_LENGTH - 1)/AES256_CTR_LENGTH;
+    for (int16_t i = sizeof(logic_user_getting_data_ctr_value)-1; i >= 0; i--)
+    {
+        ctr_inc = ((uint16_t)logic_user_getting_data_ctr_value[i]) + ctr_inc;
+        logic_user_getting_data_ctr_value[i] = (uint8_t)(ctr_inc);
+        ctr_inc = (ctr_inc >> 8) & 0x00FF;
+    }
+}
+
 /*! \fn     logic_user_get_data_from_service(cust_char_t* service, uint8_t* buffer, uint16_t* nb_bytes_written, BOOL is_message_from_usb, nodemgmt_data_category_te data_type)
 *   \brief  Fetch data from service
 *   \param  service             If different than 0, service we want to fetch data from. If 0, request from next chunk of data
@@ -764,56 +873,31 @@ RET_TYPE logic_user_get_data_from_service(cust_char_t* service, uint8_t* buffer,
         return RETURN_NOK;
     }
     
-    /* Check for data */
-    if (logic_user_next_data_child_addr == NODE_ADDR_NULL)
-    {
-        *nb_bytes_written = 0;
-        return RETURN_OK;
-    }
-    
-    /* Fetch data from database */
-    logic_user_next_data_child_addr = nodemgmt_get_encrypted_data_from_data_node(logic_user_next_data_child_addr, buffer, nb_bytes_written);
-    
-    /* Adjust nb bytes written if previous gen data */
-    if (logic_user_getting_data_from_service_prev_gen_flag != FALSE)
-    {
-        *nb_bytes_written = NODEMGMG_OLD_GEN_DATA_BLOCK_LENGTH;
-    }
-    
-    /* Decrypt data (nb_bytes_written is sanitized by nodemgmt call) */
-    logic_encryption_ctr_decrypt(buffer, logic_user_getting_data_ctr_value, *nb_bytes_written, logic_user_getting_data_from_service_prev_gen_flag);
-    
-    /* Odd case to make moolticute's life easier: directly trim data if the data size is less than 128B */
-    if ((logic_user_getting_data_from_service_prev_gen_flag != FALSE) && (logic_user_next_data_child_addr == NODE_ADDR_NULL) && (just_starting_to_get_data != FALSE))
-    {
-        /* first 4B contain payload size */
-        *nb_bytes_written = buffer[2];
-        *nb_bytes_written <<= 8;
-        *nb_bytes_written += buffer[3];
-        
-        /* Sanitize nb_bytes_written */
-        if (*nb_bytes_written > NODEMGMG_OLD_GEN_DATA_BLOCK_LENGTH)
-        {
-            *nb_bytes_written = NODEMGMG_OLD_GEN_DATA_BLOCK_LENGTH;
-        }
-        
-        /* Shift data */
-        for (uint16_t i = 0; i < NODEMGMG_OLD_GEN_DATA_BLOCK_LENGTH - 4; i++)
-        {
-            buffer[i] = buffer[i + 4];
-        }
-    }
+    /* Fetch and decrypt next chunk */
+    logic_user_fetch_and_decrypt_next_data_chunk(buffer, nb_bytes_written, just_starting_to_get_data);
     
-    /* Increment CTR */
-    uint16_t ctr_inc = ((*nb_bytes_written)*8 + AES256_CTR_LENGTH - 1)/AES256_CTR_LENGTH;
-    for (int16_t i = sizeof(logic_user_getting_data_ctr_value)-1; i >= 0; i--)
+    /* Return success */
+    return RETURN_OK;
+}
+
+/*! \fn     logic_user_get_next_data_chunk(uint8_t* buffer, uint16_t* nb_bytes_written, BOOL is_message_from_usb)
+*   \brief  Fetch the next data chunk of the service currently being read
+*   \param  buffer              Where to store the decoded data
+*   \param  nb_bytes_written    Where to store the number of bytes written, 0 when there is no more data
+*   \param  is_message_from_usb BOOL set to true if the request comes from USB
+*   \return success or not
+*   \note   Data reading must have been started by logic_user_get_data_from_service() for the same origin
+*/
+RET_TYPE logic_user_get_next_data_chunk(uint8_t* buffer, uint16_t* nb_bytes_written, BOOL is_message_from_usb)
+{
+    /* Smartcard present and unlocked, data reading started from the same origin? */
+    if ((logic_security_is_smc_inserted_unlocked() == FALSE) || (logic_user_getting_data_from_service == FALSE) || (is_message_from_usb != logic_user_getting_data_from_service_from_usb))
     {
-        ctr_inc = ((uint16_t)logic_user_getting_data_ctr_value[i]) + ctr_inc;
-        logic_user_getting_data_ctr_value[i] = (uint8_t)(ctr_inc);
-        ctr_inc = (ctr_inc >> 8) & 0x00FF;
+        return RETURN_NOK;
     }
     
-    /* Return success */
+    /* Fetch and decrypt next chunk */
+    logic_user_fetch_and_decrypt_next_data_chunk(buffer, nb_bytes_written, FALSE);
     return RETURN_OK;
 }
 
@@ -2031,9 +2115,7 @@ RET_TYPE logic_user_ask_for_credentials_keyb_output(uint16_t parent_address, uin
     _Static_assert(MEMBER_ARRAY_SIZE(keyboard_type_message_t,keyboard_symbols) > MEMBER_ARRAY_SIZE(child_cred_node_t,login)+1, "Can't describe all chars for login");
     uint16_t interface_id = (*usb_selected == FALSE)? 1:0;
     BOOL anything_typed = FALSE;
-    aux_mcu_message_t* temp_rx_message;
     child_cred_node_t temp_cnode;
-    BOOL could_type_all_symbols;
     BOOL shortcut_sent = FALSE;
     parent_node_t temp_pnode;
     BOOL password_decrypted = FALSE;
@@ -2189,18 +2271,11 @@ RET_TYPE logic_user_ask_for_credentials_keyb_output(uint16_t parent_address, uin
                         }
                         custom_fs_get_keyboard_symbols_for_unicode_string(&typing_message_to_be_sent->keyboard_type_message.keyboard_symbols[utils_strlen(temp_cnode.login)], &typing_message_to_be_sent->keyboard_type_message.keyboard_symbols[utils_strlen(temp_cnode.login)], *usb_selected);
                         typing_message_to_be_sent->keyboard_type_message.delay_between_types = custom_fs_settings_get_device_setting(SETTINGS_DELAY_BETWEEN_PRESSES);
-                        typing_message_to_be_sent->keyboard_type_message.interface_identifier = interface_id;
+                        typing_message_to_be_sent->keyboard_type_message.interface_identifier = logic_user_get_keyboard_type_interface_identifier(interface_id, typing_message_to_be_sent->keyboard_type_message.keyboard_symbols) | KEYBOARD_TYPE_QUEUE_FLAG;
                         comms_aux_mcu_send_message(typing_message_to_be_sent);
                         
-                        /* Wait for typing status */
-                        while(comms_aux_mcu_active_wait(&temp_rx_message, AUX_MCU_MSG_TYPE_KEYBOARD_TYPE, FALSE, -1) != RETURN_OK){}
-                        could_type_all_symbols = (BOOL)temp_rx_message->payload_as_uint16[0];
-                            
-                        /* Rearm DMA RX */
-                        comms_aux_arm_rx_and_clear_no_comms();
-                        
-                        /* Display warning if some chars were missing */
-                        if ((string_to_key_points_transform_success != RETURN_OK) || (could_type_all_symbols == FALSE))
+                        /* Aux MCU types in the background and reports missing chars with AUX_MCU_EVENT_TYPING_DONE: only warn for non converted chars here */
+                        if (string_to_key_points_transform_success != RETURN_OK)
                         {
                             if (gui_prompts_display_information_on_screen_and_wait(COULDNT_TYPE_CHARS_TEXT_ID, DISP_MSG_WARNING, FALSE) == GUI_INFO_DISP_RET_CARD_CHANGE)
                             {
@@ -2327,18 +2402,11 @@ RET_TYPE logic_user_ask_for_credentials_keyb_output(uint16_t parent_address, uin
                         }
                         custom_fs_get_keyboard_symbols_for_unicode_string(&typing_message_to_be_sent->keyboard_type_message.keyboard_symbols[utils_strlen(temp_cnode.cust_char_password)], &typing_message_to_be_sent->keyboard_type_message.keyboard_symbols[utils_strlen(temp_cnode.cust_char_password)], *usb_selected);
                         typing_message_to_be_sent->keyboard_type_message.delay_between_types = custom_fs_settings_get_device_setting(SETTINGS_DELAY_BETWEEN_PRESSES);
-                        typing_message_to_be_sent->keyboard_type_message.interface_identifier = interface_id;
+                        typing_message_to_be_sent->keyboard_type_message.interface_identifier = logic_user_get_keyboard_type_interface_identifier(interface_id, typing_message_to_be_sent->keyboard_type_message.keyboard_symbols) | KEYBOARD_TYPE_QUEUE_FLAG;
                         comms_aux_mcu_send_message(typing_message_to_be_sent);
                         
-                        /* Wait for typing status */
-                        while(comms_aux_mcu_active_wait(&temp_rx_message, AUX_MCU_MSG_TYPE_KEYBOARD_TYPE, FALSE, -1) != RETURN_OK){}
-                        could_type_all_symbols = (BOOL)temp_rx_message->payload_as_uint16[0];
-                        
-                        /* Rearm DMA RX */
-                        comms_aux_arm_rx_and_clear_no_comms();
-                        
-                        /* Display warning if some chars were missing */
-                        if ((string_to_key_points_transform_success != RETURN_OK) || (could_type_all_symbols == FALSE))
+                        /* Display warning if some chars couldn't be converted */
+                        if (string_to_key_points_transform_success != RETURN_OK)
                         {
                             if (gui_prompts_display_information_on_screen_and_wait(COULDNT_TYPE_CHARS_TEXT_ID, DISP_MSG_WARNING, FALSE) == GUI_INFO_DISP_RET_CARD_CHANGE)
                             {
@@ -2458,21 +2526,14 @@ RET_TYPE logic_user_ask_for_credentials_keyb_output(uint16_t parent_address, uin
 
                     custom_fs_get_keyboard_symbols_for_unicode_string(&typing_message_to_be_sent->keyboard_type_message.keyboard_symbols[TOTP_len], &typing_message_to_be_sent->keyboard_type_message.keyboard_symbols[TOTP_len], *usb_selected);
                     typing_message_to_be_sent->keyboard_type_message.delay_between_types = custom_fs_settings_get_device_setting(SETTINGS_DELAY_BETWEEN_PRESSES);
-                    typing_message_to_be_sent->keyboard_type_message.interface_identifier = interface_id;
+                    typing_message_to_be_sent->keyboard_type_message.interface_identifier = logic_user_get_keyboard_type_interface_identifier(interface_id, typing_message_to_be_sent->keyboard_type_message.keyboard_symbols) | KEYBOARD_TYPE_QUEUE_FLAG;
                     comms_aux_mcu_send_message(typing_message_to_be_sent);
 
                     /* Message is sent, clear everything */
                     memset(&temp_cnode, 0, sizeof(temp_cnode));
 
-                    /* Wait for typing status */
-                    while(comms_aux_mcu_active_wait(&temp_rx_message, AUX_MCU_MSG_TYPE_KEYBOARD_TYPE, FALSE, -1) != RETURN_OK){}
-                    could_type_all_symbols = (BOOL)temp_rx_message->payload_as_uint16[0];
-
-                    /* Rearm DMA RX */
-                    comms_aux_arm_rx_and_clear_no_comms();
-
-                    /* Display warning if some chars were missing */
-                    if ((string_to_key_points_transform_success != RETURN_OK) || (could_type_all_symbols == FALSE))
+                    /* Display warning if some chars couldn't be converted */
+                    if (string_to_key_points_transform_success != RETURN_OK)
                     {
                         gui_prompts_display_information_on_screen_and_wait(COULDNT_TYPE_CHARS_TEXT_ID, DISP_MSG_WARNING, FALSE);
                     }
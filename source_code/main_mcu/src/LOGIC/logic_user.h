@@ -39,6 +39,7 @@ RET_TYPE logic_user_ask_for_credentials_keyb_output(uint16_t parent_address, uin
 fido2_return_code_te logic_user_store_webauthn_credential(cust_char_t* rp_id, uint8_t* user_handle, uint8_t user_handle_len, cust_char_t* user_name, cust_char_t* display_name, uint8_t* private_key, uint8_t* credential_id, uint8_t keyType);
 ret_type_te logic_user_create_new_user_for_existing_card(cpz_lut_entry_t* cpz_entry, uint16_t sec_preferences, uint16_t language_id, uint16_t usb_layout_id, uint16_t ble_layout_id, uint8_t* new_user_id);
 RET_TYPE logic_user_get_data_from_service(cust_char_t* service, uint8_t* buffer, uint16_t* nb_bytes_written, BOOL is_message_from_usb, nodemgmt_data_category_te data_type);
+RET_TYPE logic_user_get_next_data_chunk(uint8_t* buffer, uint16_t* nb_bytes_written, BOOL is_message_from_usb);
 RET_TYPE logic_user_store_credential(cust_char_t* service, cust_char_t* login, cust_char_t* desc, cust_char_t* third, cust_char_t* password);
 RET_TYPE logic_user_add_data_to_current_service(hid_message_store_data_into_file_t* store_data_request, BOOL is_message_from_usb);
 RET_TYPE logic_user_empty_data_service(cust_char_t* service, BOOL is_message_from_usb, nodemgmt_data_category_te data_type);
@@ -53,8 +54,11 @@ RET_TYPE logic_user_is_bluetooth_enabled_for_inserted_card(uint16_t* user_langua
 void logic_user_change_node_password(uint16_t node_address, cust_char_t* password);
 void logic_user_inform_computer_locked_state(BOOL usb_interface, BOOL locked);
 void logic_user_set_preferred_starting_service(uint16_t service_addr);
+uint16_t logic_user_get_keyboard_type_interface_identifier(uint16_t interface_id, uint16_t* keyboard_symbols);
 void logic_user_set_layout_id(uint16_t layout_id, BOOL usb_layout);
+void logic_user_set_queued_typing_done(BOOL all_symbols_typed);
 void logic_user_reset_computer_locked_state(BOOL usb_interface);
+BOOL logic_user_get_and_clear_queued_typing_failed_flag(void);
 BOOL logic_user_get_and_clear_user_to_be_logged_off_flag(void);
 void logic_user_clear_user_security_flag(uint16_t bitmask);
 void logic_user_invalidate_preferred_starting_service(void);
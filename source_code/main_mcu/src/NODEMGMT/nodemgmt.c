@@ -38,6 +38,50 @@
 nodemgmtHandle_t nodemgmt_current_handle;
 // Current date
 uint16_t nodemgmt_current_date;
+#ifdef NODEMGMT_SERVICE_INDEX
+// Service name index, sorted by key
+nodemgmt_service_index_entry_t nodemgmt_service_index[NODEMGMT_SVC_INDEX_MAX_ENTRIES];
+// Number of entries in the service name index
+uint16_t nodemgmt_service_index_nb_entries = 0;
+// Set when the service name index covers all the current user parent nodes
+BOOL nodemgmt_service_index_valid = FALSE;
+#endif
+#ifdef NODEMGMT_NODE_USAGE_BITMAP
+// Node slot groups usage bitmap (bit set: all NODEMGMT_NODE_USAGE_GROUP_SLOTS slots known to be used), slot 0 being the first node of page PAGE_PER_SECTOR
+uint32_t nodemgmt_node_usage_bitmap[(NODEMGMT_NB_NODE_SLOTS/NODEMGMT_NODE_USAGE_GROUP_SLOTS+31)/32];
+#endif
+#ifdef NODEMGMT_CATEGORY_CACHE
+// Credential parent addresses in the category cache, sorted
+uint16_t nodemgmt_category_cache_addresses[NODEMGMT_CAT_CACHE_MAX_ENTRIES];
+// Category masks for the parents above: bit n set when a child of category id n exists
+uint8_t nodemgmt_category_cache_masks[NODEMGMT_CAT_CACHE_MAX_ENTRIES];
+// Number of entries in the category cache
+uint16_t nodemgmt_category_cache_nb_entries = 0;
+// Set when the category cache covers all the current user credential parent nodes
+BOOL nodemgmt_category_cache_valid = FALSE;
+#endif
+#ifdef NODEMGMT_FLETTER_TABLE
+// First letter jump table, sorted by first char
+nodemgmt_fletter_table_entry_t nodemgmt_fletter_table[NODEMGMT_FLETTER_TABLE_MAX_ENTRIES];
+// Number of entries in the first letter jump table
+uint16_t nodemgmt_fletter_table_nb_entries = 0;
+// Credential type ID & category flags the first letter jump table was built for
+uint16_t nodemgmt_fletter_table_cred_type_id = 0;
+uint16_t nodemgmt_fletter_table_category_flags = 0;
+// Set when the first letter jump table is up to date
+BOOL nodemgmt_fletter_table_valid = FALSE;
+#endif
+#ifdef NODEMGMT_CHANGE_JOURNAL
+// Change journal: addresses of the nodes written or deleted since the journal base change numbers
+uint16_t nodemgmt_journal_addresses[NODEMGMT_JOURNAL_MAX_ENTRIES];
+uint16_t nodemgmt_journal_nb_entries = 0;
+uint32_t nodemgmt_journal_base_cred_change_number = 0;
+uint32_t nodemgmt_journal_base_data_change_number = 0;
+// Set when more nodes were changed than the journal can store
+BOOL nodemgmt_journal_overflow = TRUE;
+// Set when the user profile (start addresses, favorites, category strings...) was written
+BOOL nodemgmt_journal_profile_changed = FALSE;
+#endif
 
 
 /*! \fn     nodemgmt_set_current_date(uint16_t date)
@@ -257,6 +301,131 @@ RET_TYPE nodemgmt_check_user_permission(uint16_t node_addr, node_type_te* node_t
     }
 }
 
+/*! \fn     nodemgmt_update_node_usage_bitmap(uint16_t address, uint16_t flags)
+*   \brief  Update the node usage bitmap for a base node that was just written
+*   \param  address     Base node address
+*   \param  flags       Flags that were written for that base node
+*   \note   Groups are only marked as used by nodemgmt_find_free_nodes, once it read all their flags
+*/
+static void nodemgmt_update_node_usage_bitmap(uint16_t address, uint16_t flags)
+{
+    #ifdef NODEMGMT_NODE_USAGE_BITMAP
+    uint16_t page = nodemgmt_page_from_address(address);
+    
+    /* Boundary checks */
+    if ((page < PAGE_PER_SECTOR) || (page >= PAGE_COUNT))
+    {
+        return;
+    }
+    
+    /* Freed slot: its group isn't fully used anymore */
+    uint16_t group = ((page - PAGE_PER_SECTOR)*NODEMGMT_NB_BASE_NODES_PER_PAGE + nodemgmt_node_from_address(address)) / NODEMGMT_NODE_USAGE_GROUP_SLOTS;
+    if (validBitFromFlags(flags) != NODEMGMT_VBIT_VALID)
+    {
+        nodemgmt_node_usage_bitmap[group >> 5] &= ~(1UL << (group & 0x1F));
+    }
+    #endif
+}
+
+/*! \fn     nodemgmt_journal_node_change(uint16_t address)
+*   \brief  Add a written or deleted node to the change journal
+*   \param  address     Node address
+*/
+static void nodemgmt_journal_node_change(uint16_t address)
+{
+    #ifdef NODEMGMT_CHANGE_JOURNAL
+    /* Already journaled? */
+    for (uint16_t i = 0; i < nodemgmt_journal_nb_entries; i++)
+    {
+        if (nodemgmt_journal_addresses[i] == address)
+        {
+            return;
+        }
+    }
+    
+    if (nodemgmt_journal_nb_entries < ARRAY_SIZE(nodemgmt_journal_addresses))
+    {
+        nodemgmt_journal_addresses[nodemgmt_journal_nb_entries++] = address;
+    }
+    else
+    {
+        nodemgmt_journal_overflow = TRUE;
+    }
+    #else
+    (void)address;
+    #endif
+}
+
+/*! \fn     nodemgmt_journal_profile_change(void)
+*   \brief  Record in the change journal that the user profile was written
+*/
+static void nodemgmt_journal_profile_change(void)
+{
+    #ifdef NODEMGMT_CHANGE_JOURNAL
+    nodemgmt_journal_profile_changed = TRUE;
+    #endif
+}
+
+/*! \fn     nodemgmt_restart_change_journal(void)
+*   \brief  Empty the change journal, taking the current change numbers as its base
+*   \note   To be called at login and when a host tells us it is in sync
+*/
+void nodemgmt_restart_change_journal(void)
+{
+    #ifdef NODEMGMT_CHANGE_JOURNAL
+    nodemgmt_journal_base_cred_change_number = nodemgmt_get_cred_change_number();
+    nodemgmt_journal_base_data_change_number = nodemgmt_get_data_change_number();
+    nodemgmt_journal_overflow = FALSE;
+    nodemgmt_journal_profile_changed = FALSE;
+    nodemgmt_journal_nb_entries = 0;
+    #endif
+}
+
+/*! \fn     nodemgmt_get_change_journal(uint32_t cred_change_number, uint32_t data_change_number, uint16_t** addresses_pt, uint16_t* nb_addresses, BOOL* profile_changed)
+*   \brief  Get the addresses of the nodes changed since the journal base change numbers
+*   \param  cred_change_number  Credential change number known by the host
+*   \param  data_change_number  Data change number known by the host
+*   \param  addresses_pt        Where to store the pointer to the addresses
+*   \param  nb_addresses        Where to store the number of addresses
+*   \param  profile_changed     Where to store if the user profile was written as well
+*   \return TRUE if the journal lists all the nodes changed since the provided change numbers
+*   \note   Without NODEMGMT_CHANGE_JOURNAL, always returns FALSE with an empty list
+*/
+BOOL nodemgmt_get_change_journal(uint32_t cred_change_number, uint32_t data_change_number, uint16_t** addresses_pt, uint16_t* nb_addresses, BOOL* profile_changed)
+{
+    #ifndef NODEMGMT_CHANGE_JOURNAL
+    (void)cred_change_number;
+    (void)data_change_number;
+    *addresses_pt = (uint16_t*)0;
+    *nb_addresses = 0;
+    *profile_changed = TRUE;
+    return FALSE;
+    #else
+    *addresses_pt = nodemgmt_journal_addresses;
+    *nb_addresses = nodemgmt_journal_nb_entries;
+    *profile_changed = nodemgmt_journal_profile_changed;
+    
+    if ((nodemgmt_journal_overflow == FALSE) && (cred_change_number == nodemgmt_journal_base_cred_change_number) && (data_change_number == nodemgmt_journal_base_data_change_number))
+    {
+        return TRUE;
+    }
+    else
+    {
+        return FALSE;
+    }
+    #endif
+}
+
+/*! \fn     nodemgmt_clear_node_usage_bitmap(void)
+*   \brief  Forget which node slot groups are fully used, nodemgmt_find_free_nodes will learn them again
+*/
+void nodemgmt_clear_node_usage_bitmap(void)
+{
+    #ifdef NODEMGMT_NODE_USAGE_BITMAP
+    memset(nodemgmt_node_usage_bitmap, 0, sizeof(nodemgmt_node_usage_bitmap));
+    #endif
+}
+
 /*! \fn     nodemgmt_write_parent_node_data_block_to_flash(uint16_t address, parent_node_t* parent_node)
 *   \brief  Write a parent node data block to flash
 *   \param  address     Where to write
@@ -268,6 +437,8 @@ void nodemgmt_write_parent_node_data_block_to_flash(uint16_t address, parent_nod
     nodemgmt_check_address_validity_and_lock(address);
     nodemgmt_user_id_to_flags(&(parent_node->cred_parent.flags), nodemgmt_current_handle.currentUserId);
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_page_from_address(address), BASE_NODE_SIZE * nodemgmt_node_from_address(address), BASE_NODE_SIZE, (void*)parent_node->node_as_bytes);
+    nodemgmt_update_node_usage_bitmap(address, parent_node->cred_parent.flags);
+    nodemgmt_journal_node_change(address);
 }
 
 /*! \fn     nodemgmt_write_child_node_block_to_flash(uint16_t address, child_node_t* child_node, BOOL write_category)
@@ -296,6 +467,9 @@ void nodemgmt_write_child_node_block_to_flash(uint16_t address, child_node_t* ch
     nodemgmt_check_address_validity_and_lock(address);
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_page_from_address(address), BASE_NODE_SIZE * nodemgmt_node_from_address(address), BASE_NODE_SIZE, (void*)child_node->node_as_bytes);
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_page_from_address(nodemgmt_get_incremented_address(address)), BASE_NODE_SIZE * nodemgmt_node_from_address(nodemgmt_get_incremented_address(address)), BASE_NODE_SIZE, (void*)(&child_node->node_as_bytes[BASE_NODE_SIZE]));
+    nodemgmt_update_node_usage_bitmap(nodemgmt_get_incremented_address(address), child_node->cred_child.fakeFlags);
+    nodemgmt_update_node_usage_bitmap(address, child_node->cred_child.flags);
+    nodemgmt_journal_node_change(address);
 }
 
 /*! \fn     nodemgmt_read_parent_node_data_block_from_flash(uint16_t address, parent_node_t* parent_node)
@@ -887,6 +1061,7 @@ void nodemgmt_get_bluetooth_bonding_information_irks(uint16_t* nb_keys, uint8_t*
  */
 void nodemgmt_store_user_sec_preferences(uint16_t sec_preferences)
 {
+    nodemgmt_journal_profile_change();
     // Write data parent address in the user profile page
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserProfile, nodemgmt_current_handle.offsetUserProfile + (size_t)offsetof(nodemgmt_userprofile_t, main_data.sec_preferences), sizeof(sec_preferences), (void*)&sec_preferences);
 }
@@ -911,6 +1086,7 @@ uint16_t nodemgmt_get_user_sec_preferences(void)
  */
 void nodemgmt_store_user_language(uint16_t languageId)
 {
+    nodemgmt_journal_profile_change();
     // Write data parent address in the user profile page
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserProfile, nodemgmt_current_handle.offsetUserProfile + (size_t)offsetof(nodemgmt_userprofile_t, main_data.language_id), sizeof(languageId), (void*)&languageId);
 }
@@ -921,6 +1097,7 @@ void nodemgmt_store_user_language(uint16_t languageId)
  */
 void nodemgmt_store_user_layout(uint16_t layoutId)
 {
+    nodemgmt_journal_profile_change();
     // Write data parent address in the user profile page
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserProfile, nodemgmt_current_handle.offsetUserProfile + (size_t)offsetof(nodemgmt_userprofile_t, main_data.layout_id), sizeof(layoutId), (void*)&layoutId);
 }
@@ -931,6 +1108,7 @@ void nodemgmt_store_user_layout(uint16_t layoutId)
  */
 void nodemgmt_store_user_ble_layout(uint16_t layoutId)
 {
+    nodemgmt_journal_profile_change();
     // Write data parent address in the user profile page
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserProfile, nodemgmt_current_handle.offsetUserProfile + (size_t)offsetof(nodemgmt_userprofile_t, main_data.ble_layout_id), sizeof(layoutId), (void*)&layoutId);
 }
@@ -1131,6 +1309,313 @@ uint16_t nodemgmt_check_for_logins_with_category_in_parent_node(uint16_t start_c
     return NODE_ADDR_NULL;
 }
 
+/*! \fn     nodemgmt_category_cache_invalidate(void)
+ *  \brief  Invalidate the category cache, category checks will then fall back to browsing the children lists
+ */
+void nodemgmt_category_cache_invalidate(void)
+{
+    #ifdef NODEMGMT_CATEGORY_CACHE
+    nodemgmt_category_cache_nb_entries = 0;
+    nodemgmt_category_cache_valid = FALSE;
+    #endif
+}
+
+#ifdef NODEMGMT_CATEGORY_CACHE
+
+/*! \fn     nodemgmt_category_cache_get_mask_bit(uint16_t category_flags)
+ *  \brief  Get the category cache mask bit for given category flags
+ *  \param  category_flags  Category flags, as stored in a child node
+ *  \return Mask bit, NODEMGMT_CAT_CACHE_NONSTD_CAT_BIT for flags not matching a category id
+ */
+static uint8_t nodemgmt_category_cache_get_mask_bit(uint16_t category_flags)
+{
+    _Static_assert(NODEMGMT_NB_MAX_CATEGORIES <= 7, "Category cache mask can't store all categories");
+    
+    for (uint16_t i = 0; i < NODEMGMT_NB_MAX_CATEGORIES; i++)
+    {
+        if (((i == 0) && (category_flags == 0)) || ((i != 0) && (category_flags == (1 << (i-1)))))
+        {
+            return (uint8_t)(1 << i);
+        }
+    }
+    
+    return NODEMGMT_CAT_CACHE_NONSTD_CAT_BIT;
+}
+
+/*! \fn     nodemgmt_category_mask_has_category(uint8_t mask, uint16_t category_flags)
+ *  \brief  Check if a category mask contains children of a given (standard) category
+ *  \param  mask            Category mask
+ *  \param  category_flags  Category flags, 0 for all categories
+ *  \return TRUE if it does
+ */
+static BOOL nodemgmt_category_mask_has_category(uint8_t mask, uint16_t category_flags)
+{
+    if (category_flags == 0)
+    {
+        return (mask != 0)? TRUE : FALSE;
+    }
+    else
+    {
+        return ((mask & nodemgmt_category_cache_get_mask_bit(category_flags)) != 0)? TRUE : FALSE;
+    }
+}
+
+/*! \fn     nodemgmt_category_cache_get_index(uint16_t parent_addr)
+ *  \brief  Get the index at which a parent address is (or should be inserted) in the category cache
+ *  \param  parent_addr     Parent address
+ *  \return The index
+ */
+static uint16_t nodemgmt_category_cache_get_index(uint16_t parent_addr)
+{
+    uint16_t high = nodemgmt_category_cache_nb_entries;
+    uint16_t low = 0;
+    
+    while (low < high)
+    {
+        uint16_t middle = (low + high) >> 1;
+        if (nodemgmt_category_cache_addresses[middle] < parent_addr)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    
+    return low;
+}
+
+/*! \fn     nodemgmt_category_cache_add_to_mask(uint16_t parent_addr, uint8_t mask)
+ *  \brief  Add category bits to a parent mask in the category cache, creating the entry if needed
+ *  \param  parent_addr     Parent address
+ *  \param  mask            Category bits to add
+ *  \note   Cache is invalidated when full
+ */
+static void nodemgmt_category_cache_add_to_mask(uint16_t parent_addr, uint8_t mask)
+{
+    /* Only maintain a valid cache */
+    if (nodemgmt_category_cache_valid == FALSE)
+    {
+        return;
+    }
+    
+    /* Already in cache? */
+    uint16_t index = nodemgmt_category_cache_get_index(parent_addr);
+    if ((index < nodemgmt_category_cache_nb_entries) && (nodemgmt_category_cache_addresses[index] == parent_addr))
+    {
+        nodemgmt_category_cache_masks[index] |= mask;
+        return;
+    }
+    
+    /* Cache full: invalidate it */
+    if (nodemgmt_category_cache_nb_entries >= ARRAY_SIZE(nodemgmt_category_cache_addresses))
+    {
+        nodemgmt_category_cache_invalidate();
+        return;
+    }
+    
+    /* Insert new entry */
+    memmove(&nodemgmt_category_cache_addresses[index+1], &nodemgmt_category_cache_addresses[index], (nodemgmt_category_cache_nb_entries - index)*sizeof(nodemgmt_category_cache_addresses[0]));
+    memmove(&nodemgmt_category_cache_masks[index+1], &nodemgmt_category_cache_masks[index], (nodemgmt_category_cache_nb_entries - index)*sizeof(nodemgmt_category_cache_masks[0]));
+    nodemgmt_category_cache_addresses[index] = parent_addr;
+    nodemgmt_category_cache_masks[index] = mask;
+    nodemgmt_category_cache_nb_entries++;
+}
+
+/*! \fn     nodemgmt_category_cache_compute_mask(uint16_t start_child_addr)
+ *  \brief  Compute the category mask of a children list
+ *  \param  start_child_addr    Address of the first child
+ *  \return The category mask
+ */
+static uint8_t nodemgmt_category_cache_compute_mask(uint16_t start_child_addr)
+{
+    uint16_t next_child_node_addr_to_scan = start_child_addr;
+    uint16_t child_read_buffer[4];
+    uint8_t mask = 0;
+    
+    /* Sanity check for this hack */
+    _Static_assert(0 == offsetof(child_cred_node_t, flags), "Incorrect buffer for flags & addr read");
+    _Static_assert(4 == offsetof(child_cred_node_t, nextChildAddress), "Incorrect buffer for flags & addr read");
+    
+    /* Hack to read flags & prev / next address */
+    child_cred_node_t* child_node_pt = (child_cred_node_t*)child_read_buffer;
+    
+    /* Loop in children */
+    while (next_child_node_addr_to_scan != NODE_ADDR_NULL)
+    {
+        /* Read flags and prev/next address */
+        nodemgmt_check_address_validity_and_lock(next_child_node_addr_to_scan);
+        dbflash_read_data_from_flash(&dbflash_descriptor, nodemgmt_page_from_address(next_child_node_addr_to_scan), BASE_NODE_SIZE*nodemgmt_node_from_address(next_child_node_addr_to_scan), sizeof(child_read_buffer), &child_read_buffer);
+        mask |= nodemgmt_category_cache_get_mask_bit(categoryFromFlags(child_node_pt->flags));
+        next_child_node_addr_to_scan = child_node_pt->nextChildAddress;
+    }
+    
+    return mask;
+}
+#endif
+
+/*! \fn     nodemgmt_parent_node_has_logins_with_category(uint16_t parent_addr, uint16_t start_child_addr, uint16_t category_flags)
+ *  \brief  See if a parent node contains children that have the desired category, using the category cache when possible
+ *  \param  parent_addr         Parent address
+ *  \param  start_child_addr    Address of the parent first child
+ *  \param  category_flags      Desired category flags
+ *  \return TRUE if such children exist
+ */
+BOOL nodemgmt_parent_node_has_logins_with_category(uint16_t parent_addr, uint16_t start_child_addr, uint16_t category_flags)
+{
+    #ifdef NODEMGMT_CATEGORY_CACHE
+    /* Cache lookup */
+    if ((nodemgmt_category_cache_valid != FALSE) && (nodemgmt_category_cache_get_mask_bit(category_flags) != NODEMGMT_CAT_CACHE_NONSTD_CAT_BIT))
+    {
+        uint16_t index = nodemgmt_category_cache_get_index(parent_addr);
+        if ((index < nodemgmt_category_cache_nb_entries) && (nodemgmt_category_cache_addresses[index] == parent_addr))
+        {
+            return nodemgmt_category_mask_has_category(nodemgmt_category_cache_masks[index], category_flags);
+        }
+    }
+    #endif
+    
+    /* Fallback: browse children */
+    if (nodemgmt_check_for_logins_with_category_in_parent_node(start_child_addr, category_flags) != NODE_ADDR_NULL)
+    {
+        return TRUE;
+    }
+    else
+    {
+        return FALSE;
+    }
+}
+
+/*! \fn     nodemgmt_fletter_table_invalidate(void)
+ *  \brief  Invalidate the first letter jump table, it will be rebuilt on next use
+ */
+void nodemgmt_fletter_table_invalidate(void)
+{
+    #ifdef NODEMGMT_FLETTER_TABLE
+    nodemgmt_fletter_table_nb_entries = 0;
+    nodemgmt_fletter_table_valid = FALSE;
+    #endif
+}
+
+#ifdef NODEMGMT_FLETTER_TABLE
+
+/*! \fn     nodemgmt_fletter_table_append(cust_char_t fchar, uint16_t parent_addr)
+ *  \brief  Append a parent to the first letter jump table, parents being provided in list order
+ *  \param  fchar           First char of the parent service name
+ *  \param  parent_addr     Parent address
+ *  \note   Table is invalidated when full or when the provided parents aren't sorted
+ */
+static void nodemgmt_fletter_table_append(cust_char_t fchar, uint16_t parent_addr)
+{
+    /* Only maintain a valid table */
+    if (nodemgmt_fletter_table_valid == FALSE)
+    {
+        return;
+    }
+    
+    if (nodemgmt_fletter_table_nb_entries > 0)
+    {
+        cust_char_t last_fchar = nodemgmt_fletter_table[nodemgmt_fletter_table_nb_entries-1].fchar;
+        
+        /* Same first letter: only the first parent is stored */
+        if (last_fchar == fchar)
+        {
+            return;
+        }
+        
+        /* Unsorted list */
+        if (last_fchar > fchar)
+        {
+            nodemgmt_fletter_table_invalidate();
+            return;
+        }
+    }
+    
+    /* Table full */
+    if (nodemgmt_fletter_table_nb_entries >= ARRAY_SIZE(nodemgmt_fletter_table))
+    {
+        nodemgmt_fletter_table_invalidate();
+        return;
+    }
+    
+    nodemgmt_fletter_table[nodemgmt_fletter_table_nb_entries].fchar = fchar;
+    nodemgmt_fletter_table[nodemgmt_fletter_table_nb_entries].parent_address = parent_addr;
+    nodemgmt_fletter_table_nb_entries++;
+}
+
+/*! \fn     nodemgmt_fletter_table_reset(uint16_t credential_type_id)
+ *  \brief  Reset the first letter jump table before filling it for a given credential type and the current category
+ *  \param  credential_type_id  Credential type ID
+ */
+static void nodemgmt_fletter_table_reset(uint16_t credential_type_id)
+{
+    nodemgmt_fletter_table_category_flags = nodemgmt_current_handle.currentCategoryFlags;
+    nodemgmt_fletter_table_cred_type_id = credential_type_id;
+    nodemgmt_fletter_table_nb_entries = 0;
+    nodemgmt_fletter_table_valid = TRUE;
+}
+#endif
+
+/*! \fn     nodemgmt_get_fletter_table(uint16_t credential_type_id, nodemgmt_fletter_table_entry_t** table_pt, uint16_t* nb_entries)
+ *  \brief  Get the first letter jump table for a given credential type and the current category, building it if needed
+ *  \param  credential_type_id  Credential type ID
+ *  \param  table_pt            Where to store the table pointer
+ *  \param  nb_entries          Where to store the number of table entries
+ *  \return RETURN_OK if the table is available
+ */
+RET_TYPE nodemgmt_get_fletter_table(uint16_t credential_type_id, nodemgmt_fletter_table_entry_t** table_pt, uint16_t* nb_entries)
+{
+    #ifndef NODEMGMT_FLETTER_TABLE
+    return RETURN_NOK;
+    #else
+    uint16_t parent_read_buffer[5];
+    
+    /* Boundary checks */
+    if (credential_type_id >= MEMBER_ARRAY_SIZE(nodemgmtHandle_t, firstCredParentNodes))
+    {
+        return RETURN_NOK;
+    }
+    
+    /* Sanity check for this hack: only the members below can be accessed through parent_node_pt */
+    _Static_assert(0 == offsetof(parent_cred_node_t, flags), "Incorrect buffer for flags & addr & first char read");
+    _Static_assert(2 == offsetof(parent_cred_node_t, prevParentAddress), "Incorrect buffer for flags & addr & first char read");
+    _Static_assert(4 == offsetof(parent_cred_node_t, nextParentAddress), "Incorrect buffer for flags & addr & first char read");
+    _Static_assert(6 == offsetof(parent_cred_node_t, nextChildAddress), "Incorrect buffer for flags & addr & first char read");
+    _Static_assert(8 == offsetof(parent_cred_node_t, service), "Incorrect buffer for flags & addr & first char read");
+    _Static_assert(sizeof(parent_read_buffer) == MEMBER_SIZE(parent_cred_node_t, flags) + MEMBER_SIZE(parent_cred_node_t, prevParentAddress) + MEMBER_SIZE(parent_cred_node_t, nextParentAddress) + MEMBER_SIZE(parent_cred_node_t, nextChildAddress) + sizeof(cust_char_t), "Incorrect buffer for flags & addr & first char read");
+    
+    /* Hack to read flags & prev / next address & first char */
+    parent_cred_node_t* parent_node_pt = (parent_cred_node_t*)parent_read_buffer;
+    
+    /* Table built for another credential type or category, or invalidated: browse the parents */
+    if ((nodemgmt_fletter_table_valid == FALSE) || (nodemgmt_fletter_table_cred_type_id != credential_type_id) || (nodemgmt_fletter_table_category_flags != nodemgmt_current_handle.currentCategoryFlags))
+    {
+        uint16_t next_parent_node_addr_to_scan = nodemgmt_current_handle.firstCredParentNodes[credential_type_id];
+        nodemgmt_fletter_table_reset(credential_type_id);
+        
+        while ((next_parent_node_addr_to_scan != NODE_ADDR_NULL) && (nodemgmt_fletter_table_valid != FALSE))
+        {
+            /* Read flags, prev/next address, first char */
+            nodemgmt_check_address_validity_and_lock(next_parent_node_addr_to_scan);
+            dbflash_read_data_from_flash(&dbflash_descriptor, nodemgmt_page_from_address(next_parent_node_addr_to_scan), BASE_NODE_SIZE*nodemgmt_node_from_address(next_parent_node_addr_to_scan), sizeof(parent_read_buffer), &parent_read_buffer);
+            
+            /* Check for logins with desired category */
+            if (nodemgmt_parent_node_has_logins_with_category(next_parent_node_addr_to_scan, parent_node_pt->nextChildAddress, nodemgmt_current_handle.currentCategoryFlags) != FALSE)
+            {
+                nodemgmt_fletter_table_append(parent_node_pt->service[0], next_parent_node_addr_to_scan);
+            }
+            
+            next_parent_node_addr_to_scan = parent_node_pt->nextParentAddress;
+        }
+    }
+    
+    *table_pt = nodemgmt_fletter_table;
+    *nb_entries = nodemgmt_fletter_table_nb_entries;
+    return (nodemgmt_fletter_table_valid != FALSE)? RETURN_OK : RETURN_NOK;
+    #endif
+}
+
 /*! \fn     nodemgmt_get_prev_parent_node_for_cur_category(uint16_t search_start_parent_addr, uint16_t credential_type_id)
  *  \brief  Gets the prev parent node for the current category
  *  \param  search_start_parent_addr    The parent address from which to start looking.
@@ -1171,7 +1656,7 @@ uint16_t nodemgmt_get_prev_parent_node_for_cur_category(uint16_t search_start_pa
         /* Check if the last node could work */
         nodemgmt_check_address_validity_and_lock(search_start_parent_addr);
         dbflash_read_data_from_flash(&dbflash_descriptor, nodemgmt_page_from_address(search_start_parent_addr), BASE_NODE_SIZE*nodemgmt_node_from_address(search_start_parent_addr), sizeof(parent_read_buffer), &parent_read_buffer);
-        if (nodemgmt_check_for_logins_with_category_in_parent_node(parent_node_pt->nextChildAddress, nodemgmt_current_handle.currentCategoryFlags) != NODE_ADDR_NULL)
+        if (nodemgmt_parent_node_has_logins_with_category(search_start_parent_addr, parent_node_pt->nextChildAddress, nodemgmt_current_handle.currentCategoryFlags) != FALSE)
         {
                 return search_start_parent_addr;
         }
@@ -1190,7 +1675,7 @@ uint16_t nodemgmt_get_prev_parent_node_for_cur_category(uint16_t search_start_pa
         dbflash_read_data_from_flash(&dbflash_descriptor, nodemgmt_page_from_address(prev_parent_node_addr_to_scan), BASE_NODE_SIZE*nodemgmt_node_from_address(prev_parent_node_addr_to_scan), sizeof(parent_read_buffer), &parent_read_buffer);
 
         /* Check for logins with desired category */
-        if (nodemgmt_check_for_logins_with_category_in_parent_node(parent_node_pt->nextChildAddress, nodemgmt_current_handle.currentCategoryFlags) != NODE_ADDR_NULL)
+        if (nodemgmt_parent_node_has_logins_with_category(prev_parent_node_addr_to_scan, parent_node_pt->nextChildAddress, nodemgmt_current_handle.currentCategoryFlags) != FALSE)
         {
             return prev_parent_node_addr_to_scan;
         }
@@ -1249,7 +1734,7 @@ uint16_t nodemgmt_get_next_parent_node_for_cur_category(uint16_t search_start_pa
         next_parent_node_addr_to_scan = parent_node_pt->nextParentAddress;
         
         /* Check that the provided parent node actually belongs to the current category.... */
-        if (nodemgmt_check_for_logins_with_category_in_parent_node(parent_node_pt->nextChildAddress, nodemgmt_current_handle.currentCategoryFlags) == NODE_ADDR_NULL)
+        if (nodemgmt_parent_node_has_logins_with_category(search_start_parent_addr, parent_node_pt->nextChildAddress, nodemgmt_current_handle.currentCategoryFlags) == FALSE)
         {
             return NODE_ADDR_NULL;
         }
@@ -1269,7 +1754,7 @@ uint16_t nodemgmt_get_next_parent_node_for_cur_category(uint16_t search_start_pa
         dbflash_read_data_from_flash(&dbflash_descriptor, nodemgmt_page_from_address(next_parent_node_addr_to_scan), BASE_NODE_SIZE*nodemgmt_node_from_address(next_parent_node_addr_to_scan), sizeof(parent_read_buffer), &parent_read_buffer);
 
         /* Check for logins with desired category */
-        if (nodemgmt_check_for_logins_with_category_in_parent_node(parent_node_pt->nextChildAddress, nodemgmt_current_handle.currentCategoryFlags) != NODE_ADDR_NULL)
+        if (nodemgmt_parent_node_has_logins_with_category(next_parent_node_addr_to_scan, parent_node_pt->nextChildAddress, nodemgmt_current_handle.currentCategoryFlags) != FALSE)
         {
             /* Check for single credential */
             if (next_parent_node_addr_to_scan == search_start_parent_addr)
@@ -1331,9 +1816,187 @@ uint16_t nodemgmt_get_starting_parent_addr(uint16_t credential_type_id)
     return temp_address;
 }
 
+/*! \fn     nodemgmt_service_index_invalidate(void)
+ *  \brief  Invalidate the service name index, lookups will then fall back to browsing the parent lists
+ */
+void nodemgmt_service_index_invalidate(void)
+{
+    #ifdef NODEMGMT_SERVICE_INDEX
+    nodemgmt_service_index_nb_entries = 0;
+    nodemgmt_service_index_valid = FALSE;
+    #endif
+}
+
+#ifdef NODEMGMT_SERVICE_INDEX
+
+/*! \fn     nodemgmt_service_index_get_key(cust_char_t* name, uint16_t list_id)
+ *  \brief  Compute the service name index key for a given service name
+ *  \param  name        Service name
+ *  \param  list_id     Parent list ID: credential type ID, or data type ID + NODEMGMT_SVC_INDEX_DATA_LIST_OFFSET
+ *  \return The key
+ *  \note   Hash only covers the characters left untouched by the data_clean of our parent node read functions
+ */
+static uint16_t nodemgmt_service_index_get_key(cust_char_t* name, uint16_t list_id)
+{
+    _Static_assert((NODEMGMT_SVC_INDEX_DATA_LIST_OFFSET + MEMBER_ARRAY_SIZE(nodemgmtHandle_t, firstDataParentNodes)) <= (1 << (16 - NODEMGMT_SVC_INDEX_HASH_BITS)), "Not enough bits for parent list ID in index key");
+    _Static_assert(NODEMGMT_SVC_INDEX_DATA_LIST_OFFSET >= MEMBER_ARRAY_SIZE(nodemgmtHandle_t, firstCredParentNodes), "Overlapping cred & data list IDs");
+    uint32_t hash = 0;
+    
+    for (uint16_t i = 0; (i < MEMBER_ARRAY_SIZE(parent_cred_node_t, service) - 1) && (name[i] != 0); i++)
+    {
+        hash = hash*31 + name[i];
+    }
+    
+    /* Fold upper bits into our hash bits */
+    hash ^= (hash >> 16);
+    hash ^= (hash >> NODEMGMT_SVC_INDEX_HASH_BITS);
+    return (uint16_t)((list_id << NODEMGMT_SVC_INDEX_HASH_BITS) | (hash & NODEMGMT_SVC_INDEX_HASH_MASK));
+}
+
+/*! \fn     nodemgmt_service_index_get_first_index_for_key(uint16_t key)
+ *  \brief  Binary search for the first index entry whose key is greater or equal to a given key
+ *  \param  key         The key
+ *  \return Index in the service name index
+ */
+static uint16_t nodemgmt_service_index_get_first_index_for_key(uint16_t key)
+{
+    uint16_t high = nodemgmt_service_index_nb_entries;
+    uint16_t low = 0;
+    
+    while (low < high)
+    {
+        uint16_t middle = (low + high) >> 1;
+        
+        if (nodemgmt_service_index[middle].key < key)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    
+    return low;
+}
+
+/*! \fn     nodemgmt_service_index_insert(cust_char_t* name, uint16_t list_id, uint16_t parent_address)
+ *  \brief  Add a parent node to the service name index
+ *  \param  name            Service name
+ *  \param  list_id         Parent list ID (see nodemgmt_service_index_get_key)
+ *  \param  parent_address  Parent node address
+ *  \note   Index is invalidated if full
+ */
+static void nodemgmt_service_index_insert(cust_char_t* name, uint16_t list_id, uint16_t parent_address)
+{
+    /* No point in updating an invalid index */
+    if (nodemgmt_service_index_valid == FALSE)
+    {
+        return;
+    }
+    
+    /* Index full? */
+    if (nodemgmt_service_index_nb_entries >= ARRAY_SIZE(nodemgmt_service_index))
+    {
+        nodemgmt_service_index_invalidate();
+        return;
+    }
+    
+    /* Find insertion point, make room and store */
+    uint16_t key = nodemgmt_service_index_get_key(name, list_id);
+    uint16_t insert_index = nodemgmt_service_index_get_first_index_for_key(key);
+    memmove(&nodemgmt_service_index[insert_index+1], &nodemgmt_service_index[insert_index], (nodemgmt_service_index_nb_entries - insert_index)*sizeof(nodemgmt_service_index[0]));
+    nodemgmt_service_index[insert_index].parent_address = parent_address;
+    nodemgmt_service_index[insert_index].key = key;
+    nodemgmt_service_index_nb_entries++;
+}
+
+/*! \fn     nodemgmt_service_index_remove(uint16_t parent_address)
+ *  \brief  Remove a parent node from the service name index
+ *  \param  parent_address  Parent node address
+ */
+static void nodemgmt_service_index_remove(uint16_t parent_address)
+{
+    for (uint16_t i = 0; i < nodemgmt_service_index_nb_entries; i++)
+    {
+        if (nodemgmt_service_index[i].parent_address == parent_address)
+        {
+            memmove(&nodemgmt_service_index[i], &nodemgmt_service_index[i+1], (nodemgmt_service_index_nb_entries - i - 1)*sizeof(nodemgmt_service_index[0]));
+            nodemgmt_service_index_nb_entries--;
+            return;
+        }
+    }
+}
+
+#endif
+
+/*! \fn     nodemgmt_service_index_lookup(cust_char_t* name, BOOL data_parent, uint16_t type_id, uint16_t* parent_address)
+ *  \brief  Use the service name index to find a parent node exactly matching a given service name
+ *  \param  name            Service name
+ *  \param  data_parent     TRUE to look for a data parent
+ *  \param  type_id         Credential / Data type ID
+ *  \param  parent_address  Where to store the parent address, NODE_ADDR_NULL if not found
+ *  \return RETURN_OK if the index could be used, RETURN_NOK if the caller should browse the parent list instead
+ *  \note   Uses temp_parent_node from the handle
+ */
+RET_TYPE nodemgmt_service_index_lookup(cust_char_t* name, BOOL data_parent, uint16_t type_id, uint16_t* parent_address)
+{
+    #ifndef NODEMGMT_SERVICE_INDEX
+    return RETURN_NOK;
+    #else
+    uint16_t list_id = type_id;
+    
+    /* Boundary checks */
+    if (data_parent == FALSE)
+    {
+        if (type_id >= MEMBER_ARRAY_SIZE(nodemgmtHandle_t, firstCredParentNodes))
+        {
+            return RETURN_NOK;
+        }
+    }
+    else
+    {
+        if (type_id >= MEMBER_ARRAY_SIZE(nodemgmtHandle_t, firstDataParentNodes))
+        {
+            return RETURN_NOK;
+        }
+        list_id += NODEMGMT_SVC_INDEX_DATA_LIST_OFFSET;
+    }
+    
+    /* Index usable? */
+    if (nodemgmt_service_index_valid == FALSE)
+    {
+        return RETURN_NOK;
+    }
+    
+    /* Go through the entries having the same key (hash collisions) */
+    uint16_t key = nodemgmt_service_index_get_key(name, list_id);
+    *parent_address = NODE_ADDR_NULL;
+    for (uint16_t i = nodemgmt_service_index_get_first_index_for_key(key); (i < nodemgmt_service_index_nb_entries) && (nodemgmt_service_index[i].key == key); i++)
+    {
+        /* Read candidate: invalid node means the index is out of sync with the database */
+        if (nodemgmt_read_parent_node_permissive(nodemgmt_service_index[i].parent_address, &nodemgmt_current_handle.temp_parent_node, TRUE) != RETURN_OK)
+        {
+            nodemgmt_service_index_invalidate();
+            return RETURN_NOK;
+        }
+        
+        /* Full service name compare */
+        if (utils_custchar_strncmp(name, nodemgmt_current_handle.temp_parent_node.cred_parent.service, ARRAY_SIZE(nodemgmt_current_handle.temp_parent_node.cred_parent.service)) == 0)
+        {
+            *parent_address = nodemgmt_service_index[i].parent_address;
+            return RETURN_OK;
+        }
+    }
+    
+    return RETURN_OK;
+    #endif
+}
+
 /*! \fn     nodemgmt_get_last_parent_addr(uint16_t credential_type_id)
  *  \brief  Search the users last parent node
  *  \return The address
+ *  \note   Also populates the service name index, category cache and first letter jump table, see nodemgmt_scan_for_last_parent_nodes
  */
 uint16_t nodemgmt_get_last_parent_addr(BOOL data_parent, uint16_t credential_type_id)
 {
@@ -1367,6 +2030,9 @@ uint16_t nodemgmt_get_last_parent_addr(BOOL data_parent, uint16_t credential_typ
          /* Check for valid address */
          if (nodemgmt_check_address_validity(next_parent_node_addr_to_scan) != RETURN_OK)
          {
+             nodemgmt_service_index_invalidate();
+             nodemgmt_category_cache_invalidate();
+             nodemgmt_fletter_table_invalidate();
              return NODE_ADDR_NULL;
          }
          
@@ -1376,16 +2042,43 @@ uint16_t nodemgmt_get_last_parent_addr(BOOL data_parent, uint16_t credential_typ
          /* Check ownership & validity */
          if (nodemgmt_check_user_perm_from_flags(nodemgmt_current_handle.temp_parent_node.cred_parent.flags) != RETURN_OK)
          {
+             nodemgmt_service_index_invalidate();
+             nodemgmt_category_cache_invalidate();
+             nodemgmt_fletter_table_invalidate();
              return NODE_ADDR_NULL;
          }
          
          /* Check for database loop */
          if (utils_custchar_strncmp(last_service_encountered, nodemgmt_current_handle.temp_parent_node.cred_parent.service, ARRAY_SIZE(nodemgmt_current_handle.temp_parent_node.cred_parent.service)) >= 0)
          {
+             nodemgmt_service_index_invalidate();
+             nodemgmt_category_cache_invalidate();
+             nodemgmt_fletter_table_invalidate();
              return NODE_ADDR_NULL;
          }
          memcpy(last_service_encountered, nodemgmt_current_handle.temp_parent_node.cred_parent.service, sizeof(nodemgmt_current_handle.temp_parent_node.cred_parent.service));
          
+         /* As we're browsing through all parents, populate the service name index */
+         #ifdef NODEMGMT_SERVICE_INDEX
+         nodemgmt_service_index_insert(nodemgmt_current_handle.temp_parent_node.cred_parent.service, (data_parent == FALSE)?credential_type_id:credential_type_id+NODEMGMT_SVC_INDEX_DATA_LIST_OFFSET, next_parent_node_addr_to_scan);
+         #endif
+         
+         /* Same for the credential parents category cache */
+         if (data_parent == FALSE)
+         {
+             #ifdef NODEMGMT_CATEGORY_CACHE
+             nodemgmt_category_cache_add_to_mask(next_parent_node_addr_to_scan, nodemgmt_category_cache_compute_mask(nodemgmt_current_handle.temp_parent_node.cred_parent.nextChildAddress));
+             #endif
+             
+             /* And the first letter jump table, category check using the cache entry we just added */
+             #ifdef NODEMGMT_FLETTER_TABLE
+             if ((credential_type_id == nodemgmt_fletter_table_cred_type_id) && (nodemgmt_fletter_table_valid != FALSE) && (nodemgmt_parent_node_has_logins_with_category(next_parent_node_addr_to_scan, nodemgmt_current_handle.temp_parent_node.cred_parent.nextChildAddress, nodemgmt_fletter_table_category_flags) != FALSE))
+             {
+                 nodemgmt_fletter_table_append(nodemgmt_current_handle.temp_parent_node.cred_parent.service[0], next_parent_node_addr_to_scan);
+             }
+             #endif
+         }
+         
          /* Check for end condition */
          if (nodemgmt_current_handle.temp_parent_node.cred_parent.nextParentAddress == NODE_ADDR_NULL)
          {
@@ -1477,6 +2170,7 @@ void nodemgmt_set_cred_start_address(uint16_t parentAddress, uint16_t credential
     // Update handle
     nodemgmt_current_handle.firstCredParentNodes[credential_type_id] = parentAddress;
     
+    nodemgmt_journal_profile_change();
     // Write parent address in the user profile page
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserProfile, nodemgmt_current_handle.offsetUserProfile + (size_t)offsetof(nodemgmt_userprofile_t, main_data.cred_start_addresses[credential_type_id]), sizeof(parentAddress), &parentAddress);
 }
@@ -1497,6 +2191,7 @@ void nodemgmt_set_data_start_address(uint16_t dataParentAddress, uint16_t typeId
     // update handle
     nodemgmt_current_handle.firstDataParentNodes[typeId] = dataParentAddress;
     
+    nodemgmt_journal_profile_change();
     // Write data parent address in the user profile page
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserProfile, nodemgmt_current_handle.offsetUserProfile + (size_t)offsetof(nodemgmt_userprofile_t, main_data.data_start_addresses[typeId]), sizeof(dataParentAddress), &dataParentAddress);
 }
@@ -1511,6 +2206,7 @@ void nodemgmt_set_start_addresses(uint16_t* addresses_array)
     memcpy(nodemgmt_current_handle.firstCredParentNodes, addresses_array, MEMBER_SIZE(nodemgmt_profile_main_data_t, cred_start_addresses));
     memcpy(nodemgmt_current_handle.firstDataParentNodes, &(addresses_array[MEMBER_ARRAY_SIZE(nodemgmt_profile_main_data_t, cred_start_addresses)]), MEMBER_SIZE(nodemgmt_profile_main_data_t, data_start_addresses));
 
+    nodemgmt_journal_profile_change();
     // Write addresses in the user profile page. Possible as the credential start address & data start addresses are contiguous in memory
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserProfile, nodemgmt_current_handle.offsetUserProfile + (size_t)offsetof(nodemgmt_userprofile_t, main_data.cred_start_addresses), MEMBER_SIZE(nodemgmt_profile_main_data_t, cred_start_addresses) + MEMBER_SIZE(nodemgmt_profile_main_data_t, data_start_addresses), addresses_array);
 }
@@ -1556,6 +2252,7 @@ void nodemgmt_set_favorite(uint16_t categoryId, uint16_t favId, uint16_t parentA
         main_reboot();
     }
 
+    nodemgmt_journal_profile_change();
     // Write to flash    
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserProfile, nodemgmt_current_handle.offsetUserProfile + (size_t)offsetof(nodemgmt_userprofile_t, category_favorites[categoryId].favorite[favId]), sizeof(favorite), (void*)&favorite);
 }
@@ -1722,6 +2419,7 @@ void nodemgmt_read_profile_ctr(void* buf)
  */
 void nodemgmt_set_profile_ctr(void* buf)
 {
+    nodemgmt_journal_profile_change();
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserProfile, nodemgmt_current_handle.offsetUserProfile + (size_t)offsetof(nodemgmt_userprofile_t, main_data.current_ctr), MEMBER_SIZE(nodemgmt_userprofile_t, main_data.current_ctr), buf);
 }
 
@@ -1744,6 +2442,7 @@ void nodemgmt_get_category_strings(nodemgmt_user_category_strings_t* strings_pt)
  */
 void nodemgmt_set_category_strings(nodemgmt_user_category_strings_t* strings_pt)
 {
+    nodemgmt_journal_profile_change();
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserCategoryStrings, nodemgmt_current_handle.offsetUserCategoryStrings, sizeof(nodemgmt_user_category_strings_t), strings_pt);
 }
 
@@ -1776,6 +2475,7 @@ void nodemgmt_set_category_string(uint16_t category_id, cust_char_t* string_pt)
         return;
     }
     
+    nodemgmt_journal_profile_change();
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserCategoryStrings, nodemgmt_current_handle.offsetUserCategoryStrings + (size_t)offsetof(nodemgmt_user_category_strings_t, category_strings[category_id]), MEMBER_SIZE(nodemgmt_user_category_strings_t, category_strings[0]), string_pt);
 }
 
@@ -1788,6 +2488,7 @@ void nodemgmt_set_category_string(uint16_t category_id, cust_char_t* string_pt)
 *   \param  startPage       Page where to start the scanning
 *   \param  startNode       Scan start node address inside the start page
 *   \return the number of nodes found
+*   \note   With NODEMGMT_NODE_USAGE_BITMAP, slot groups known to be fully used are skipped without reading their flags
 */
 uint16_t nodemgmt_find_free_nodes(uint16_t nbParentNodes, uint16_t* parentNodeArray, uint16_t nbChildtNodes, uint16_t* childNodeArray, uint16_t startPage, uint16_t startNode)
 {
@@ -1795,8 +2496,10 @@ uint16_t nodemgmt_find_free_nodes(uint16_t nbParentNodes, uint16_t* parentNodeAr
     uint16_t nbParentNodesFound = 0;
     uint16_t nbChildNodesFound = 0;
     uint16_t nodeFlags;
-    uint16_t pageItr;
-    uint16_t nodeItr;
+    uint16_t slotItr;
+    #ifdef NODEMGMT_NODE_USAGE_BITMAP
+    BOOL group_fully_used = FALSE;
+    #endif
     
 #ifdef EMULATOR_BUILD
     if(emu_get_failure_flags() & EMU_FAIL_DBFLASH_FULL)
@@ -1808,58 +2511,85 @@ uint16_t nodemgmt_find_free_nodes(uint16_t nbParentNodes, uint16_t* parentNodeAr
     {
         startPage = PAGE_PER_SECTOR;
     }
-
-    // for each page
-    for(pageItr = startPage; pageItr < PAGE_COUNT; pageItr++)
+    
+    // for each node slot, starting at the provided address
+    for(slotItr = (startPage - PAGE_PER_SECTOR)*NODEMGMT_NB_BASE_NODES_PER_PAGE + startNode; slotItr < NODEMGMT_NB_NODE_SLOTS; slotItr++)
     {
-        // for each possible parent node in the page (changes per flash chip)
-        for(nodeItr = startNode; nodeItr < BYTES_PER_PAGE/BASE_NODE_SIZE; nodeItr++)
+        uint16_t slotAddress = constructAddress(PAGE_PER_SECTOR + slotItr/NODEMGMT_NB_BASE_NODES_PER_PAGE, slotItr%NODEMGMT_NB_BASE_NODES_PER_PAGE);
+        
+        #ifdef NODEMGMT_NODE_USAGE_BITMAP
+        // First slot of a group
+        if ((slotItr % NODEMGMT_NODE_USAGE_GROUP_SLOTS) == 0)
+        {
+            uint16_t group = slotItr / NODEMGMT_NODE_USAGE_GROUP_SLOTS;
+            
+            // All slots used: skip them at once
+            if ((nodemgmt_node_usage_bitmap[group >> 5] & (1UL << (group & 0x1F))) != 0)
+            {
+                prevFreeAddressFound = NODE_ADDR_NULL;
+                slotItr += NODEMGMT_NODE_USAGE_GROUP_SLOTS - 1;
+                continue;
+            }
+            group_fully_used = TRUE;
+        }
+        #endif
+        
+        // read node flags (2 bytes - fixed size)
+        dbflash_read_data_from_flash(&dbflash_descriptor, nodemgmt_page_from_address(slotAddress), BASE_NODE_SIZE*nodemgmt_node_from_address(slotAddress), sizeof(nodeFlags), &nodeFlags);
+        
+        // If this slot is OK
+        if (validBitFromFlags(nodeFlags) == NODEMGMT_VBIT_INVALID)
         {
-            // read node flags (2 bytes - fixed size)
-            dbflash_read_data_from_flash(&dbflash_descriptor, pageItr, BASE_NODE_SIZE*nodeItr, sizeof(nodeFlags), &nodeFlags);
+            #ifdef NODEMGMT_NODE_USAGE_BITMAP
+            group_fully_used = FALSE;
+            #endif
             
-            // If this slot is OK
-            if(validBitFromFlags(nodeFlags) == NODEMGMT_VBIT_INVALID)
+            // fill parent nodes first (only one block)
+            if (nbParentNodesFound != nbParentNodes)
             {
-                // fill parent nodes first (only one block)
-                if (nbParentNodesFound != nbParentNodes)
+                parentNodeArray[nbParentNodesFound++] = slotAddress;
+                
+                // check for end
+                if ((nbChildtNodes == 0) && (nbParentNodesFound == nbParentNodes))
                 {
-                    parentNodeArray[nbParentNodesFound++] = constructAddress(pageItr, nodeItr);
-                    
-                    // check for end
-                    if ((nbChildtNodes == 0) && (nbParentNodesFound == nbParentNodes))
-                    {
-                        return nbChildNodesFound+nbParentNodesFound;
-                    }
+                    return nbChildNodesFound+nbParentNodesFound;
+                }
+            } 
+            else
+            {
+                if (prevFreeAddressFound == NODE_ADDR_NULL)
+                {
+                    // Store address if the next free block found is available
+                    prevFreeAddressFound = slotAddress;
                 } 
                 else
                 {
-                    if (prevFreeAddressFound == NODE_ADDR_NULL)
-                    {
-                        // Store address if the next free block found is available
-                        prevFreeAddressFound = constructAddress(pageItr, nodeItr);
-                    } 
-                    else
+                    childNodeArray[nbChildNodesFound++] = prevFreeAddressFound;
+                    prevFreeAddressFound = NODE_ADDR_NULL;
+                    
+                    // check for end
+                    if (nbChildNodesFound == nbChildtNodes)
                     {
-                        childNodeArray[nbChildNodesFound++] = prevFreeAddressFound;
-                        prevFreeAddressFound = NODE_ADDR_NULL;
-                        
-                        // check for end
-                        if (nbChildNodesFound == nbChildtNodes)
-                        {
-                            return nbChildNodesFound+nbParentNodesFound;
-                        }
+                        return nbChildNodesFound+nbParentNodesFound;
                     }
                 }
             }
-            else
+        }
+        else
+        {
+            // block found isn't available, reset flag
+            prevFreeAddressFound = NODE_ADDR_NULL;
+            
+            #ifdef NODEMGMT_NODE_USAGE_BITMAP
+            // Last slot of a group we read from its start: remember if all its slots are used
+            if ((group_fully_used != FALSE) && ((slotItr % NODEMGMT_NODE_USAGE_GROUP_SLOTS) == (NODEMGMT_NODE_USAGE_GROUP_SLOTS - 1)))
             {
-                // block found isn't available, reset flag
-                prevFreeAddressFound = NODE_ADDR_NULL;
+                uint16_t group = slotItr / NODEMGMT_NODE_USAGE_GROUP_SLOTS;
+                nodemgmt_node_usage_bitmap[group >> 5] |= (1UL << (group & 0x1F));
             }
+            #endif
         }
-        startNode = 0;
-    }    
+    }
     
     return nbChildNodesFound+nbParentNodesFound;
 }
@@ -2005,10 +2735,23 @@ uint16_t nodemgmt_get_sec_preference_for_user_id(uint16_t userIdNum)
 }
 
 /*! \fn     nodemgmt_scan_for_last_parent_nodes(void)
- *  \brief  Scan the database and store the last parent nodes for each parent type
+ *  \brief  Scan the database and store the last parent nodes for each parent type, rebuild the service name index, category cache & first letter jump table
  */
 void nodemgmt_scan_for_last_parent_nodes(void)
 {
+    // Service name index and category cache are rebuilt as we go through all the parents
+    #ifdef NODEMGMT_SERVICE_INDEX
+    nodemgmt_service_index_nb_entries = 0;
+    nodemgmt_service_index_valid = TRUE;
+    #endif
+    #ifdef NODEMGMT_CATEGORY_CACHE
+    nodemgmt_category_cache_nb_entries = 0;
+    nodemgmt_category_cache_valid = TRUE;
+    #endif
+    #ifdef NODEMGMT_FLETTER_TABLE
+    nodemgmt_fletter_table_reset(NODEMGMT_STANDARD_CRED_TYPE_ID);
+    #endif
+    
     // Get last cred parents
     for (uint16_t i = 0; i < MEMBER_ARRAY_SIZE(nodemgmtHandle_t, lastCredParentNodes); i++)
     {
@@ -2106,7 +2849,11 @@ void nodemgmt_init_context(uint16_t userIdNum, uint16_t* userSecFlags, uint16_t*
     // Scan for last parent nodes
     nodemgmt_scan_for_last_parent_nodes();
     
-    // scan for next free parent and child nodes from the start of the memory
+    // Start journaling node changes from the current change numbers
+    nodemgmt_restart_change_journal();
+    
+    // Forget node usage learnt for the previous user session, then scan for next free parent and child nodes from the start of the memory
+    nodemgmt_clear_node_usage_bitmap();
     nodemgmt_scan_node_usage();
     
     // Check if the number of known languages/layouts is different from the one we currently have, and reset the language if so
@@ -2134,6 +2881,12 @@ void nodemgmt_init_context(uint16_t userIdNum, uint16_t* userSecFlags, uint16_t*
  */
 void nodemgmt_user_db_changed_actions(BOOL dataChanged)
 {
+    // Credential parents may have been added
+    if (dataChanged == FALSE)
+    {
+        nodemgmt_fletter_table_invalidate();
+    }
+    
     // Cred db change number
     if ((nodemgmt_current_handle.dbChanged == FALSE) && (dataChanged == FALSE))
     {
@@ -2209,6 +2962,11 @@ void nodemgmt_delete_data_parent_and_its_children(uint16_t parent_address, uint1
     
     // Delete parent data block
     dbflash_write_data_pattern_to_flash(&dbflash_descriptor, nodemgmt_page_from_address(parent_address), BASE_NODE_SIZE * nodemgmt_node_from_address(parent_address), BASE_NODE_SIZE, 0xFF);
+    nodemgmt_update_node_usage_bitmap(parent_address, UINT16_MAX);
+    nodemgmt_journal_node_change(parent_address);
+    #ifdef NODEMGMT_SERVICE_INDEX
+    nodemgmt_service_index_remove(parent_address);
+    #endif
     
     // Delete the children (evil laugh)
     nodemgmt_delete_children_list(first_child_address, TRUE);
@@ -2251,6 +3009,9 @@ void nodemgmt_delete_children_list(uint16_t first_children_addr, BOOL data_child
         // Delete child data block
         dbflash_write_data_pattern_to_flash(&dbflash_descriptor, nodemgmt_page_from_address(next_child_addr), BASE_NODE_SIZE * nodemgmt_node_from_address(next_child_addr), BASE_NODE_SIZE, 0xFF);
         dbflash_write_data_pattern_to_flash(&dbflash_descriptor, nodemgmt_page_from_address(nodemgmt_get_incremented_address(next_child_addr)), BASE_NODE_SIZE * nodemgmt_node_from_address(nodemgmt_get_incremented_address(next_child_addr)), BASE_NODE_SIZE, 0xFF);
+        nodemgmt_update_node_usage_bitmap(nodemgmt_get_incremented_address(next_child_addr), UINT16_MAX);
+        nodemgmt_update_node_usage_bitmap(next_child_addr, UINT16_MAX);
+        nodemgmt_journal_node_change(next_child_addr);
         
         // Set correct next address
         next_child_addr = temp_address;
@@ -2278,6 +3039,9 @@ void nodemgmt_delete_current_user_from_flash(void)
         
     // Delete user profile memory
     nodemgmt_format_user_profile(nodemgmt_current_handle.currentUserId, 0, 0, 0, 0);
+    nodemgmt_service_index_invalidate();
+    nodemgmt_category_cache_invalidate();
+    nodemgmt_fletter_table_invalidate();
     
     // Then browse through all the credentials to delete them
     for (uint16_t i = 0; i < MEMBER_ARRAY_SIZE(nodemgmtHandle_t, firstCredParentNodes) + MEMBER_ARRAY_SIZE(nodemgmtHandle_t, firstDataParentNodes); i++)
@@ -2307,6 +3071,8 @@ void nodemgmt_delete_current_user_from_flash(void)
             
             // Delete parent data block
             dbflash_write_data_pattern_to_flash(&dbflash_descriptor, nodemgmt_page_from_address(next_parent_addr), BASE_NODE_SIZE * nodemgmt_node_from_address(next_parent_addr), BASE_NODE_SIZE, 0xFF);
+            nodemgmt_update_node_usage_bitmap(next_parent_addr, UINT16_MAX);
+            nodemgmt_journal_node_change(next_parent_addr);
             
             // Set correct next address
             next_parent_addr = temp_address;
@@ -2762,6 +3528,22 @@ RET_TYPE nodemgmt_create_parent_node(parent_node_t* p, service_type_te type, uin
         }
     }
     
+    // If the return is ok, add the new parent to our service name index
+    if (temprettype == RETURN_OK)
+    {
+        #ifdef NODEMGMT_SERVICE_INDEX
+        nodemgmt_service_index_insert(p->cred_parent.service, (type == SERVICE_CRED_TYPE)?typeId:typeId+NODEMGMT_SVC_INDEX_DATA_LIST_OFFSET, *storedAddress);
+        #endif
+        
+        // New credential parents don't have children yet
+        #ifdef NODEMGMT_CATEGORY_CACHE
+        if (type == SERVICE_CRED_TYPE)
+        {
+            nodemgmt_category_cache_add_to_mask(*storedAddress, 0);
+        }
+        #endif
+    }
+    
     // If the return is ok & we changed the last node address
     if ((temprettype == RETURN_OK) && (last_parent_addr != potential_new_lparent) && (potential_new_lparent != NODE_ADDR_NULL))
     {
@@ -2810,5 +3592,13 @@ RET_TYPE nodemgmt_create_child_node(uint16_t pAddr, child_cred_node_t* c, uint16
         nodemgmt_write_parent_node_data_block_to_flash(pAddr, &nodemgmt_current_handle.temp_parent_node);
     }
     
+    // New child is stored with the current category
+    #ifdef NODEMGMT_CATEGORY_CACHE
+    if (temprettype == RETURN_OK)
+    {
+        nodemgmt_category_cache_add_to_mask(pAddr, nodemgmt_category_cache_get_mask_bit(nodemgmt_current_handle.currentCategoryFlags));
+    }
+    #endif
+    
     return temprettype;
 }  
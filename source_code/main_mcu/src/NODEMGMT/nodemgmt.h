@@ -71,6 +71,17 @@ typedef enum    {NODE_TYPE_PARENT = 0, NODE_TYPE_CHILD = 1, NODE_TYPE_PARENT_DAT
 #define NODEMGMT_CAT_MASK_FINAL                     0x000F
 #define NODEMGMT_CAT_MASK                           0x000F
 #define NODEMGMT_CAT_BITSHIFT                       0
+#define NODEMGMT_NB_BASE_NODES_PER_PAGE             (BYTES_PER_PAGE/BASE_NODE_SIZE)
+#define NODEMGMT_NB_NODE_SLOTS                      ((PAGE_COUNT-PAGE_PER_SECTOR)*NODEMGMT_NB_BASE_NODES_PER_PAGE)
+#define NODEMGMT_NODE_USAGE_GROUP_SLOTS             8
+#define NODEMGMT_SVC_INDEX_MAX_ENTRIES              256
+#define NODEMGMT_SVC_INDEX_HASH_BITS                11
+#define NODEMGMT_SVC_INDEX_HASH_MASK                ((1 << NODEMGMT_SVC_INDEX_HASH_BITS) - 1)
+#define NODEMGMT_SVC_INDEX_DATA_LIST_OFFSET         10
+#define NODEMGMT_CAT_CACHE_MAX_ENTRIES              256
+#define NODEMGMT_CAT_CACHE_NONSTD_CAT_BIT           0x80
+#define NODEMGMT_FLETTER_TABLE_MAX_ENTRIES          64
+#define NODEMGMT_JOURNAL_MAX_ENTRIES                64
 
 /* User security settings flags */
 #define USER_SEC_FLG_LOGIN_CONF             0x01
@@ -319,6 +330,20 @@ typedef struct
     cust_char_t category_strings[4][33];
 } nodemgmt_user_category_strings_t;
 
+// Service name index entry: key is (parent list id << NODEMGMT_SVC_INDEX_HASH_BITS) | service name hash
+typedef struct
+{
+    uint16_t key;
+    uint16_t parent_address;
+} nodemgmt_service_index_entry_t;
+
+// First letter jump table entry: first parent of the table category whose service name starts with fchar
+typedef struct
+{
+    cust_char_t fchar;
+    uint16_t parent_address;
+} nodemgmt_fletter_table_entry_t;
+
 // Node management handle
 typedef struct
 {
@@ -431,8 +456,12 @@ uint16_t nodemgmt_get_encrypted_data_from_data_node(uint16_t data_child_address,
 uint16_t nodemgmt_get_prev_parent_node_for_cur_category(uint16_t search_start_parent_addr, uint16_t credential_type_id);
 uint16_t nodemgmt_get_next_parent_node_for_cur_category(uint16_t search_start_parent_addr, uint16_t credential_type_id);
 RET_TYPE nodemgmt_create_parent_node(parent_node_t* p, service_type_te type, uint16_t* storedAddress, uint16_t typeId);
+RET_TYPE nodemgmt_service_index_lookup(cust_char_t* name, BOOL data_parent, uint16_t type_id, uint16_t* parent_address);
+RET_TYPE nodemgmt_get_fletter_table(uint16_t credential_type_id, nodemgmt_fletter_table_entry_t** table_pt, uint16_t* nb_entries);
+BOOL nodemgmt_get_change_journal(uint32_t cred_change_number, uint32_t data_change_number, uint16_t** addresses_pt, uint16_t* nb_addresses, BOOL* profile_changed);
 RET_TYPE nodemgmt_store_bluetooth_bonding_information(nodemgmt_bluetooth_bonding_information_t* bonding_information);
 uint16_t nodemgmt_check_for_logins_with_category_in_parent_node(uint16_t start_child_addr, uint16_t category_flags);
+BOOL nodemgmt_parent_node_has_logins_with_category(uint16_t parent_addr, uint16_t start_child_addr, uint16_t category_flags);
 void nodemgmt_read_favorite(uint16_t categoryId, uint16_t favId, uint16_t* parentAddress, uint16_t* childAddress);
 void nodemgmt_read_favorite_for_current_category(uint16_t favId, uint16_t* parentAddress, uint16_t* childAddress);
 void nodemgmt_write_child_node_block_to_flash(uint16_t address, child_node_t* child_node, BOOL write_category);
@@ -495,6 +524,11 @@ void nodemgmt_delete_current_user_from_flash(void);
 uint16_t nodemgmt_get_current_category_flags(void);
 void nodemgmt_store_user_layout(uint16_t layoutId);
 void nodemgmt_trigger_db_ext_changed_actions(void);
+void nodemgmt_service_index_invalidate(void);
+void nodemgmt_category_cache_invalidate(void);
+void nodemgmt_fletter_table_invalidate(void);
+void nodemgmt_restart_change_journal(void);
+void nodemgmt_clear_node_usage_bitmap(void);
 uint16_t nodemgmt_get_user_sec_preferences(void);
 uint32_t nodemgmt_get_cred_change_number(void);
 uint32_t nodemgmt_get_data_change_number(void);
@@ -474,6 +474,282 @@ void sh1122_set_colors_invert(sh1122_descriptor_t* oled_descriptor, BOOL colors_
     }
 }
 
+#ifdef OLED_INTERNAL_FRAME_BUFFER
+/*! \fn     sh1122_reset_area(sh1122_area_t* area)
+*   \brief  Set an area as empty
+*   \param  area    Pointer to the area
+*/
+static void sh1122_reset_area(sh1122_area_t* area)
+{
+    area->x_min = SH1122_OLED_WIDTH;
+    area->y_min = SH1122_OLED_HEIGHT;
+    area->x_max = -1;
+    area->y_max = -1;
+}
+
+/*! \fn     sh1122_merge_area(sh1122_area_t* area, sh1122_area_t* area_to_merge)
+*   \brief  Grow an area so it includes another one
+*   \param  area            Pointer to the area to grow
+*   \param  area_to_merge   Pointer to the area to include
+*/
+static void sh1122_merge_area(sh1122_area_t* area, sh1122_area_t* area_to_merge)
+{
+    if (area_to_merge->x_min < area->x_min) area->x_min = area_to_merge->x_min;
+    if (area_to_merge->y_min < area->y_min) area->y_min = area_to_merge->y_min;
+    if (area_to_merge->x_max > area->x_max) area->x_max = area_to_merge->x_max;
+    if (area_to_merge->y_max > area->y_max) area->y_max = area_to_merge->y_max;
+}
+
+/*! \fn     sh1122_mark_dirty_area(sh1122_descriptor_t* oled_descriptor, int16_t x, int16_t y, int16_t width, int16_t height, BOOL write_to_buffer)
+*   \brief  Mark an area as needing to be sent during the next frame buffer flush
+*   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*   \param  x                   Area X
+*   \param  y                   Area Y
+*   \param  width               Area width
+*   \param  height              Area height
+*   \param  write_to_buffer     Set to something else than FALSE if the frame buffer was written, FALSE if the display was directly written
+*   \note   Areas going over the screen X boundaries are considered full width as pixels may be wrapped around
+*/
+static void sh1122_mark_dirty_area(sh1122_descriptor_t* oled_descriptor, int16_t x, int16_t y, int16_t width, int16_t height, BOOL write_to_buffer)
+{
+    sh1122_area_t area;
+    
+    if ((width <= 0) || (height <= 0))
+    {
+        return;
+    }
+    
+    /* X boundaries */
+    if ((x < 0) || (x + width > SH1122_OLED_WIDTH))
+    {
+        area.x_min = 0;
+        area.x_max = SH1122_OLED_WIDTH-1;
+    }
+    else
+    {
+        area.x_min = x;
+        area.x_max = x + width - 1;
+    }
+    
+    /* Y boundaries */
+    area.y_min = (y < 0)? 0 : y;
+    area.y_max = (y + height > SH1122_OLED_HEIGHT)? SH1122_OLED_HEIGHT-1 : y + height - 1;
+    if (area.y_min > area.y_max)
+    {
+        return;
+    }
+    
+    /* Screen will differ from the frame buffer there, frame buffer may now hold pixels there */
+    sh1122_merge_area(&oled_descriptor->frame_buffer_dirty_area, &area);
+    if (write_to_buffer != FALSE)
+    {
+        sh1122_merge_area(&oled_descriptor->frame_buffer_content_area, &area);
+    }
+}
+
+/*! \fn     sh1122_set_frame_buffer_fully_dirty(sh1122_descriptor_t* oled_descriptor)
+*   \brief  Force the next frame buffer flush to send the complete frame buffer
+*   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*   \note   To be called when writing to the frame buffer without using the sh1122 functions
+*/
+void sh1122_set_frame_buffer_fully_dirty(sh1122_descriptor_t* oled_descriptor)
+{
+    oled_descriptor->frame_buffer_dirty_area.x_min = 0;
+    oled_descriptor->frame_buffer_dirty_area.y_min = 0;
+    oled_descriptor->frame_buffer_dirty_area.x_max = SH1122_OLED_WIDTH-1;
+    oled_descriptor->frame_buffer_dirty_area.y_max = SH1122_OLED_HEIGHT-1;
+    oled_descriptor->frame_buffer_content_area = oled_descriptor->frame_buffer_dirty_area;
+}
+#endif
+
+#if defined(OLED_INTERNAL_FRAME_BUFFER) && defined(OLED_TEXT_RUN_CACHE)
+/*! \fn     sh1122_get_text_run_cache_stats(sh1122_descriptor_t* oled_descriptor, uint32_t* nb_hits, uint32_t* nb_misses)
+*   \brief  Get the text run cache statistics
+*   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*   \param  nb_hits             Where to store the number of runs blitted from the cache
+*   \param  nb_misses           Where to store the number of cacheable runs that had to be rasterized
+*/
+void sh1122_get_text_run_cache_stats(sh1122_descriptor_t* oled_descriptor, uint32_t* nb_hits, uint32_t* nb_misses)
+{
+    *nb_hits = oled_descriptor->text_run_cache.nb_hits;
+    *nb_misses = oled_descriptor->text_run_cache.nb_misses;
+}
+
+/*! \fn     sh1122_text_run_cache_check_run(sh1122_descriptor_t* oled_descriptor, const cust_char_t* string, uint32_t* string_hash, uint16_t* string_length, uint16_t* run_width, uint16_t* run_height)
+*   \brief  Check if a string about to be printed at the current text position can be blitted from / stored in the text run cache
+*   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*   \param  string              Null terminated string
+*   \param  string_hash         Where to store the string hash
+*   \param  string_length       Where to store the string length
+*   \param  run_width           Where to store the run width
+*   \param  run_height          Where to store the run height
+*   \return TRUE if the run is fully displayed, on a single line, and over a blank frame buffer area
+*   \note   The blank area requirement makes a blit give the exact same result as the glyph by glyph draw
+*/
+static BOOL sh1122_text_run_cache_check_run(sh1122_descriptor_t* oled_descriptor, const cust_char_t* string, uint32_t* string_hash, uint16_t* string_length, uint16_t* run_width, uint16_t* run_height)
+{
+    int16_t x = oled_descriptor->cur_text_x;
+    int16_t y = oled_descriptor->cur_text_y;
+    uint16_t glyph_height;
+    uint32_t hash = 2166136261UL;
+    uint16_t length = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    
+    /* Font selected? */
+    if (oled_descriptor->currentFontAddress == 0)
+    {
+        return FALSE;
+    }
+    
+    /* FNV-1a hash, string length, width & height */
+    for (const cust_char_t* str = string; *str != 0; str++)
+    {
+        /* Runs are single lines, short enough to store their string */
+        if ((*str == '\n') || (*str == '\r') || (++length > SH1122_TEXT_RUN_CACHE_MAX_STR_LEN))
+        {
+            return FALSE;
+        }
+        
+        hash = (hash ^ (uint32_t)(*str)) * 16777619UL;
+        width += sh1122_get_glyph_width(oled_descriptor, *str, &glyph_height);
+        if (glyph_height > height)
+        {
+            height = glyph_height;
+        }
+    }
+    
+    /* Run fully displayed? */
+    if ((width == 0) || (height == 0) || (x < 0) || (x < oled_descriptor->min_text_x) || (x + width > oled_descriptor->max_text_x) || (x + width > SH1122_OLED_WIDTH) || (y < 0) || (y < (int16_t)oled_descriptor->min_disp_y) || (y + height > oled_descriptor->max_disp_y) || (y + height > SH1122_OLED_HEIGHT))
+    {
+        return FALSE;
+    }
+    
+    /* Fits in the cache? */
+    uint16_t byte_width = (x + width - 1)/2 - x/2 + 1;
+    if (byte_width * height + length * sizeof(cust_char_t) > SH1122_TEXT_RUN_CACHE_RAM_BUDGET)
+    {
+        return FALSE;
+    }
+    
+    /* Blank destination? */
+    for (uint16_t yind = 0; yind < height; yind++)
+    {
+        for (uint16_t xind = 0; xind < byte_width; xind++)
+        {
+            if (oled_descriptor->frame_buffer[y+yind][x/2+xind] != 0)
+            {
+                return FALSE;
+            }
+        }
+    }
+    
+    *string_hash = hash;
+    *string_length = length;
+    *run_width = width;
+    *run_height = height;
+    return TRUE;
+}
+
+/*! \fn     sh1122_text_run_cache_blit(sh1122_descriptor_t* oled_descriptor, const cust_char_t* string, uint32_t string_hash, uint16_t string_length, uint16_t run_width, uint16_t run_height)
+*   \brief  Blit a cached run at the current text position
+*   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*   \param  string              Null terminated string
+*   \param  string_hash         String hash
+*   \param  string_length       String length
+*   \param  run_width           Run width
+*   \param  run_height          Run height
+*   \return RETURN_OK if the run was in the cache and blitted
+*   \note   The hash only speeds up the lookup: the stored string is compared before any blit
+*/
+static RET_TYPE sh1122_text_run_cache_blit(sh1122_descriptor_t* oled_descriptor, const cust_char_t* string, uint32_t string_hash, uint16_t string_length, uint16_t run_width, uint16_t run_height)
+{
+    int16_t x = oled_descriptor->cur_text_x;
+    int16_t y = oled_descriptor->cur_text_y;
+    
+    for (uint16_t i = 0; i < SH1122_TEXT_RUN_CACHE_NB_ENTRIES; i++)
+    {
+        sh1122_text_run_cache_entry_t* entry_pt = &oled_descriptor->text_run_cache.entries[i];
+        
+        if ((entry_pt->byte_width != 0) && (entry_pt->string_hash == string_hash) && (entry_pt->string_length == string_length) && (entry_pt->font_address == oled_descriptor->currentFontAddress) && (entry_pt->pixel_width == run_width) && (entry_pt->height == run_height) && (entry_pt->x_parity == (x & 0x01)) && (memcmp(&oled_descriptor->text_run_cache.pool[entry_pt->pool_offset + entry_pt->byte_width*entry_pt->height], string, string_length*sizeof(cust_char_t)) == 0))
+        {
+            /* Copy rows */
+            for (uint16_t yind = 0; yind < entry_pt->height; yind++)
+            {
+                memcpy(&oled_descriptor->frame_buffer[y+yind][x/2], &oled_descriptor->text_run_cache.pool[entry_pt->pool_offset + yind*entry_pt->byte_width], entry_pt->byte_width);
+            }
+            sh1122_mark_dirty_area(oled_descriptor, (x/2)*2, y, entry_pt->byte_width*2, entry_pt->height, TRUE);
+            
+            /* Same text position update as a glyph by glyph draw */
+            oled_descriptor->cur_text_x += run_width;
+            oled_descriptor->text_run_cache.nb_hits++;
+            return RETURN_OK;
+        }
+    }
+    
+    oled_descriptor->text_run_cache.nb_misses++;
+    return RETURN_NOK;
+}
+
+/*! \fn     sh1122_text_run_cache_store(sh1122_descriptor_t* oled_descriptor, int16_t x, int16_t y, const cust_char_t* string, uint32_t string_hash, uint16_t string_length, uint16_t run_width, uint16_t run_height)
+*   \brief  Store a run that was just rasterized in the frame buffer
+*   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*   \param  x                   Run X
+*   \param  y                   Run Y
+*   \param  string              Null terminated string
+*   \param  string_hash         String hash
+*   \param  string_length       String length
+*   \param  run_width           Run width
+*   \param  run_height          Run height
+*/
+static void sh1122_text_run_cache_store(sh1122_descriptor_t* oled_descriptor, int16_t x, int16_t y, const cust_char_t* string, uint32_t string_hash, uint16_t string_length, uint16_t run_width, uint16_t run_height)
+{
+    sh1122_text_run_cache_t* cache_pt = &oled_descriptor->text_run_cache;
+    uint8_t byte_width = (x + run_width - 1)/2 - x/2 + 1;
+    uint16_t pixels_size = byte_width * run_height;
+    uint16_t run_size = pixels_size + string_length * sizeof(cust_char_t);
+    
+    /* Pool used as a ring buffer */
+    if (cache_pt->pool_write_offset + run_size > SH1122_TEXT_RUN_CACHE_RAM_BUDGET)
+    {
+        cache_pt->pool_write_offset = 0;
+    }
+    
+    /* Evict runs overlapping the space we're about to use */
+    for (uint16_t i = 0; i < SH1122_TEXT_RUN_CACHE_NB_ENTRIES; i++)
+    {
+        sh1122_text_run_cache_entry_t* entry_pt = &cache_pt->entries[i];
+        
+        if ((entry_pt->byte_width != 0) && (entry_pt->pool_offset < cache_pt->pool_write_offset + run_size) && (cache_pt->pool_write_offset < entry_pt->pool_offset + entry_pt->byte_width*entry_pt->height + entry_pt->string_length*sizeof(cust_char_t)))
+        {
+            entry_pt->byte_width = 0;
+        }
+    }
+    
+    /* Fill entry, replacing the oldest one */
+    sh1122_text_run_cache_entry_t* entry_pt = &cache_pt->entries[cache_pt->next_entry_index];
+    entry_pt->string_hash = string_hash;
+    entry_pt->font_address = oled_descriptor->currentFontAddress;
+    entry_pt->pool_offset = cache_pt->pool_write_offset;
+    entry_pt->pixel_width = run_width;
+    entry_pt->byte_width = byte_width;
+    entry_pt->height = (uint8_t)run_height;
+    entry_pt->x_parity = x & 0x01;
+    entry_pt->string_length = (uint8_t)string_length;
+    
+    /* Copy rows, then the string used to confirm cache hits */
+    for (uint16_t yind = 0; yind < run_height; yind++)
+    {
+        memcpy(&cache_pt->pool[cache_pt->pool_write_offset + yind*byte_width], &oled_descriptor->frame_buffer[y+yind][x/2], byte_width);
+    }
+    memcpy(&cache_pt->pool[cache_pt->pool_write_offset + pixels_size], string, string_length*sizeof(cust_char_t));
+    
+    /* Update ring pointers */
+    cache_pt->pool_write_offset += run_size;
+    cache_pt->next_entry_index = (cache_pt->next_entry_index + 1) % SH1122_TEXT_RUN_CACHE_NB_ENTRIES;
+}
+#endif
+
 /*! \fn     sh1122_fill_screen(sh1122_descriptor_t* oled_descriptor, uint8_t color)
 *   \brief  Fill the sh1122 screen with a given color
 *   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
@@ -497,6 +773,11 @@ void sh1122_fill_screen(sh1122_descriptor_t* oled_descriptor, uint16_t color)
     }   
     sercom_spi_wait_for_transmit_complete(oled_descriptor->sercom_pt);
     sh1122_stop_data_sending(oled_descriptor);
+    
+    #ifdef OLED_INTERNAL_FRAME_BUFFER
+    /* Display doesn't match the frame buffer anymore */
+    sh1122_mark_dirty_area(oled_descriptor, 0, 0, SH1122_OLED_WIDTH, SH1122_OLED_HEIGHT, FALSE);
+    #endif
 }
 
 /*! \fn     sh1122_clear_current_screen(sh1122_descriptor_t* oled_descriptor)
@@ -529,6 +810,10 @@ void sh1122_clear_frame_buffer(sh1122_descriptor_t* oled_descriptor)
 {
     sh1122_check_for_flush_and_terminate(oled_descriptor);
     memset((void*)oled_descriptor->frame_buffer, 0x00, sizeof(oled_descriptor->frame_buffer));
+    
+    /* Only the pixels that were drawn since the last clear changed */
+    sh1122_merge_area(&oled_descriptor->frame_buffer_dirty_area, &oled_descriptor->frame_buffer_content_area);
+    sh1122_reset_area(&oled_descriptor->frame_buffer_content_area);
 }
 
 /*! \fn     sh1122_clear_y_frame_buffer(sh1122_descriptor_t* oled_descriptor)
@@ -546,6 +831,21 @@ void sh1122_clear_y_frame_buffer(sh1122_descriptor_t* oled_descriptor, uint16_t
     
     sh1122_check_for_flush_and_terminate(oled_descriptor);
     memset((void*)&oled_descriptor->frame_buffer[ystart][0], 0x00, (yend-ystart)*SH1122_OLED_WIDTH/2);
+    
+    /* Pixels that may have changed: drawn ones within these rows */
+    sh1122_area_t cleared_area = oled_descriptor->frame_buffer_content_area;
+    if (cleared_area.y_min < (int16_t)ystart)
+    {
+        cleared_area.y_min = ystart;
+    }
+    if (cleared_area.y_max >= (int16_t)yend)
+    {
+        cleared_area.y_max = yend-1;
+    }
+    if ((cleared_area.x_min <= cleared_area.x_max) && (cleared_area.y_min <= cleared_area.y_max))
+    {
+        sh1122_merge_area(&oled_descriptor->frame_buffer_dirty_area, &cleared_area);
+    }
 }
 
 /*! \fn     sh1122_check_for_flush_and_terminate(sh1122_descriptor_t* oled_descriptor)
@@ -603,11 +903,13 @@ void sh1122_flush_frame_buffer_window(sh1122_descriptor_t* oled_descriptor, uint
         height = SH1122_OLED_HEIGHT-y;
     }
     
-    /* Display! */
+    /* Display! Sending the frame buffer to the display doesn't make the area dirty */
+    sh1122_area_t dirty_area = oled_descriptor->frame_buffer_dirty_area;
     for (uint16_t i = y; i < y+height; i++)
     {
         sh1122_display_horizontal_pixel_line(oled_descriptor, x, i, width, &oled_descriptor->frame_buffer[i][x/2], FALSE);
     }
+    oled_descriptor->frame_buffer_dirty_area = dirty_area;
 }
 
 /*! \fn     sh1122_flush_frame_buffer_y_window(sh1122_descriptor_t* oled_descriptor, uint16_t ystart, uint16_t yend)
@@ -655,13 +957,47 @@ void sh1122_flush_frame_buffer_y_window(sh1122_descriptor_t* oled_descriptor, ui
 */
 void sh1122_flush_frame_buffer(sh1122_descriptor_t* oled_descriptor)
 {
+    PROFILING_START(profiling_start);
+    
     /* Wait for a possible ongoing previous flush */
     sh1122_check_for_flush_and_terminate(oled_descriptor);
     
-    if (oled_descriptor->loaded_transition == OLED_TRANS_NONE)
+    /* Area to be sent */
+    sh1122_area_t dirty_area = oled_descriptor->frame_buffer_dirty_area;
+    
+    if ((oled_descriptor->loaded_transition == OLED_TRANS_NONE) && ((dirty_area.x_min > dirty_area.x_max) || (dirty_area.y_min > dirty_area.y_max)))
+    {
+        /* Nothing changed since last flush */
+    }
+    else if ((oled_descriptor->loaded_transition == OLED_TRANS_NONE) && (dirty_area.x_max - dirty_area.x_min < SH1122_NARROW_FLUSH_MAX_WIDTH))
+    {
+        /* Narrow area (icon, digit...): only send the touched columns, row by row */
+        for (int16_t y = dirty_area.y_min; y <= dirty_area.y_max; y++)
+        {
+            /* Set pixel write window */
+            sh1122_set_row_address(oled_descriptor, y);
+            sh1122_set_column_address(oled_descriptor, dirty_area.x_min/2);
+            
+            /* Start filling the SSD1322 RAM */
+            sh1122_start_data_sending(oled_descriptor);
+            
+            /* Send the 2 pixels bytes */
+            for (int16_t x = dirty_area.x_min/2; x <= dirty_area.x_max/2; x++)
+            {
+                sercom_spi_send_single_byte_without_receive_wait(oled_descriptor->sercom_pt, oled_descriptor->frame_buffer[y][x]);
+            }
+            
+            /* Wait for spi buffer to be sent */
+            sercom_spi_wait_for_transmit_complete(oled_descriptor->sercom_pt);
+            
+            /* Stop sending data */
+            sh1122_stop_data_sending(oled_descriptor);
+        }
+    }
+    else if (oled_descriptor->loaded_transition == OLED_TRANS_NONE)
     {        
-        /* Set pixel write window */
-        sh1122_set_row_address(oled_descriptor, 0);
+        /* Set pixel write window: only the touched rows are sent */
+        sh1122_set_row_address(oled_descriptor, dirty_area.y_min);
         sh1122_set_column_address(oled_descriptor, 0);
         
         /* Start filling the SSD1322 RAM */
@@ -669,10 +1005,10 @@ void sh1122_flush_frame_buffer(sh1122_descriptor_t* oled_descriptor)
         
         /* Send buffer! */
         #ifdef OLED_DMA_TRANSFER        
-            dma_oled_init_transfer(oled_descriptor->sercom_pt, (void*)&oled_descriptor->frame_buffer[0][0], sizeof(oled_descriptor->frame_buffer), oled_descriptor->dma_trigger_id);
+            dma_oled_init_transfer(oled_descriptor->sercom_pt, (void*)&oled_descriptor->frame_buffer[dirty_area.y_min][0], (dirty_area.y_max-dirty_area.y_min+1)*SH1122_OLED_WIDTH/2, oled_descriptor->dma_trigger_id);
             oled_descriptor->frame_buffer_flush_in_progress = TRUE;
         #else
-            for (uint32_t y = 0; y < SH1122_OLED_HEIGHT; y++) 
+            for (uint32_t y = dirty_area.y_min; y <= (uint32_t)dirty_area.y_max; y++) 
             {
                 for (uint32_t x = 0; x < SH1122_OLED_WIDTH/2; x++) {
                     sercom_spi_send_single_byte_without_receive_wait(oled_descriptor->sercom_pt, oled_descriptor->frame_buffer[y][x]);
@@ -817,12 +1153,27 @@ void sh1122_flush_frame_buffer(sh1122_descriptor_t* oled_descriptor)
         }
     }
     
-    /* Reset transition */
+    /* Reset transition, display now matches the frame buffer */
     oled_descriptor->loaded_transition = OLED_TRANS_NONE;
+    sh1122_reset_area(&oled_descriptor->frame_buffer_dirty_area);
     emu_oled_flush();
+    PROFILING_STOP(PROFILING_OLED_FLUSH, profiling_start);
 }
 #endif
 
+/*! \fn     sh1122_invalidate_glyph_cache(sh1122_descriptor_t* oled_descriptor)
+*   \brief  Invalidate the glyph metrics cache, to be called when the current font changes
+*   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*/
+static void sh1122_invalidate_glyph_cache(sh1122_descriptor_t* oled_descriptor)
+{
+    #ifdef OLED_GLYPH_METRICS_CACHE
+    memset(oled_descriptor->glyph_cache, 0, sizeof(oled_descriptor->glyph_cache));
+    #else
+    (void)oled_descriptor;
+    #endif
+}
+
 /*! \fn     sh1122_set_emergency_font(void)
 *   \brief  Use the flash-stored emergency font (ascii only)
 *   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
@@ -830,6 +1181,7 @@ void sh1122_flush_frame_buffer(sh1122_descriptor_t* oled_descriptor)
 void sh1122_set_emergency_font(sh1122_descriptor_t* oled_descriptor)
 {
     oled_descriptor->currentFontAddress = CUSTOM_FS_EMERGENCY_FONT_FILE_ADDR;
+    sh1122_invalidate_glyph_cache(oled_descriptor);
     custom_fs_read_from_flash((uint8_t*)&oled_descriptor->current_font_header, oled_descriptor->currentFontAddress, sizeof(oled_descriptor->current_font_header));
     custom_fs_read_from_flash((uint8_t*)&oled_descriptor->current_unicode_inters, oled_descriptor->currentFontAddress + sizeof(oled_descriptor->current_font_header), sizeof(oled_descriptor->current_unicode_inters));
 }
@@ -842,6 +1194,9 @@ void sh1122_set_emergency_font(sh1122_descriptor_t* oled_descriptor)
 */
 RET_TYPE sh1122_refresh_used_font(sh1122_descriptor_t* oled_descriptor, uint16_t font_id)
 {
+    /* Cached glyph metrics belong to the previous font */
+    sh1122_invalidate_glyph_cache(oled_descriptor);
+    
     if (custom_fs_get_file_address(font_id, &oled_descriptor->currentFontAddress, CUSTOM_FS_FONTS_TYPE) != RETURN_OK)
     {
         oled_descriptor->currentFontAddress = 0;
@@ -895,6 +1250,7 @@ void sh1122_init_display(sh1122_descriptor_t* oled_descriptor, BOOL leave_intern
         oled_descriptor->carriage_return_allowed = FALSE;
         oled_descriptor->line_feed_allowed = FALSE;
         oled_descriptor->currentFontAddress = 0;
+        sh1122_invalidate_glyph_cache(oled_descriptor);
         oled_descriptor->max_text_x = SH1122_OLED_WIDTH;
         oled_descriptor->min_text_x = 0;
         oled_descriptor->max_disp_x = SH1122_OLED_WIDTH;
@@ -940,6 +1296,11 @@ void sh1122_init_display(sh1122_descriptor_t* oled_descriptor, BOOL leave_intern
         #ifdef OLED_INTERNAL_FRAME_BUFFER
         memset((void*)oled_descriptor->frame_buffer, 0x00, sizeof(oled_descriptor->frame_buffer));
         oled_descriptor->frame_buffer_flush_in_progress = FALSE;
+        sh1122_reset_area(&oled_descriptor->frame_buffer_dirty_area);
+        sh1122_reset_area(&oled_descriptor->frame_buffer_content_area);
+        #ifdef OLED_TEXT_RUN_CACHE
+        memset((void*)&oled_descriptor->text_run_cache, 0x00, sizeof(oled_descriptor->text_run_cache));
+        #endif
         #endif
     }
     else
@@ -985,6 +1346,8 @@ void sh1122_draw_vertical_line(sh1122_descriptor_t* oled_descriptor, int16_t x,
     ystart = ystart<0?0:ystart;
     
     #ifdef OLED_INTERNAL_FRAME_BUFFER
+    sh1122_mark_dirty_area(oled_descriptor, x, ystart, 1, yend-ystart+1, write_to_buffer);
+    
     if (write_to_buffer != FALSE)
     {
         for (int16_t y=ystart; y<=yend; y++)
@@ -1065,6 +1428,8 @@ void sh1122_display_horizontal_pixel_line(sh1122_descriptor_t* oled_descriptor,
     }
     
 #ifdef OLED_INTERNAL_FRAME_BUFFER
+    sh1122_mark_dirty_area(oled_descriptor, x, y, width, 1, write_to_buffer);
+    
     if (write_to_buffer != FALSE)
     {
         /* Previous pixels in case we are shifted */
@@ -1259,6 +1624,8 @@ void sh1122_draw_rectangle(sh1122_descriptor_t* oled_descriptor, int16_t x, int1
     uint16_t xoff = x - (x / 2) * 2;
 
     #ifdef OLED_INTERNAL_FRAME_BUFFER
+    sh1122_mark_dirty_area(oled_descriptor, x, y, width, height, write_to_buffer);
+    
     if (write_to_buffer != FALSE)
     {
         for (uint16_t yind = 0; yind < height; yind++)
@@ -1381,6 +1748,9 @@ void sh1122_draw_full_screen_image_from_bitstream(sh1122_descriptor_t* oled_desc
     #ifdef OLED_INTERNAL_FRAME_BUFFER
     /* Wait for a possible ongoing previous flush */
     sh1122_check_for_flush_and_terminate(oled_descriptor);
+    
+    /* Display won't match the frame buffer anymore */
+    sh1122_mark_dirty_area(oled_descriptor, 0, 0, SH1122_OLED_WIDTH, SH1122_OLED_HEIGHT, FALSE);
     #endif
 
     /* Set pixel write window */
@@ -1777,124 +2147,18 @@ uint16_t sh1122_get_string_width(sh1122_descriptor_t* oled_descriptor, const cus
     return width;    
 }
 
-/*! \fn     sh1122_get_glyph_width(sh1122_descriptor_t* oled_descriptor, char ch, uint16_t* glyph_height)
-*   \brief  Return the width of the specified character in the current font
+/*! \fn     sh1122_read_glyph_header_from_flash(sh1122_descriptor_t* oled_descriptor, cust_char_t ch, font_glyph_t* glyph)
+*   \brief  Read the glyph header of a given character in the current font, switching to '?' if it isn't supported
 *   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
 *   \param  ch                  Character
-*   \param  glyph_height        Where to store the glyph height (added bonus)
-*   \return width of the glyph
+*   \param  glyph               Where to store the glyph header
+*   \return Glyph index, SH1122_GLYPH_CACHE_UNSUPPORTED if the character can't be displayed
 */
-uint16_t sh1122_get_glyph_width(sh1122_descriptor_t* oled_descriptor, cust_char_t ch, uint16_t* glyph_height)
-{
-    uint16_t glyph_desc_pt_offset = 0;
-    uint16_t interval_start = 0;
-    font_glyph_t glyph;
-    uint16_t gind;
-    
-    /* Set default value */
-    *glyph_height = 0;
-    
-    /* Check that a font was actually chosen */
-    if (oled_descriptor->currentFontAddress != 0)
-    {
-        /* Check that support for this char is described */
-        BOOL char_support_described = FALSE;
-        for (uint16_t i=0; i < sizeof(oled_descriptor->current_unicode_inters)/sizeof(oled_descriptor->current_unicode_inters[0]); i++)
-        {
-            /* Check if char is within this interval */
-            if ((oled_descriptor->current_unicode_inters[i].interval_start != 0xFFFF) && (oled_descriptor->current_unicode_inters[i].interval_start <= ch) && (oled_descriptor->current_unicode_inters[i].interval_end >= ch))
-            {
-                interval_start = oled_descriptor->current_unicode_inters[i].interval_start;
-                char_support_described = TRUE;
-                break;
-            }
-            
-            /* Add offset to descriptor */
-            glyph_desc_pt_offset += oled_descriptor->current_unicode_inters[i].interval_end - oled_descriptor->current_unicode_inters[i].interval_start + 1;
-        }
-        
-        /* Support not described, check if we could switch with ? */
-        if (char_support_described == FALSE)
-        {
-            if (oled_descriptor->question_mark_support_described != FALSE)
-            {
-                interval_start = oled_descriptor->current_unicode_inters[0].interval_start;
-                glyph_desc_pt_offset = 0;
-                ch = '?';
-            } 
-            else
-            {
-                return 0;
-            }
-        }
-        
-        /* Convert character to glyph index */
-        custom_fs_read_from_flash((uint8_t*)&gind, oled_descriptor->currentFontAddress + sizeof(oled_descriptor->current_font_header) + sizeof(oled_descriptor->current_unicode_inters) + glyph_desc_pt_offset*sizeof(gind) + (ch - interval_start)*sizeof(gind), sizeof(gind));
-
-        /* Check that we know this glyph */
-        if(gind == 0xFFFF)
-        {
-            // If we don't know this character, try again with '?'
-            if (oled_descriptor->question_mark_support_described == FALSE)
-            {
-                return 0;
-            }
-            else
-            {
-                ch = '?';
-            }            
-            custom_fs_read_from_flash((uint8_t*)&gind, oled_descriptor->currentFontAddress + sizeof(oled_descriptor->current_font_header) + sizeof(oled_descriptor->current_unicode_inters) + glyph_desc_pt_offset*sizeof(gind) + (ch - interval_start)*sizeof(gind), sizeof(gind));
-            
-            // If we still don't know it, return 0
-            if (gind == 0xFFFF)
-            {
-                return 0;
-            }
-        }
-
-        // Read the beginning of the glyph
-        custom_fs_read_from_flash((uint8_t*)&glyph, oled_descriptor->currentFontAddress + sizeof(oled_descriptor->current_font_header) + sizeof(oled_descriptor->current_unicode_inters) + (oled_descriptor->current_font_header.described_chr_count)*sizeof(gind) + gind*sizeof(glyph), sizeof(glyph));
-
-        if (glyph.glyph_data_offset == 0xFFFFFFFF)
-        {
-            // If there's no glyph data, it is the space!
-            return glyph.xrect + 1;
-        }
-        else
-        {
-            *glyph_height = glyph.yrect + glyph.yoffset;
-            return glyph.xrect + glyph.xoffset + 1;
-        }
-    }
-    else
-    {
-        return 0;
-    }
-}
-
- /*! \fn     sh1122_glyph_draw(sh1122_descriptor_t* oled_descriptor, int16_t x, int16_t y, char ch, BOOL write_to_buffer)
- *   \brief  Draw a character glyph on the screen at x,y.
- *   \param  oled_descriptor    Pointer to a sh1122 descriptor struct
- *   \param  x                  x position to start glyph
- *   \param  y                  y position to start glyph
- *   \param  ch                 Character to draw
- *   \param  write_to_buffer    Set to true to write to internal buffer
- *   \return width of the glyph
- */
-uint16_t sh1122_glyph_draw(sh1122_descriptor_t* oled_descriptor, int16_t x, int16_t y, cust_char_t ch, BOOL write_to_buffer)
+static uint16_t sh1122_read_glyph_header_from_flash(sh1122_descriptor_t* oled_descriptor, cust_char_t ch, font_glyph_t* glyph)
 {
     uint16_t glyph_desc_pt_offset = 0;  // Offset to the pointer of the glyph descriptor
     uint16_t interval_start = 0;        // Unicode code of the first char of the current unicode support interval
-    bitstream_bitmap_t bs;              // Character bitstream
-    uint8_t glyph_width;                // Glyph width
-    font_glyph_t glyph;                 // Glyph header
     uint16_t gind;                      // Glyph index
-
-    /* Check for selected font */
-    if (oled_descriptor->currentFontAddress == 0)
-    {
-        return 0;
-    }
     
     /* Check that support for this char is described */
     BOOL char_support_described = FALSE;
@@ -1923,7 +2187,7 @@ uint16_t sh1122_glyph_draw(sh1122_descriptor_t* oled_descriptor, int16_t x, int1
         }
         else
         {
-            return 0;
+            return SH1122_GLYPH_CACHE_UNSUPPORTED;
         }
     }
     
@@ -1936,7 +2200,7 @@ uint16_t sh1122_glyph_draw(sh1122_descriptor_t* oled_descriptor, int16_t x, int1
         // If we don't know this character, try again with '?'
         if (oled_descriptor->question_mark_support_described == FALSE)
         {
-            return 0;
+            return SH1122_GLYPH_CACHE_UNSUPPORTED;
         }
         else
         {
@@ -1944,15 +2208,112 @@ uint16_t sh1122_glyph_draw(sh1122_descriptor_t* oled_descriptor, int16_t x, int1
         }
         custom_fs_read_from_flash((uint8_t*)&gind, oled_descriptor->currentFontAddress + sizeof(oled_descriptor->current_font_header) + sizeof(oled_descriptor->current_unicode_inters) + glyph_desc_pt_offset*sizeof(gind) + (ch - interval_start)*sizeof(gind), sizeof(gind));
         
-        // If we still don't know it, return 0
+        // If we still don't know it, 0xFFFF is SH1122_GLYPH_CACHE_UNSUPPORTED
         if (gind == 0xFFFF)
         {
-            return 0;
+            return SH1122_GLYPH_CACHE_UNSUPPORTED;
         }
     }
     
-    /* Read glyph data */
-    custom_fs_read_from_flash((uint8_t*)&glyph, oled_descriptor->currentFontAddress + sizeof(oled_descriptor->current_font_header) + sizeof(oled_descriptor->current_unicode_inters) + (oled_descriptor->current_font_header.described_chr_count)*sizeof(gind) + gind*sizeof(glyph), sizeof(glyph));
+    /* Read glyph header */
+    custom_fs_read_from_flash((uint8_t*)glyph, oled_descriptor->currentFontAddress + sizeof(oled_descriptor->current_font_header) + sizeof(oled_descriptor->current_unicode_inters) + (oled_descriptor->current_font_header.described_chr_count)*sizeof(gind) + gind*sizeof(*glyph), sizeof(*glyph));
+    return gind;
+}
+
+/*! \fn     sh1122_get_glyph_header(sh1122_descriptor_t* oled_descriptor, cust_char_t ch, font_glyph_t* glyph)
+*   \brief  Get the glyph header of a given character in the current font, from the glyph metrics cache if possible
+*   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*   \param  ch                  Character
+*   \param  glyph               Where to store the glyph header
+*   \return RETURN_OK if the character (or '?' as a replacement) can be displayed
+*/
+static RET_TYPE sh1122_get_glyph_header(sh1122_descriptor_t* oled_descriptor, cust_char_t ch, font_glyph_t* glyph)
+{
+    /* Check for selected font */
+    if (oled_descriptor->currentFontAddress == 0)
+    {
+        return RETURN_NOK;
+    }
+    
+    #ifdef OLED_GLYPH_METRICS_CACHE
+    /* Direct mapped cache: layout code asks for the same characters over and over */
+    sh1122_glyph_cache_entry_t* cache_entry_pt = &oled_descriptor->glyph_cache[ch & (SH1122_GLYPH_CACHE_NB_ENTRIES-1)];
+    
+    /* Cache miss: fetch metrics from flash */
+    if ((ch == 0) || (cache_entry_pt->code_point != ch))
+    {
+        cache_entry_pt->glyph_index = sh1122_read_glyph_header_from_flash(oled_descriptor, ch, &cache_entry_pt->glyph);
+        cache_entry_pt->code_point = ch;
+    }
+    
+    /* Copy metrics */
+    if (cache_entry_pt->glyph_index == SH1122_GLYPH_CACHE_UNSUPPORTED)
+    {
+        return RETURN_NOK;
+    }
+    *glyph = cache_entry_pt->glyph;
+    return RETURN_OK;
+    #else
+    if (sh1122_read_glyph_header_from_flash(oled_descriptor, ch, glyph) == SH1122_GLYPH_CACHE_UNSUPPORTED)
+    {
+        return RETURN_NOK;
+    }
+    return RETURN_OK;
+    #endif
+}
+
+/*! \fn     sh1122_get_glyph_width(sh1122_descriptor_t* oled_descriptor, char ch, uint16_t* glyph_height)
+*   \brief  Return the width of the specified character in the current font
+*   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*   \param  ch                  Character
+*   \param  glyph_height        Where to store the glyph height (added bonus)
+*   \return width of the glyph
+*/
+uint16_t sh1122_get_glyph_width(sh1122_descriptor_t* oled_descriptor, cust_char_t ch, uint16_t* glyph_height)
+{
+    font_glyph_t glyph;
+    
+    /* Set default value */
+    *glyph_height = 0;
+    
+    /* Fetch glyph metrics */
+    if (sh1122_get_glyph_header(oled_descriptor, ch, &glyph) != RETURN_OK)
+    {
+        return 0;
+    }
+
+    if (glyph.glyph_data_offset == 0xFFFFFFFF)
+    {
+        // If there's no glyph data, it is the space!
+        return glyph.xrect + 1;
+    }
+    else
+    {
+        *glyph_height = glyph.yrect + glyph.yoffset;
+        return glyph.xrect + glyph.xoffset + 1;
+    }
+}
+
+ /*! \fn     sh1122_glyph_draw(sh1122_descriptor_t* oled_descriptor, int16_t x, int16_t y, char ch, BOOL write_to_buffer)
+ *   \brief  Draw a character glyph on the screen at x,y.
+ *   \param  oled_descriptor    Pointer to a sh1122 descriptor struct
+ *   \param  x                  x position to start glyph
+ *   \param  y                  y position to start glyph
+ *   \param  ch                 Character to draw
+ *   \param  write_to_buffer    Set to true to write to internal buffer
+ *   \return width of the glyph
+ */
+uint16_t sh1122_glyph_draw(sh1122_descriptor_t* oled_descriptor, int16_t x, int16_t y, cust_char_t ch, BOOL write_to_buffer)
+{
+    bitstream_bitmap_t bs;              // Character bitstream
+    uint8_t glyph_width;                // Glyph width
+    font_glyph_t glyph;                 // Glyph header
+
+    /* Fetch glyph header */
+    if (sh1122_get_glyph_header(oled_descriptor, ch, &glyph) != RETURN_OK)
+    {
+        return 0;
+    }
 
     if (glyph.glyph_data_offset == 0xFFFFFFFF)
     {
@@ -1968,7 +2329,7 @@ uint16_t sh1122_glyph_draw(sh1122_descriptor_t* oled_descriptor, int16_t x, int1
         y += glyph.yoffset;
         
         /* Compute glyph data address */
-        custom_fs_address_t gaddr = oled_descriptor->currentFontAddress + sizeof(oled_descriptor->current_font_header) + sizeof(oled_descriptor->current_unicode_inters) + (oled_descriptor->current_font_header.described_chr_count)*sizeof(gind) + (oled_descriptor->current_font_header.chr_count)*sizeof(glyph) + glyph.glyph_data_offset;
+        custom_fs_address_t gaddr = oled_descriptor->currentFontAddress + sizeof(oled_descriptor->current_font_header) + sizeof(oled_descriptor->current_unicode_inters) + (oled_descriptor->current_font_header.described_chr_count)*sizeof(uint16_t) + (oled_descriptor->current_font_header.chr_count)*sizeof(glyph) + glyph.glyph_data_offset;
         
         // Initialize bitstream & draw the character
         bitstream_glyph_bitmap_init(&bs, &oled_descriptor->current_font_header, &glyph, gaddr, TRUE);
@@ -2270,9 +2631,35 @@ int16_t sh1122_put_string_xy(sh1122_descriptor_t* oled_descriptor, int16_t x, in
     oled_descriptor->cur_text_y = y;
     oled_descriptor->new_line_x = x;
     
+    #if defined(OLED_INTERNAL_FRAME_BUFFER) && defined(OLED_TEXT_RUN_CACHE)
+    /* Single line strings drawn over a blank area: blit from the text run cache if possible */
+    int16_t run_x = oled_descriptor->cur_text_x;
+    BOOL run_cacheable = FALSE;
+    uint32_t run_hash = 0;
+    uint16_t run_str_length = 0;
+    uint16_t run_width = 0;
+    uint16_t run_height = 0;
+    if (write_to_buffer != FALSE)
+    {
+        run_cacheable = sh1122_text_run_cache_check_run(oled_descriptor, string, &run_hash, &run_str_length, &run_width, &run_height);
+        if ((run_cacheable != FALSE) && (sh1122_text_run_cache_blit(oled_descriptor, string, run_hash, run_str_length, run_width, run_height) == RETURN_OK))
+        {
+            return run_width;
+        }
+    }
+    #endif
+    
     /* Display string */
     int16_t return_val = sh1122_put_string(oled_descriptor, string, write_to_buffer);
     
+    #if defined(OLED_INTERNAL_FRAME_BUFFER) && defined(OLED_TEXT_RUN_CACHE)
+    /* Store the freshly rasterized run */
+    if ((run_cacheable != FALSE) && (return_val == (int16_t)run_width))
+    {
+        sh1122_text_run_cache_store(oled_descriptor, run_x, y, string, run_hash, run_str_length, run_width, run_height);
+    }
+    #endif
+    
     /* Return the number of characters printed */
     return return_val;
 }
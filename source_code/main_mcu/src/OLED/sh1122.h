@@ -63,6 +63,20 @@
 #define SH1122_OLED_HEIGHT          64
 #define SH1122_OLED_BPP             4
 
+/* Glyph metrics cache defines, number of entries must be a power of 2 */
+#define SH1122_GLYPH_CACHE_NB_ENTRIES   32
+#define SH1122_GLYPH_CACHE_UNSUPPORTED  0xFFFF
+
+/* Text run cache defines, RAM budget for the rasterized runs & their strings can be overriden at build time */
+#ifndef SH1122_TEXT_RUN_CACHE_RAM_BUDGET
+    #define SH1122_TEXT_RUN_CACHE_RAM_BUDGET    640
+#endif
+#define SH1122_TEXT_RUN_CACHE_NB_ENTRIES        8
+#define SH1122_TEXT_RUN_CACHE_MAX_STR_LEN       48
+
+/* Dirty area flush: windows up to this width are flushed row by row, larger ones as full rows through DMA */
+#define SH1122_NARROW_FLUSH_MAX_WIDTH   (SH1122_OLED_WIDTH/4)
+
 /* Transition defines */
 #define SH1122_TRANSITION_PIXEL     0x03
 
@@ -86,6 +100,43 @@ typedef struct
     uint8_t pixels;
 } gddram_px_t;
 
+typedef struct
+{
+    int16_t x_min;
+    int16_t y_min;
+    int16_t x_max;
+    int16_t y_max;
+} sh1122_area_t;
+
+typedef struct
+{
+    cust_char_t code_point;                 // Requested character, 0 for an empty entry
+    uint16_t glyph_index;                   // Glyph index, SH1122_GLYPH_CACHE_UNSUPPORTED if the character can't be displayed
+    font_glyph_t glyph;                     // Glyph header
+} sh1122_glyph_cache_entry_t;
+
+typedef struct
+{
+    uint32_t string_hash;                   // Hash of the string contents
+    custom_fs_address_t font_address;       // Font used to rasterize the run
+    uint16_t pool_offset;                   // Offset of the rasterized run in the pool
+    uint16_t pixel_width;                   // Run width in pixels
+    uint8_t byte_width;                     // Run width in frame buffer bytes, 0 for an empty entry
+    uint8_t height;                         // Run height
+    uint8_t x_parity;                       // Start X parity, as a frame buffer byte holds 2 pixels
+    uint8_t string_length;                  // String length, string stored in the pool after the run
+} sh1122_text_run_cache_entry_t;
+
+typedef struct
+{
+    sh1122_text_run_cache_entry_t entries[SH1122_TEXT_RUN_CACHE_NB_ENTRIES];
+    uint8_t pool[SH1122_TEXT_RUN_CACHE_RAM_BUDGET];     // Rasterized runs followed by their strings, used as a ring buffer
+    uint16_t pool_write_offset;                         // Where the next run will be stored
+    uint16_t next_entry_index;                          // Next entry to be replaced
+    uint32_t nb_hits;                                   // Number of runs blitted from the cache
+    uint32_t nb_misses;                                 // Number of cacheable runs that had to be rasterized
+} sh1122_text_run_cache_t;
+
 typedef struct
 {
     Sercom* sercom_pt;
@@ -116,9 +167,17 @@ typedef struct
     int16_t cur_text_y;                                 // Current y for writing text
     BOOL oled_on;                                       // Know if oled is on
     oled_transition_te loaded_transition;               // Loaded transition for full frame switch
+    #ifdef OLED_GLYPH_METRICS_CACHE
+    sh1122_glyph_cache_entry_t glyph_cache[SH1122_GLYPH_CACHE_NB_ENTRIES];
+    #endif
     #ifdef OLED_INTERNAL_FRAME_BUFFER
     uint8_t frame_buffer[SH1122_OLED_HEIGHT][SH1122_OLED_WIDTH/(8/SH1122_OLED_BPP)];
     BOOL frame_buffer_flush_in_progress;
+    sh1122_area_t frame_buffer_dirty_area;              // Area where screen & frame buffer may differ (inclusive, empty when min > max)
+    sh1122_area_t frame_buffer_content_area;            // Area of the frame buffer that may contain non-zero pixels
+    #ifdef OLED_TEXT_RUN_CACHE
+    sh1122_text_run_cache_t text_run_cache;             // Rasterized text runs
+    #endif
     #endif
 } sh1122_descriptor_t;
 
@@ -193,6 +252,10 @@ void sh1122_clear_y_frame_buffer(sh1122_descriptor_t* oled_descriptor, uint16_t
 void sh1122_check_for_flush_and_terminate(sh1122_descriptor_t* oled_descriptor);
 void sh1122_flush_frame_buffer(sh1122_descriptor_t* oled_descriptor);
 void sh1122_clear_frame_buffer(sh1122_descriptor_t* oled_descriptor);
+void sh1122_set_frame_buffer_fully_dirty(sh1122_descriptor_t* oled_descriptor);
+#endif
+#if defined(OLED_INTERNAL_FRAME_BUFFER) && defined(OLED_TEXT_RUN_CACHE)
+void sh1122_get_text_run_cache_stats(sh1122_descriptor_t* oled_descriptor, uint32_t* nb_hits, uint32_t* nb_misses);
 #endif
 
 /* ifdef prototypes */
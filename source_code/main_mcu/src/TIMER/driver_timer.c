@@ -60,6 +60,10 @@ volatile uint32_t timer_fine_adjust = 0;
 #ifdef EMULATOR_BUILD
 uint32_t timer_emulator_fake_rtc_cnt = 0;
 #endif
+#ifdef PROFILING_COUNTERS_ENABLED
+/* Profiling counters */
+volatile profilingCounter_t timer_profiling_counters[PROFILING_NB_COUNTERS];
+#endif
 
 
 #ifndef EMULATOR_BUILD
@@ -687,6 +691,74 @@ uint32_t timer_get_systick(void)
     return sysTick;
 }
 
+/*!	\fn		timer_get_cycle_counter(void)
+*	\brief	Get a free running CPU cycle counter, built from the ms timebase and the TCC0 count
+*   \return The number of cycles since boot, modulo 2^32 (wraps every ~89 seconds)
+*   \note   Only differences between two calls are meaningful
+*/
+uint32_t timer_get_cycle_counter(void)
+{
+#ifndef EMULATOR_BUILD
+    uint32_t nb_ms, tcc_count;
+    
+    do
+    {
+        nb_ms = sysTick;
+        
+        /* Request a read of the TCC0 count */
+        TCC0->CTRLBSET.reg = TCC_CTRLBSET_CMD_READSYNC;
+        while ((TCC0->SYNCBUSY.reg & TCC_SYNCBUSY_COUNT) != 0);
+        tcc_count = TCC0->COUNT.reg;
+        
+        /* Overflow not yet serviced (interrupts disabled): count restarted from 0 */
+        if (((TCC0->INTFLAG.reg & TCC_INTFLAG_OVF) != 0) && (tcc_count < (48000/2)))
+        {
+            nb_ms++;
+        }
+    } while (nb_ms != sysTick);
+    
+    return nb_ms * 48000 + tcc_count;
+#else
+    return emu_get_cycle_counter();
+#endif
+}
+
+#ifdef PROFILING_COUNTERS_ENABLED
+/*!	\fn		timer_profiling_add(profiling_counter_te counter, uint32_t nb_cycles)
+*	\brief	Account a call to a profiled subsystem
+*   \param  counter     Profiling counter
+*   \param  nb_cycles   Number of cycles spent in the call
+*/
+void timer_profiling_add(profiling_counter_te counter, uint32_t nb_cycles)
+{
+    cpu_irq_enter_critical();
+    timer_profiling_counters[counter].nb_calls++;
+    timer_profiling_counters[counter].nb_cycles += nb_cycles;
+    cpu_irq_leave_critical();
+}
+
+/*!	\fn		timer_profiling_get_counters(profilingCounter_t* counters, BOOL reset)
+*	\brief	Get a snapshot of the profiling counters
+*   \param  counters    Where to store the PROFILING_NB_COUNTERS counters
+*   \param  reset       Set to TRUE to reset the counters once read
+*/
+void timer_profiling_get_counters(profilingCounter_t* counters, BOOL reset)
+{
+    cpu_irq_enter_critical();
+    for (uint16_t i = 0; i < PROFILING_NB_COUNTERS; i++)
+    {
+        counters[i].nb_calls = timer_profiling_counters[i].nb_calls;
+        counters[i].nb_cycles = timer_profiling_counters[i].nb_cycles;
+        if (reset != FALSE)
+        {
+            timer_profiling_counters[i].nb_calls = 0;
+            timer_profiling_counters[i].nb_cycles = 0;
+        }
+    }
+    cpu_irq_leave_critical();
+}
+#endif
+
 /*!	\fn		timer_has_timer_expired(timer_id_te uid, BOOL clear)
 *	\brief	Know if a timer expired and clear the flag if so
 *   \param  uid     Unique ID
@@ -706,6 +778,10 @@ timer_flag_te timer_has_timer_expired(timer_id_te uid, BOOL clear)
     }
     else
     {
+        #ifdef EMULATOR_BUILD
+        /* Polling a running timer: let virtual time move forward */
+        emu_idle();
+        #endif
         return TIMER_RUNNING;
     }
 }
@@ -735,6 +811,10 @@ timer_flag_te timer_has_allocated_timer_expired(uint16_t uid, BOOL clear)
     }
     else
     {
+        #ifdef EMULATOR_BUILD
+        /* Polling a running timer: let virtual time move forward */
+        emu_idle();
+        #endif
         return TIMER_RUNNING;
     }
 }
@@ -27,6 +27,7 @@
 
 #include <asf.h>
 #include "defines.h"
+#include "platform_defines.h"
 
 /* Structs */
 typedef struct
@@ -42,6 +43,12 @@ typedef struct
     BOOL allocated;
 } allocatedTimerEntry_t;
 
+typedef struct
+{
+    uint32_t nb_calls;
+    uint64_t nb_cycles;
+} profilingCounter_t;
+
 /* Typedefs */
 typedef RTC_MODE2_CLOCK_Type calendar_t;
 
@@ -59,6 +66,15 @@ typedef enum {  TIMER_WAITING_FUNCT = 0,
                 TIMER_ACC_WATCHDOG = 10,
                 TOTAL_NUMBER_OF_TIMERS} timer_id_te;
 typedef enum {TIMER_EXPIRED = 0, TIMER_RUNNING = 1} timer_flag_te;
+typedef enum {  PROFILING_DBFLASH_READ = 0,
+                PROFILING_DBFLASH_WRITE = 1,
+                PROFILING_DATAFLASH_READ = 2,
+                PROFILING_AES_CTR = 3,
+                PROFILING_ECC_SIGN = 4,
+                PROFILING_OLED_FLUSH = 5,
+                PROFILING_AUX_MCU_TX = 6,
+                PROFILING_AUX_MCU_RX_WAIT = 7,
+                PROFILING_NB_COUNTERS} profiling_counter_te;
     
 /* Macros */
 #ifdef EMULATOR_BUILD
@@ -76,6 +92,16 @@ typedef enum {TIMER_EXPIRED = 0, TIMER_RUNNING = 1} timer_flag_te;
 #define DELAYMS_8M(ms)              DELAYTICKS(US_TO_DLYTICKS_8M(ms*1000))                      //uses 20bytes
 #endif
 
+/* Profiling: cycles spent between start & stop are added to a counter */
+#define PROFILING_CYCLES_PER_SECOND CPU_SPEED_HF
+#ifdef PROFILING_COUNTERS_ENABLED
+#define PROFILING_START(start_var)          uint32_t start_var = timer_get_cycle_counter()
+#define PROFILING_STOP(counter, start_var)  timer_profiling_add(counter, timer_get_cycle_counter() - start_var)
+#else
+#define PROFILING_START(start_var)
+#define PROFILING_STOP(counter, start_var)
+#endif
+
 #define IS_LEAP_YEAR(year)  ((((year) % 4 == 0) && ((year) % 100 != 0)) || ((year) % 400 == 0))
 #define SEC_IN_HOUR         (60 * 60)
 #define SEC_IN_DAY          (24 * SEC_IN_HOUR)
@@ -109,5 +135,8 @@ void timer_initialize_timebase(void);
 uint32_t timer_get_systick(void);
 void timer_delay_ms(uint32_t ms);
 void timer_ms_tick(void);
+void timer_profiling_get_counters(profilingCounter_t* counters, BOOL reset);
+void timer_profiling_add(profiling_counter_te counter, uint32_t nb_cycles);
+uint32_t timer_get_cycle_counter(void);
 
 #endif /* TIMER_H_ */
@@ -140,13 +140,13 @@ void debug_debug_menu(void)
             #endif
             
             /* Item selection */
-            if (selected_item > 19)
+            if (selected_item > 21)
             {
                 selected_item = 0;
             }
             else if (selected_item < 0)
             {
-                selected_item = 19;
+                selected_item = 21;
             }
             
             sh1122_put_string_xy(&plat_oled_descriptor, 0, 0, OLED_ALIGN_CENTER, u"Debug Menu", TRUE);
@@ -180,13 +180,18 @@ void debug_debug_menu(void)
                 sh1122_put_string_xy(&plat_oled_descriptor, 10, 34, OLED_ALIGN_LEFT, u"Functional Test", TRUE);
                 sh1122_put_string_xy(&plat_oled_descriptor, 10, 44, OLED_ALIGN_LEFT, u"Switch Off", TRUE);
             }
-            else
+            else if (selected_item < 20)
             {
                 sh1122_put_string_xy(&plat_oled_descriptor, 10, 14, OLED_ALIGN_LEFT, u"Battery Recondition", TRUE);
                 sh1122_put_string_xy(&plat_oled_descriptor, 10, 24, OLED_ALIGN_LEFT, u"Battery Test", TRUE);
                 sh1122_put_string_xy(&plat_oled_descriptor, 10, 34, OLED_ALIGN_LEFT, u"Stack Usage", TRUE);
                 sh1122_put_string_xy(&plat_oled_descriptor, 10, 44, OLED_ALIGN_LEFT, u"Reset Settings", TRUE);
             }
+            else
+            {
+                sh1122_put_string_xy(&plat_oled_descriptor, 10, 14, OLED_ALIGN_LEFT, u"Bitmap Decode Benchmark", TRUE);
+                sh1122_put_string_xy(&plat_oled_descriptor, 10, 24, OLED_ALIGN_LEFT, u"Keyboard LUT Benchmark", TRUE);
+            }
             
             /* Cursor */
             sh1122_put_string_xy(&plat_oled_descriptor, 0, 14 + (selected_item%4)*10, OLED_ALIGN_LEFT, u"-", TRUE);
@@ -317,6 +322,14 @@ void debug_debug_menu(void)
             {
                 custom_fs_hard_reset_settings();
             }
+            else if (selected_item == 20)
+            {
+                debug_bitmap_decode_benchmark();
+            }
+            else if (selected_item == 21)
+            {
+                debug_keyboard_lut_benchmark();
+            }
             redraw_needed = TRUE;
         }
     }
@@ -596,6 +609,7 @@ void debug_battery_recondition(void)
                     }
                 }
             }
+            sh1122_set_frame_buffer_fully_dirty(&plat_oled_descriptor);
             sh1122_flush_frame_buffer(&plat_oled_descriptor);
         #else
             for (uint16_t i = GUI_ANIMATION_FFRAME_ID; i < GUI_ANIMATION_NBFRAMES; i++)
@@ -1135,6 +1149,13 @@ void debug_debug_screen(void)
             acc_int_nb_interrupts = 0;
         }
          
+        /* Line 1: text run cache */
+        #ifdef OLED_TEXT_RUN_CACHE
+        uint32_t text_run_cache_hits, text_run_cache_misses;
+        sh1122_get_text_run_cache_stats(&plat_oled_descriptor, &text_run_cache_hits, &text_run_cache_misses);
+        sh1122_printf_xy(&plat_oled_descriptor, 0, 0, OLED_ALIGN_LEFT, TRUE, "TXT CACHE: hits %u, misses %u", text_run_cache_hits, text_run_cache_misses);
+        #endif
+        
         /* Line 2: date */
         uint32_t timestamp;
         int32_t fine_adjust_val;
@@ -1975,6 +1996,213 @@ void debug_nimh_charging(void)
     }
 }
 
+/*! \fn     debug_bitmap_decode_benchmark(void)
+*   \brief  Decode all bundle bitmaps for at least a second and report the decoding speed
+*/
+void debug_bitmap_decode_benchmark(void)
+{
+    /* uint32_t array to get a 32-bit aligned pixel buffer */
+    uint32_t pixel_buffer[SH1122_OLED_WIDTH/8];
+    uint32_t nb_decoded_bitmaps = 0;
+    uint32_t nb_decoded_pixels = 0;
+    custom_fs_address_t file_adress;
+    bitstream_bitmap_t bitstream;
+    uint32_t elapsed_ms = 0;
+    uint32_t nb_passes = 0;
+    bitmap_t bitmap;
+
+    /* Print info */
+    sh1122_clear_current_screen(&plat_oled_descriptor);
+    sh1122_printf_xy(&plat_oled_descriptor, 0, 0, OLED_ALIGN_LEFT, FALSE, "Bitmap decode benchmark...");
+    
+    /* Decode all bitmaps until we've spent at least one second doing so */
+    uint32_t start_timestamp = timer_get_systick();
+    while (elapsed_ms < 1000)
+    {
+        for (uint32_t file_id = 0; custom_fs_get_file_address(file_id, &file_adress, CUSTOM_FS_BITMAP_TYPE) == RETURN_OK; file_id++)
+        {
+            /* Read bitmap info data */
+            custom_fs_read_from_flash((uint8_t *)&bitmap, file_adress, sizeof(bitmap));
+            
+            /* Init bitstream */
+            bitstream_bitmap_init(&bitstream, &bitmap, file_adress + sizeof(bitmap), TRUE);
+            
+            /* Decode line by line, as our display functions do */
+            for (uint16_t i = 0; i < bitstream.height; i++)
+            {
+                uint16_t nb_pixels_to_decode = bitstream.width;
+                while (nb_pixels_to_decode != 0)
+                {
+                    uint16_t nb_pixels = (nb_pixels_to_decode > SH1122_OLED_WIDTH)? SH1122_OLED_WIDTH : nb_pixels_to_decode;
+                    bitstream_bitmap_array_read(&bitstream, (uint8_t*)pixel_buffer, nb_pixels);
+                    nb_pixels_to_decode -= nb_pixels;
+                }
+            }
+            nb_decoded_pixels += (uint32_t)bitstream.width * bitstream.height;
+            nb_decoded_bitmaps++;
+            
+            /* Close bitstream */
+            bitstream_bitmap_close(&bitstream);
+        }
+        nb_passes++;
+        elapsed_ms = timer_get_systick() - start_timestamp;
+        
+        /* Empty bundle */
+        if (nb_decoded_bitmaps == 0)
+        {
+            break;
+        }
+    }
+    
+    /* Print results */
+    sh1122_printf_xy(&plat_oled_descriptor, 0, 10, OLED_ALIGN_LEFT, FALSE, "%u passes, %u bitmaps, %u ms", nb_passes, nb_decoded_bitmaps, elapsed_ms);
+    sh1122_printf_xy(&plat_oled_descriptor, 0, 20, OLED_ALIGN_LEFT, FALSE, "%u pixels decoded", nb_decoded_pixels);
+    if (elapsed_ms != 0)
+    {
+        sh1122_printf_xy(&plat_oled_descriptor, 0, 30, OLED_ALIGN_LEFT, FALSE, "%u pixels/s", (uint32_t)(((uint64_t)nb_decoded_pixels * 1000) / elapsed_ms));
+    }
+    
+    /* Check for click to return */
+    while(1)
+    {
+        if (inputs_get_wheel_action(FALSE, FALSE) == WHEEL_ACTION_SHORT_CLICK)
+        {
+            return;
+        }
+    }
+}
+
+#ifdef KEYBOARD_LUT_RAM_CACHE
+/*! \fn     debug_keyboard_lut_benchmark_pass(unicode_interval_desc_t* description_intervals, uint32_t* checksum)
+*   \brief  Convert all the points described by the current USB keyboard layout, by chunks
+*   \param  description_intervals   The layout description intervals
+*   \param  checksum                Where to store a checksum of the generated symbols
+*   \return Number of cycles spent converting
+*/
+static uint32_t debug_keyboard_lut_benchmark_pass(unicode_interval_desc_t* description_intervals, uint32_t* checksum)
+{
+    cust_char_t points[32+1];
+    uint16_t symbols[32+1];
+    uint32_t nb_cycles = 0;
+    uint16_t nb_points = 0;
+    
+    *checksum = 0;
+    for (uint16_t i = 0; i < CUSTOM_FS_KEYB_NB_INT_DESCRIBED; i++)
+    {
+        if (description_intervals[i].interval_start == 0xFFFF)
+        {
+            continue;
+        }
+        for (uint32_t point = description_intervals[i].interval_start; point <= description_intervals[i].interval_end; point++)
+        {
+            points[nb_points++] = (cust_char_t)point;
+            
+            /* Convert full chunks and the last one */
+            if ((nb_points == ARRAY_SIZE(points)-1) || ((point == description_intervals[i].interval_end) && ((i == CUSTOM_FS_KEYB_NB_INT_DESCRIBED-1) || (description_intervals[i+1].interval_start == 0xFFFF))))
+            {
+                points[nb_points] = 0;
+                uint32_t start_cycles = timer_get_cycle_counter();
+                custom_fs_get_keyboard_symbols_for_unicode_string(points, symbols, TRUE);
+                nb_cycles += timer_get_cycle_counter() - start_cycles;
+                for (uint16_t j = 0; j < nb_points; j++)
+                {
+                    *checksum = (*checksum * 31) + symbols[j];
+                }
+                nb_points = 0;
+            }
+        }
+    }
+    
+    return nb_cycles;
+}
+#endif
+
+/*! \fn     debug_keyboard_lut_benchmark(void)
+*   \brief  Convert all the points described by each bundle keyboard layout, reading the LUT from flash then from RAM, and report the conversion speeds
+*/
+void debug_keyboard_lut_benchmark(void)
+{
+#ifdef KEYBOARD_LUT_RAM_CACHE
+    unicode_interval_desc_t description_intervals[CUSTOM_FS_KEYB_NB_INT_DESCRIBED];
+    uint8_t prev_usb_layout_id = custom_fs_get_current_layout_id(TRUE);
+    uint8_t prev_ble_layout_id = custom_fs_get_current_layout_id(FALSE);
+    uint8_t nb_layouts = custom_fs_get_number_of_keyb_layouts();
+    custom_fs_address_t layout_file_addr;
+    uint32_t flash_checksum, cache_checksum;
+    uint32_t nb_cached_layouts = 0;
+    uint32_t nb_mismatches = 0;
+    uint64_t flash_cycles = 0;
+    uint64_t cache_cycles = 0;
+    uint32_t nb_points = 0;
+    
+    /* Print info */
+    sh1122_clear_current_screen(&plat_oled_descriptor);
+    sh1122_printf_xy(&plat_oled_descriptor, 0, 0, OLED_ALIGN_LEFT, FALSE, "Keyboard LUT benchmark...");
+    
+    for (uint8_t layout_id = 0; layout_id < nb_layouts; layout_id++)
+    {
+        /* Load description intervals */
+        if (custom_fs_get_file_address((uint32_t)layout_id, &layout_file_addr, CUSTOM_FS_BINARY_TYPE) != RETURN_OK)
+        {
+            continue;
+        }
+        custom_fs_read_from_flash((uint8_t*)description_intervals, layout_file_addr + CUSTOM_FS_KEYBOARD_DESC_LGTH*sizeof(cust_char_t), sizeof(description_intervals));
+        for (uint16_t i = 0; i < ARRAY_SIZE(description_intervals); i++)
+        {
+            if (description_intervals[i].interval_start != 0xFFFF)
+            {
+                nb_points += description_intervals[i].interval_end - description_intervals[i].interval_start + 1;
+            }
+        }
+        
+        /* Flash reads: both layouts need to be set for the conversion */
+        custom_fs_set_keyboard_lut_cache_enabled(FALSE);
+        custom_fs_set_current_keyboard_id(layout_id, TRUE);
+        custom_fs_set_current_keyboard_id(layout_id, FALSE);
+        flash_cycles += debug_keyboard_lut_benchmark_pass(description_intervals, &flash_checksum);
+        
+        /* RAM cache */
+        custom_fs_set_keyboard_lut_cache_enabled(TRUE);
+        if (custom_fs_is_keyboard_lut_cached(TRUE) != FALSE)
+        {
+            nb_cached_layouts++;
+        }
+        cache_cycles += debug_keyboard_lut_benchmark_pass(description_intervals, &cache_checksum);
+        
+        /* Both should generate the same symbols */
+        if (flash_checksum != cache_checksum)
+        {
+            nb_mismatches++;
+        }
+    }
+    
+    /* Restore layouts */
+    custom_fs_set_current_keyboard_id(prev_usb_layout_id, TRUE);
+    custom_fs_set_current_keyboard_id(prev_ble_layout_id, FALSE);
+    
+    /* Print results */
+    sh1122_printf_xy(&plat_oled_descriptor, 0, 10, OLED_ALIGN_LEFT, FALSE, "%u layouts, %u cached, %u points", nb_layouts, nb_cached_layouts, nb_points);
+    if ((flash_cycles != 0) && (cache_cycles != 0))
+    {
+        sh1122_printf_xy(&plat_oled_descriptor, 0, 20, OLED_ALIGN_LEFT, FALSE, "Flash: %u symbols/s", (uint32_t)(((uint64_t)nb_points * CPU_SPEED_HF) / flash_cycles));
+        sh1122_printf_xy(&plat_oled_descriptor, 0, 30, OLED_ALIGN_LEFT, FALSE, "RAM: %u symbols/s", (uint32_t)(((uint64_t)nb_points * CPU_SPEED_HF) / cache_cycles));
+    }
+    sh1122_printf_xy(&plat_oled_descriptor, 0, 40, OLED_ALIGN_LEFT, FALSE, "%u mismatches", nb_mismatches);
+#else
+    sh1122_clear_current_screen(&plat_oled_descriptor);
+    sh1122_printf_xy(&plat_oled_descriptor, 0, 0, OLED_ALIGN_LEFT, FALSE, "Keyboard LUT cache disabled");
+#endif
+    
+    /* Check for click to return */
+    while(1)
+    {
+        if (inputs_get_wheel_action(FALSE, FALSE) == WHEEL_ACTION_SHORT_CLICK)
+        {
+            return;
+        }
+    }
+}
+
 /*! \fn     debug_stack_info(void)
 *   \brief  Print info about stack usage
 */
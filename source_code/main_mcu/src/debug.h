@@ -30,6 +30,8 @@
 /* Prototypes */
 void debug_array_to_hex_u8string(uint8_t* array, uint8_t* string, uint16_t length);
 void debug_always_bluetooth_enable_and_click_to_send_cred(void);
+void debug_bitmap_decode_benchmark(void);
+void debug_keyboard_lut_benchmark(void);
 void debug_test_pattern_display(void);
 void debug_battery_recondition(void);
 void debug_kickstarter_video(void);
@@ -313,6 +313,9 @@ void main_platform_init(void)
             }                
         }
     }
+    
+    /* Switch to compact frames if the aux MCU supports them */
+    comms_aux_mcu_negotiate_compact_frames();
 #endif
     
     /* If debugger attached, let the aux mcu know it shouldn't use the no comms signal */
@@ -837,6 +840,9 @@ int main(void)
             /* Clear bool */
             logic_device_activity_detected();
             logic_security_clear_management_mode();
+            
+            /* Trigger dedicated actions */
+            nodemgmt_trigger_db_ext_changed_actions();
 
             /* Set next screen */
             gui_dispatcher_set_current_screen(GUI_SCREEN_MAIN_MENU, TRUE, GUI_INTO_MENU_TRANSITION);
@@ -857,6 +863,13 @@ int main(void)
                 #endif             
             }
             
+            /* Aux MCU couldn't type all queued symbols */
+            if (logic_user_get_and_clear_queued_typing_failed_flag() != FALSE)
+            {
+                gui_prompts_display_information_on_screen_and_wait(COULDNT_TYPE_CHARS_TEXT_ID, DISP_MSG_WARNING, FALSE);
+                gui_dispatcher_get_back_to_current_screen();
+            }
+            
             /* RX DMA problem */
             if (comms_aux_mcu_get_and_clear_rx_transfer_already_armed() != FALSE)
             {
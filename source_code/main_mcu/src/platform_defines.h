@@ -425,6 +425,29 @@ typedef struct
 #ifndef BOOTLOADER
     #define OLED_INTERNAL_FRAME_BUFFER
 #endif
+/* Per-subsystem call & cycle counters, fetched over HID */
+#ifndef BOOTLOADER
+    #define PROFILING_COUNTERS_ENABLED
+#endif
+/* Opt-in RAM caches, trading static RAM for fewer flash reads */
+#ifndef BOOTLOADER
+    /* Service name hash index for exact service lookups: 1KB */
+    //#define NODEMGMT_SERVICE_INDEX
+    /* Node slot groups known to be fully used, skipped when looking for free nodes: 60B on the 8Mb chip */
+    //#define NODEMGMT_NODE_USAGE_BITMAP
+    /* Per credential parent category masks, to skip parents without logins in the selected category: 768B */
+    //#define NODEMGMT_CATEGORY_CACHE
+    /* First letter jump table for the credential list: 256B */
+    //#define NODEMGMT_FLETTER_TABLE
+    /* Journal of the nodes changed since the last host sync, for incremental syncs: 146B */
+    //#define NODEMGMT_CHANGE_JOURNAL
+    /* Glyph metrics for the most recently used characters: 384B */
+    //#define OLED_GLYPH_METRICS_CACHE
+    /* Rasterized text runs blitted into the frame buffer, requires OLED_INTERNAL_FRAME_BUFFER: 780B */
+    //#define OLED_TEXT_RUN_CACHE
+    /* RAM copy of the last set keyboard layout LUT: 736B */
+    //#define KEYBOARD_LUT_RAM_CACHE
+#endif
 /* allow printf for the screen */
 //#define OLED_PRINTF_ENABLED
 /* Allow debug USB commands */